@@ -0,0 +1,432 @@
+// Benchmark suite for the risk engine hot paths.
+//
+// Every case runs on synthetic data generated in-process (see
+// synthetic.hpp), so no market data is needed. Each case scales one axis
+// (tickers, scenarios, positions or threads) with the others held at a
+// small base, and results are written as JSON so two releases can be
+// diffed case by case.
+//
+// Usage: bench_risk_engine [--full] [--filter SUBSTR] [--out FILE]
+//                          [--min-time SECONDS] [--tmp DIR]
+
+#include "synthetic.hpp"
+
+#include "cholesky.hpp"
+#include "market_data_history.hpp"
+#include "market_snapshot.hpp"
+#include "monte_carlo.hpp"
+#include "parallel.hpp"
+#include "portfolio.hpp"
+#include "realized_risk.hpp"
+#include "risk_measures.hpp"
+#include "task_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct BenchOptions {
+    bool full = false;
+    std::string filter;
+    std::string out = "bench_results.json";
+    double min_time = 0.3;   ///< seconds of measurement per case
+    std::string tmp = (fs::temp_directory_path() / "risk_engine_bench").string();
+};
+
+struct BenchResult {
+    std::string name;
+    std::vector<std::pair<std::string, double>> params;
+    int iterations = 0;
+    double min_seconds = 0.0;
+    double median_seconds = 0.0;
+    double items = 0.0;       ///< work units per iteration (rows, scenarios, ...)
+};
+
+std::vector<BenchResult> results;
+
+double now_seconds() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Runs `body` repeatedly for at least opt.min_time seconds (at least
+// once, at most 100 times); `setup` runs before each iteration untimed.
+void run_case(const BenchOptions& opt,
+              const std::string& name,
+              std::vector<std::pair<std::string, double>> params,
+              double items,
+              const std::function<void()>& body,
+              const std::function<void()>& setup = {}) {
+    std::string label = name;
+    for (const auto& [k, v] : params) label += " " + k + "=" + std::to_string((long long)v);
+    if (!opt.filter.empty() && label.find(opt.filter) == std::string::npos) return;
+
+    std::vector<double> times;
+    double spent = 0.0;
+    while (times.empty() || (spent < opt.min_time && times.size() < 100)) {
+        if (setup) setup();
+        double t0 = now_seconds();
+        body();
+        double dt = now_seconds() - t0;
+        times.push_back(dt);
+        spent += dt;
+    }
+    std::sort(times.begin(), times.end());
+
+    BenchResult r;
+    r.name = name;
+    r.params = std::move(params);
+    r.iterations = static_cast<int>(times.size());
+    r.min_seconds = times.front();
+    r.median_seconds = times[times.size() / 2];
+    r.items = items;
+    results.push_back(r);
+
+    std::printf("%-56s %6d it  min %12.6f s  median %12.6f s  %14.0f items/s\n",
+                label.c_str(), r.iterations, r.min_seconds, r.median_seconds,
+                items / r.median_seconds);
+    std::fflush(stdout);
+}
+
+void write_json(const BenchOptions& opt) {
+    std::ofstream out(opt.out);
+    if (!out.is_open()) {
+        std::cerr << "Cannot write " << opt.out << "\n";
+        return;
+    }
+
+    std::time_t t = std::time(nullptr);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&t));
+
+    out << "{\n  \"context\": {\"date\": \"" << stamp << "\", \"mode\": \""
+        << (opt.full ? "full" : "quick") << "\", \"hardware_threads\": "
+        << resolve_thread_count(0) << ", \"min_time\": " << opt.min_time
+#ifdef NDEBUG
+        << ", \"assertions\": false"
+#else
+        << ", \"assertions\": true"
+#endif
+        << "},\n  \"benchmarks\": [\n";
+
+    out.precision(9);
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"params\": {";
+        for (std::size_t k = 0; k < r.params.size(); k++)
+            out << (k ? ", " : "") << "\"" << r.params[k].first << "\": " << r.params[k].second;
+        out << "}, \"iterations\": " << r.iterations
+            << ", \"min_seconds\": " << r.min_seconds
+            << ", \"median_seconds\": " << r.median_seconds
+            << ", \"items\": " << r.items
+            << ", \"items_per_second\": " << r.items / r.median_seconds
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// ---------------------------------------------------------------------
+// Cases
+// ---------------------------------------------------------------------
+
+const int HISTORY_DAYS = 756;   // three years of weekdays
+const int LOOKBACK = 252;
+const int HORIZON = 10;
+
+void bench_load_directory(const BenchOptions& opt) {
+    std::vector<int> ticker_axis = opt.full ? std::vector<int>{30, 300, 1000, 5000}
+                                            : std::vector<int>{30, 300};
+    for (int n : ticker_axis) {
+        std::string dir = opt.tmp + "/history_" + std::to_string(n);
+        write_synthetic_directory(make_synthetic_history(n, HISTORY_DAYS), dir);
+
+        std::vector<int> thread_axis = {1};
+        if (n == 300) thread_axis = {1, 2, 4, resolve_thread_count(0)};
+        std::sort(thread_axis.begin(), thread_axis.end());
+        thread_axis.erase(std::unique(thread_axis.begin(), thread_axis.end()), thread_axis.end());
+
+        for (int threads : thread_axis) {
+            run_case(opt, "load_directory", {{"tickers", n}, {"threads", threads}},
+                     double(n) * HISTORY_DAYS, [&] {
+                MarketDataHistory h;
+                h.load_directory(dir, threads);
+            });
+        }
+        fs::remove_all(dir);
+    }
+}
+
+void bench_snapshot_and_cholesky(const BenchOptions& opt) {
+    std::vector<int> ticker_axis = opt.full ? std::vector<int>{30, 300, 1000, 5000}
+                                            : std::vector<int>{30, 300};
+    for (int n : ticker_axis) {
+        MarketDataHistory h = make_synthetic_history(n, LOOKBACK + 20);
+        auto tickers = synthetic_tickers(n);
+        std::string date = h.prices.at(tickers[0]).rbegin()->first;
+
+        run_case(opt, "build_snapshot", {{"tickers", n}}, n, [&] {
+            build_snapshot(h, tickers, date, LOOKBACK);
+        });
+
+        // sample correlations from fewer days than tickers are singular,
+        // so the factorization runs on a model matrix of the same size
+        MarketSnapshot snap = make_synthetic_snapshot(n);
+        run_case(opt, "cholesky", {{"tickers", n}}, n, [&] {
+            auto L = cholesky(snap.corr);
+        });
+    }
+}
+
+// MC compute over one axis at a time; base is 30 tickers, 30 stock rows.
+void bench_monte_carlo(const BenchOptions& opt) {
+    auto run = [&](int n, std::size_t positions, int scenarios) {
+        MarketSnapshot snap = make_synthetic_snapshot(n);
+        Portfolio p = make_synthetic_portfolio(snap.spot, snap.tickers, positions);
+
+        MonteCarloEngine mc(snap, p, HORIZON);
+        run_case(opt, "mc_compute",
+                 {{"tickers", n}, {"positions", (double)positions}, {"scenarios", scenarios}},
+                 scenarios, [&] {
+            double var, es;
+            mc.compute(scenarios, 0.99, var, es);
+        });
+    };
+
+    std::vector<int> scenario_axis = opt.full
+        ? std::vector<int>{1000, 10000, 100000, 1000000, 10000000}
+        : std::vector<int>{1000, 10000, 100000};
+    for (int s : scenario_axis) run(30, 30, s);
+
+    std::vector<int> ticker_axis = opt.full ? std::vector<int>{300, 1000, 5000}
+                                            : std::vector<int>{300};
+    for (int n : ticker_axis) run(n, n, 1000);
+
+    std::vector<std::size_t> position_axis = opt.full
+        ? std::vector<std::size_t>{10, 1000, 100000, 1000000}
+        : std::vector<std::size_t>{10, 1000, 100000};
+    for (std::size_t p : position_axis) run(30, p, 1000);
+}
+
+// Large compute runs on a pinned (NUMA-aware) pool vs. an unpinned one of
+// the same size; 100 tickers so each scenario streams a real L row.
+void bench_mc_pinning(const BenchOptions& opt) {
+    const int n = 100;
+    MarketSnapshot snap = make_synthetic_snapshot(n);
+    Portfolio p = make_synthetic_portfolio(snap.spot, snap.tickers, n);
+    const int threads = resolve_thread_count(0);
+
+    std::vector<int> scenario_axis = opt.full
+        ? std::vector<int>{1000000, 10000000}
+        : std::vector<int>{200000};
+    for (bool pinned : {false, true}) {
+        TaskScheduler sched(threads, pinned);
+        MonteCarloEngine mc(snap, p, HORIZON);
+        mc.set_scheduler(&sched);
+        for (int s : scenario_axis) {
+            run_case(opt, "mc_compute_pool",
+                     {{"scenarios", s}, {"threads", threads}, {"pinned", pinned ? 1 : 0}},
+                     s, [&] {
+                double var, es;
+                mc.compute(s, 0.99, var, es);
+            });
+        }
+    }
+}
+
+// Block-parallel compute vs. the generation/revaluation pipeline on the
+// same thread budget; 100 tickers make shock generation the heavy stage.
+void bench_mc_pipeline(const BenchOptions& opt) {
+    const int n = 100, scenarios = opt.full ? 1000000 : 100000;
+    MarketSnapshot snap = make_synthetic_snapshot(n);
+    Portfolio p = make_synthetic_portfolio(snap.spot, snap.tickers, n);
+    const int threads = resolve_thread_count(0);
+
+    for (bool pipelined : {false, true}) {
+        MonteCarloEngine mc(snap, p, HORIZON);
+        mc.set_threads(threads);
+        McPipelineSpec spec;
+        spec.enabled = pipelined;
+        spec.total_threads = threads;
+        mc.set_pipeline(spec);
+        run_case(opt, "mc_compute_pipeline",
+                 {{"scenarios", scenarios}, {"threads", threads}, {"pipelined", pipelined ? 1 : 0}},
+                 scenarios, [&] {
+            double var, es;
+            mc.compute(scenarios, 0.99, var, es);
+        });
+    }
+}
+
+// 8 vol scales × 2 correlation shifts: one sweep() on common draws vs.
+// recalibrating an engine and resimulating at every grid point.
+void bench_mc_sweep(const BenchOptions& opt) {
+    const int n = 30, scenarios = opt.full ? 100000 : 20000;
+    MarketSnapshot snap = make_synthetic_snapshot(n);
+    Portfolio p = make_synthetic_portfolio(snap.spot, snap.tickers, n);
+    const std::vector<double> vols = {0.8, 0.9, 1.0, 1.1, 1.2, 1.3, 1.4, 1.5};
+    const std::vector<double> corrs = {0.0, 0.3};
+    const int points = static_cast<int>(vols.size() * corrs.size());
+
+    MonteCarloEngine mc(snap, p, HORIZON);
+    run_case(opt, "mc_sweep", {{"tickers", n}, {"scenarios", scenarios}, {"points", points}, {"crn", 1}},
+             double(scenarios) * points, [&] {
+        mc.sweep(vols, corrs, scenarios, 0.99);
+    });
+
+    run_case(opt, "mc_sweep", {{"tickers", n}, {"scenarios", scenarios}, {"points", points}, {"crn", 0}},
+             double(scenarios) * points, [&] {
+        for (double w : corrs) {
+            MarketSnapshot stressed = snap;
+            for (int i = 0; i < n; i++)
+                for (int j = 0; j < n; j++)
+                    if (i != j) stressed.corr[i][j] += w * (1.0 - stressed.corr[i][j]);
+            for (double v : vols) {
+                MarketSnapshot point = stressed;
+                for (auto& s : point.sigma) s *= v;
+                double var, es;
+                MonteCarloEngine(point, p, HORIZON).compute(scenarios, 0.99, var, es);
+            }
+        }
+    });
+}
+
+// Intraday re-VaR on a DJIA-sized book: one ticker or every ticker ticks.
+void bench_update_spots(const BenchOptions& opt) {
+    const int n = 30, scenarios = 10000;
+    MarketSnapshot snap = make_synthetic_snapshot(n);
+    Portfolio p = make_synthetic_portfolio(snap.spot, snap.tickers, n);
+
+    MonteCarloEngine mc(snap, p, HORIZON);
+    double var, es;
+    mc.compute_cached(scenarios, 0.99, var, es);
+
+    for (int moved : {1, n}) {
+        std::unordered_map<std::string, double> spots;
+        double bump = 1.0;
+        run_case(opt, "mc_update_spots", {{"tickers", n}, {"scenarios", scenarios}, {"moved", moved}},
+                 scenarios, [&] {
+            mc.update_spots(spots, 0.99, var, es);
+        }, [&] {
+            // alternate up/down ticks so spots stay near the calibration
+            bump = bump > 1.0 ? 0.999 : 1.001;
+            spots.clear();
+            for (int i = 0; i < moved; i++) spots[snap.tickers[i]] = snap.spot.at(snap.tickers[i]) * bump;
+        });
+    }
+}
+
+void bench_tail_risk(const BenchOptions& opt) {
+    std::vector<int> scenario_axis = opt.full
+        ? std::vector<int>{1000, 100000, 1000000, 10000000}
+        : std::vector<int>{1000, 100000, 1000000};
+    for (int s : scenario_axis) {
+        std::mt19937_64 rng(3);
+        std::normal_distribution<double> norm(0.0, 1000.0);
+        std::vector<double> pnl(s), work;
+        for (auto& x : pnl) x = norm(rng);
+
+        run_case(opt, "tail_risk", {{"scenarios", s}}, s, [&] {
+            double var, es;
+            tail_risk(work.data(), work.size(), 0.99, var, es);
+        }, [&] { work = pnl; });
+    }
+}
+
+void bench_realized_risk(const BenchOptions& opt) {
+    const int n = 30;
+    MarketDataHistory h = make_synthetic_history(n, HISTORY_DAYS);
+    auto tickers = synthetic_tickers(n);
+    std::string date = h.get_past_dates(h.prices.at(tickers[0]).rbegin()->first, 40).back();
+
+    std::vector<std::size_t> position_axis = opt.full
+        ? std::vector<std::size_t>{10, 1000, 10000, 100000}
+        : std::vector<std::size_t>{10, 1000};
+    for (std::size_t positions : position_axis) {
+        Portfolio p = make_synthetic_portfolio(last_closes(h), tickers, positions, 0.0);
+        run_case(opt, "realized_risk", {{"positions", (double)positions}}, positions, [&] {
+            compute_realized_risk(p, h, date, HORIZON);
+        });
+    }
+}
+
+void bench_portfolio_load(const BenchOptions& opt) {
+    const int n = 300;
+    MarketDataHistory h = make_synthetic_history(n, 5);
+    auto tickers = synthetic_tickers(n);
+
+    std::vector<std::size_t> position_axis = opt.full
+        ? std::vector<std::size_t>{1000, 100000, 1000000}
+        : std::vector<std::size_t>{1000, 100000};
+    for (std::size_t positions : position_axis) {
+        std::string file = opt.tmp + "/portfolio_" + std::to_string(positions) + ".csv";
+        make_synthetic_portfolio(last_closes(h), tickers, positions).save(file);
+
+        std::vector<int> thread_axis = {1, resolve_thread_count(0)};
+        std::sort(thread_axis.begin(), thread_axis.end());
+        thread_axis.erase(std::unique(thread_axis.begin(), thread_axis.end()), thread_axis.end());
+        for (int threads : thread_axis) {
+            run_case(opt, "portfolio_load", {{"positions", (double)positions}, {"threads", threads}},
+                     positions, [&] {
+                Portfolio p;
+                p.load(file, threads);
+            });
+        }
+        fs::remove(file);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--full") opt.full = true;
+        else if (a == "--filter" && i + 1 < argc) opt.filter = argv[++i];
+        else if (a == "--out" && i + 1 < argc) opt.out = argv[++i];
+        else if (a == "--min-time" && i + 1 < argc) opt.min_time = std::stod(argv[++i]);
+        else if (a == "--tmp" && i + 1 < argc) opt.tmp = argv[++i];
+        else {
+            std::cerr << "Usage: bench_risk_engine [--full] [--filter SUBSTR] [--out FILE]"
+                         " [--min-time SECONDS] [--tmp DIR]\n";
+            return 1;
+        }
+    }
+
+    try {
+        fs::create_directories(opt.tmp);
+
+        bench_load_directory(opt);
+        bench_snapshot_and_cholesky(opt);
+        bench_monte_carlo(opt);
+        bench_mc_pinning(opt);
+        bench_mc_pipeline(opt);
+        bench_update_spots(opt);
+        bench_mc_sweep(opt);
+        bench_tail_risk(opt);
+        bench_realized_risk(opt);
+        bench_portfolio_load(opt);
+
+        fs::remove_all(opt.tmp);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+
+    write_json(opt);
+    std::cout << "Results written to " << opt.out << "\n";
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "synthetic.hpp"
+#include "trading_day_utils.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+std::vector<std::string> synthetic_tickers(int n_tickers) {
+    std::vector<std::string> out;
+    char buf[16];
+    for (int i = 0; i < n_tickers; i++) {
+        std::snprintf(buf, sizeof(buf), "S%04d", i);
+        out.push_back(buf);
+    }
+    return out;
+}
+
+// Weekdays only: 2010-01-04 was a Monday.
+static std::vector<std::string> weekdays(int n_days) {
+    std::vector<std::string> out;
+    int date = 20100104;
+    for (int k = 0; (int)out.size() < n_days; k++) {
+        if (k % 7 < 5) out.push_back(format_date(date));
+        date = add_calendar_days(date, 1);
+    }
+    return out;
+}
+
+MarketDataHistory make_synthetic_history(int n_tickers, int n_days, std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> norm(0.0, 1.0);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+
+    auto tickers = synthetic_tickers(n_tickers);
+    auto dates = weekdays(n_days);
+
+    std::vector<double> beta(n_tickers), idio(n_tickers), price(n_tickers);
+    for (int i = 0; i < n_tickers; i++) {
+        beta[i] = 0.5 + unif(rng);
+        idio[i] = 0.005 + 0.015 * unif(rng);
+        price[i] = 20.0 + 200.0 * unif(rng);
+    }
+
+    MarketDataHistory h;
+    std::vector<std::map<std::string, double>*> series;
+    for (const auto& t : tickers) series.push_back(&h.prices[t]);
+
+    for (const auto& d : dates) {
+        double market = 0.01 * norm(rng);
+        for (int i = 0; i < n_tickers; i++) {
+            price[i] *= std::exp(0.0002 + beta[i] * market + idio[i] * norm(rng));
+            series[i]->emplace_hint(series[i]->end(), d, price[i]);
+        }
+    }
+    h.rebuild_calendar();
+    return h;
+}
+
+void write_synthetic_directory(const MarketDataHistory& history, const std::string& dir) {
+    fs::create_directories(dir);
+    for (const auto& [ticker, series] : history.prices) {
+        std::ofstream out(fs::path(dir) / (ticker + ".csv"));
+        if (!out.is_open())
+            throw std::runtime_error("Cannot write synthetic history: " + dir);
+        out << "Date,Open,High,Low,Close,Adj Close,Volume\n";
+        for (const auto& [date, close] : series)
+            out << date << ',' << close << ',' << close << ',' << close << ','
+                << close << ',' << close << ",1000000\n";
+    }
+}
+
+MarketSnapshot make_synthetic_snapshot(int n_tickers, std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+
+    MarketSnapshot snap;
+    snap.tickers = synthetic_tickers(n_tickers);
+    std::vector<double> loading(n_tickers);
+    for (int i = 0; i < n_tickers; i++) {
+        snap.spot[snap.tickers[i]] = 20.0 + 200.0 * unif(rng);
+        snap.mu.push_back(0.0002);
+        snap.sigma.push_back(0.01 + 0.02 * unif(rng));
+        loading[i] = 0.3 + 0.5 * unif(rng);   // correlation with the market factor
+    }
+
+    snap.corr.assign(n_tickers, std::vector<double>(n_tickers));
+    for (int i = 0; i < n_tickers; i++)
+        for (int j = 0; j < n_tickers; j++)
+            snap.corr[i][j] = i == j ? 1.0 : loading[i] * loading[j];
+    return snap;
+}
+
+std::unordered_map<std::string, double> last_closes(const MarketDataHistory& history) {
+    std::unordered_map<std::string, double> out;
+    for (const auto& [ticker, series] : history.prices)
+        if (!series.empty()) out[ticker] = series.rbegin()->second;
+    return out;
+}
+
+Portfolio make_synthetic_portfolio(const std::unordered_map<std::string, double>& spot_prices,
+                                   const std::vector<std::string>& tickers,
+                                   std::size_t n_positions,
+                                   double option_share,
+                                   std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    std::uniform_int_distribution<std::size_t> pick(0, tickers.size() - 1);
+
+    Portfolio p;
+    p.instruments.reserve(n_positions);
+    for (std::size_t k = 0; k < n_positions; k++) {
+        // every ticker appears at least once when the book is large enough
+        const std::string& t = k < tickers.size() ? tickers[k] : tickers[pick(rng)];
+        double spot = spot_prices.at(t);
+
+        Instrument& inst = p.add(InstrumentType::STOCK, t, 1 + static_cast<int>(100 * unif(rng)));
+        if (k >= tickers.size() && unif(rng) < option_share) {
+            inst.type = InstrumentType::OPTION;
+            inst.strike = std::round(spot * (0.8 + 0.4 * unif(rng)) * 100.0) / 100.0;
+            inst.maturity = 0.25 * (1 + static_cast<int>(4 * unif(rng)));
+            inst.option_type = unif(rng) < 0.5 ? OptionType::CALL : OptionType::PUT;
+            if (unif(rng) < 0.5) inst.quantity = -inst.quantity;
+        }
+    }
+    return p;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "market_data_history.hpp"
+#include "market_snapshot.hpp"
+#include "portfolio.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Synthetic market data and books for benchmarks.
+ *
+ * Prices follow a one-factor lognormal model (market factor plus
+ * idiosyncratic noise), so correlation matrices are full and positive
+ * definite. Dates are consecutive weekdays starting 2010-01-04.
+ */
+
+/// Ticker names S0000, S0001, ...
+std::vector<std::string> synthetic_tickers(int n_tickers);
+
+/// Daily closes of n_tickers over n_days weekdays.
+MarketDataHistory make_synthetic_history(int n_tickers, int n_days, std::uint64_t seed = 7);
+
+/// Writes a history as one Yahoo-style CSV per ticker into dir.
+void write_synthetic_directory(const MarketDataHistory& history, const std::string& dir);
+
+/**
+ * @brief Calibrated-looking snapshot of n_tickers without any history.
+ *
+ * The correlation matrix follows the same one-factor model, so it stays
+ * positive definite at any size (a sample correlation from fewer days
+ * than tickers would not).
+ */
+MarketSnapshot make_synthetic_snapshot(int n_tickers, std::uint64_t seed = 7);
+
+/// Last close of every ticker.
+std::unordered_map<std::string, double> last_closes(const MarketDataHistory& history);
+
+/**
+ * @brief Random book of n_positions rows over tickers.
+ *
+ * About option_share of the rows are options with strikes within
+ * ±20% of spot.
+ */
+Portfolio make_synthetic_portfolio(const std::unordered_map<std::string, double>& spot,
+                                   const std::vector<std::string>& tickers,
+                                   std::size_t n_positions,
+                                   double option_share = 0.3,
+                                   std::uint64_t seed = 11);
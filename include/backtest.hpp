@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Portfolio;
+class MarketDataHistory;
+
+/**
+ * @brief Parameters of a rolling VaR backtest.
+ *
+ *  - from_date / to_date: range of VaR dates (YYYY-MM-DD, inclusive)
+ *  - lookback_days: calibration window, as in build_snapshot()
+ *  - horizon_days: VaR horizon and realized-loss horizon
+ *  - scenarios / confidence: Monte Carlo settings per date
+ *  - threads: number of worker threads (0 = all threads of the shared scheduler)
+ */
+struct BacktestSpec {
+    std::string from_date;
+    std::string to_date;
+    int lookback_days = 252;
+    int horizon_days = 10;
+    int scenarios = 10000;
+    double confidence = 0.95;
+    int threads = 0;
+};
+
+/**
+ * @brief One backtest date: model VaR/ES against the realized loss.
+ */
+struct BacktestRow {
+    std::string date;
+    double portfolio_value = 0.0;
+    double var = 0.0;            ///< Monte Carlo VaR (positive = loss)
+    double es = 0.0;             ///< Monte Carlo ES (positive = loss)
+    double realized_loss = 0.0;  ///< V(t) - V(t + horizon)
+    bool exception = false;      ///< realized_loss > var
+};
+
+/**
+ * @brief Likelihood-ratio statistic with its chi-square p-value.
+ */
+struct LikelihoodRatio {
+    double lr = 0.0;
+    double p_value = 1.0;
+};
+
+/**
+ * @brief Per-date results and exception statistics of a backtest.
+ */
+struct BacktestResult {
+    std::vector<BacktestRow> rows;
+    std::size_t exceptions = 0;
+    double exception_rate = 0.0;
+    double expected_rate = 0.0;       ///< 1 - confidence
+    LikelihoodRatio kupiec;           ///< unconditional coverage (POF), 1 dof
+    LikelihoodRatio independence;     ///< Christoffersen independence, 1 dof
+    LikelihoodRatio conditional;      ///< Christoffersen conditional coverage, 2 dof
+};
+
+/**
+ * @brief Kupiec proportion-of-failures test.
+ *
+ * @param exceptions Number of VaR exceptions x.
+ * @param observations Number of observations T.
+ * @param expected_rate Expected exception probability p (1 - confidence).
+ */
+LikelihoodRatio kupiec_test(std::size_t exceptions, std::size_t observations,
+                            double expected_rate);
+
+/**
+ * @brief Christoffersen independence test on an exception sequence.
+ */
+LikelihoodRatio christoffersen_independence_test(const std::vector<bool>& hits);
+
+/**
+ * @brief Rolling Monte Carlo VaR backtest.
+ *
+ * For every date t in [from_date, to_date] on which all portfolio
+ * tickers trade (and t + horizon_days exists), calibrates a snapshot
+ * exactly as build_snapshot() does, runs MonteCarloEngine and compares
+ * its VaR with the realized horizon loss of the same positions.
+ *
+ * History is read once into dense columns. Calibration state (running
+ * sums of returns and return products over the lookback window) is
+ * rolled forward from date to date instead of being recomputed; dates
+ * are split into contiguous chunks, one rolling calibrator per chunk,
+ * and the chunks are evaluated in parallel.
+ *
+ * @throws std::runtime_error if the range contains no usable date.
+ */
+BacktestResult run_backtest(const Portfolio& portfolio,
+                            const MarketDataHistory& history,
+                            const BacktestSpec& spec);
+
+/**
+ * @brief Writes the per-date table as CSV
+ *        (date,portfolio_value,var,es,realized_loss,exception).
+ *
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+void write_backtest_csv(const BacktestResult& result, const std::string& file);
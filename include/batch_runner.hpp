@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class MarketDataHistory;
+
+/**
+ * @brief One batch job: a portfolio file valued on one date.
+ */
+struct BatchJob {
+    std::string portfolio;
+    std::string date;
+};
+
+/**
+ * @brief Settings of the pipelined batch runner.
+ *
+ *  - lookback_days / horizon_days / scenarios / confidence: as for a
+ *    single Monte Carlo run
+ *  - queue_capacity: items buffered between two stages (bounds memory)
+ *  - calibration_threads: parallel build_snapshot workers
+ *  - simulation_threads: parallel simulation workers (default 1). Their
+ *    Monte Carlo runs share the TaskScheduler: each worker's engine uses
+ *    an equal part of it, less the calibration workers, so the stage
+ *    never runs more threads than the scheduler has.
+ */
+struct BatchSpec {
+    int lookback_days = 252;
+    int horizon_days = 10;
+    int scenarios = 10000;
+    double confidence = 0.95;
+    std::size_t queue_capacity = 8;
+    int calibration_threads = 1;
+    int simulation_threads = 1;
+};
+
+/**
+ * @brief Result of one job (error is empty on success).
+ */
+struct BatchRow {
+    std::size_t index = 0;       ///< position of the job in the batch
+    std::string portfolio;
+    std::string requested_date;
+    std::string date;            ///< aligned trading date
+    double portfolio_value = 0.0;
+    double var = 0.0;
+    double es = 0.0;
+    std::string error;
+};
+
+/**
+ * @brief Batch results in job order with per-stage busy time.
+ */
+struct BatchResult {
+    std::vector<BatchRow> rows;
+    std::size_t failed = 0;
+    double seconds = 0.0;
+    double load_seconds = 0.0;
+    double calibrate_seconds = 0.0; ///< summed over calibration workers
+    double factorize_seconds = 0.0;
+    double simulate_seconds = 0.0;   ///< summed over simulation workers
+    double write_seconds = 0.0;
+};
+
+/**
+ * @brief Reads jobs from a CSV with lines "portfolio,date".
+ *
+ * A header line (one whose date field is not a date) and blank lines
+ * are skipped.
+ *
+ * @throws std::runtime_error if the file cannot be opened or a line has
+ *         no comma.
+ */
+std::vector<BatchJob> read_batch_jobs(const std::string& file);
+
+/**
+ * @brief Runs Monte Carlo VaR/ES for every job as a pipeline.
+ *
+ * Stages, each on its own thread(s), connected by BoundedQueue:
+ *
+ *   load (portfolio file, date alignment)
+ *     → calibrate (build_snapshot, calibration_threads workers)
+ *     → factorize (cholesky)
+ *     → simulate (MonteCarloEngine, simulation_threads workers on the
+ *       shared scheduler)
+ *     → write (CSV rows as they complete)
+ *
+ * Stages overlap, so throughput approaches that of the slowest stage;
+ * bounded queues make a fast stage wait instead of buffering the batch.
+ * A failing job carries its error through the remaining stages and is
+ * reported in its row. Results are identical to running the jobs one by
+ * one.
+ *
+ * @param out_csv Output file (written incrementally, completion order);
+ *                empty to skip writing.
+ *
+ * @throws std::runtime_error if out_csv cannot be opened.
+ */
+BatchResult run_batch(const MarketDataHistory& history,
+                      const std::vector<BatchJob>& jobs,
+                      const BatchSpec& spec,
+                      const std::string& out_csv);
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Portfolio;
+class MarketDataHistory;
+
+/**
+ * @brief Parameters of the block-bootstrap scenario generator.
+ *
+ *  - lookback_days: window of daily joint returns to resample from
+ *  - horizon_days: scenario horizon (days are drawn in blocks)
+ *  - block_length: consecutive days per resampled block
+ *  - filtered: filtered historical simulation — each day's returns are
+ *    divided by that day's EWMA volatility and multiplied by the
+ *    current one
+ *  - ewma_lambda: EWMA decay for the volatility filter
+ *  - scenarios / confidence: as in MonteCarloEngine::compute
+ *  - seed: base seed; results do not depend on the thread count
+ *  - threads: number of threads (0 = all threads of the shared scheduler)
+ */
+struct BootstrapSpec {
+    int lookback_days = 252;
+    int horizon_days = 10;
+    int block_length = 5;
+    bool filtered = false;
+    double ewma_lambda = 0.94;
+    int scenarios = 10000;
+    double confidence = 0.95;
+    std::uint64_t seed = 42;
+    int threads = 0;
+};
+
+/**
+ * @brief Bootstrap VaR/ES (absolute losses, positive = loss).
+ */
+struct BootstrapResult {
+    double var = 0.0;
+    double es = 0.0;
+    double portfolio_value = 0.0;
+    std::size_t history_days = 0;   ///< daily return vectors in the window
+    std::string snapshot_date;      ///< trading date actually used
+};
+
+/**
+ * @brief Block-bootstrap (optionally filtered) historical VaR/ES.
+ *
+ * Daily joint log-return vectors of the portfolio tickers over the
+ * lookback window are stored once as a contiguous days × assets matrix
+ * together with its running (prefix) sums. A scenario draws random
+ * block start days until horizon_days are covered; the horizon return of
+ * a block is the difference of two prefix-sum rows, so resampling is
+ * purely index-based and no return vector is copied. Terminal prices
+ * S0 × exp(sum) are revalued with PortfolioRevaluer and VaR/ES are taken
+ * with tail_risk(), exactly like MonteCarloEngine — but without any
+ * Cholesky factorization.
+ *
+ * Scenario blocks are generated in parallel, each with its own RNG
+ * stream derived from (seed, block).
+ *
+ * @throws std::runtime_error if the window holds fewer days than one block.
+ */
+BootstrapResult compute_bootstrap_var(
+    const Portfolio& portfolio,
+    const MarketDataHistory& history,
+    const std::string& snapshot_date,
+    const BootstrapSpec& spec);
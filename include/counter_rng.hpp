@@ -0,0 +1,76 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Philox4x32-10 counter-based random number generator.
+ *
+ * A keyed bijection of a 128-bit counter (Salmon et al., "Parallel
+ * random numbers: as easy as 1, 2, 3", SC'11): output block i is
+ * philox(counter = i, key = seed). There is no state to advance, so any
+ * block can be produced directly and blocks can be generated in any
+ * order or in parallel — scenario s of a simulation is a pure function
+ * of (seed, s).
+ *
+ * Counter layout used by the fill functions below:
+ *   ctr = {pair index lo, pair index hi, stream lo, stream hi}
+ * Each block yields two uniforms with 52 random bits (two 32-bit words
+ * each).
+ */
+struct Philox4x32 {
+    using Counter = std::array<std::uint32_t, 4>;
+    using Key = std::array<std::uint32_t, 2>;
+
+    /// Applies the 10-round bijection to one counter.
+    static Counter block(Counter ctr, Key key) {
+        for (int r = 0; r < 10; r++) {
+            std::uint64_t p0 = std::uint64_t(M0) * ctr[0];
+            std::uint64_t p1 = std::uint64_t(M1) * ctr[2];
+            ctr = {std::uint32_t(p1 >> 32) ^ ctr[1] ^ key[0], std::uint32_t(p1),
+                   std::uint32_t(p0 >> 32) ^ ctr[3] ^ key[1], std::uint32_t(p0)};
+            key[0] += W0;
+            key[1] += W1;
+        }
+        return ctr;
+    }
+
+    static Key key(std::uint64_t seed) {
+        return {std::uint32_t(seed), std::uint32_t(seed >> 32)};
+    }
+
+    static constexpr std::uint32_t M0 = 0xD2511F53;
+    static constexpr std::uint32_t M1 = 0xCD9E8D57;
+    static constexpr std::uint32_t W0 = 0x9E3779B9;
+    static constexpr std::uint32_t W1 = 0xBB67AE85;
+};
+
+/**
+ * @brief Fills out[0..n) with uniforms in (0, 1) from one stream.
+ *
+ * out[2j] and out[2j+1] come from counter block j of (seed, stream), so
+ * fill_uniform(seed, stream, out, n) is a prefix of any longer fill.
+ */
+void fill_uniform(std::uint64_t seed, std::uint64_t stream, double* out, std::size_t n);
+
+/**
+ * @brief Fills out[0..n) with standard normals from one stream.
+ *
+ * Box-Muller on the uniform pairs of fill_uniform(): pair j gives
+ * out[2j] = r·cos(θ), out[2j+1] = r·sin(θ). For odd n the last sine is
+ * dropped.
+ */
+void fill_normal(std::uint64_t seed, std::uint64_t stream, double* out, std::size_t n);
+
+/**
+ * @brief Batch form of fill_normal() for consecutive streams.
+ *
+ * Row k of out (length per_stream, row-major) receives
+ * fill_normal(seed, first_stream + k, ·, per_stream), for k < streams.
+ * Uniforms of the whole batch are produced first and the Box-Muller
+ * transform then runs as one flat loop over them. Philox runs on
+ * structure-of-arrays lanes and the transform uses branch-free log and
+ * sincos kernels instead of libm, so both passes vectorize (SSE2 and up).
+ */
+void fill_normal_streams(std::uint64_t seed, std::uint64_t first_stream,
+                         std::size_t streams, std::size_t per_stream, double* out);
@@ -1,5 +1,13 @@
 #pragma once
 #include <string>
+#include <vector>
+
+class MarketDataHistory;
+
+/**
+ * @brief The 30 Dow Jones Industrial Average constituents.
+ */
+const std::vector<std::string>& djia_tickers();
 /**
  * @brief Configuration parameters for automatic DJIA portfolio construction.
  *
@@ -17,11 +25,27 @@ struct DjiaPortfolioSpec {
 };
 
 
+/**
+ * @brief Builds a synthetic Dow Jones (DJIA) stock-only portfolio
+ *        from an already-loaded history.
+ *
+ * Price-weighted, see build_index_portfolios(); spec.history_dir is not
+ * used. If the snapshot date is missing for some constituent, the latest
+ * earlier date with prices for all 30 tickers is used.
+ *
+ * @param history History containing the 30 DJIA tickers.
+ * @param spec Structure describing portfolio generation parameters.
+ *
+ * @return true on success, false if any ticker is missing or the output
+ *         cannot be written (errors are printed to stderr).
+ */
+bool build_djia_portfolio(const MarketDataHistory& history, const DjiaPortfolioSpec& spec);
+
 /**
  * @brief Builds a synthetic Dow Jones (DJIA) stock-only portfolio.
  *
  * The portfolio is constructed using price-weighted DJIA methodology:
- *  - loads historical data for all 30 DJIA tickers,
+ *  - loads historical data for all 30 DJIA tickers from spec.history_dir,
  *  - extracts closing prices on the given snapshot date,
  *  - assigns weights proportional to stock prices,
  *  - allocates total portfolio_value according to weights,
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+class Portfolio;
+class MarketDataHistory;
+
+/**
+ * @brief Parameters of a historical-simulation VaR/ES run.
+ *
+ *  - horizon_days: length of each historical return (trading days)
+ *  - lookback_days: window of trading days before the snapshot from
+ *    which overlapping horizon returns are taken
+ *  - confidence: confidence level (e.g. 0.95, 0.99)
+ *  - threads: number of threads (0 = all threads of the shared scheduler)
+ */
+struct HistoricalVarSpec {
+    int horizon_days = 10;
+    int lookback_days = 252;
+    double confidence = 0.95;
+    int threads = 0;
+};
+
+/**
+ * @brief Result of a historical-simulation run.
+ *
+ * var / es are absolute losses in currency (positive = loss).
+ */
+struct HistoricalVarResult {
+    double var = 0.0;
+    double es = 0.0;
+    double portfolio_value = 0.0;  ///< V0 at the snapshot date
+    std::size_t scenarios = 0;     ///< number of historical scenarios
+    std::string snapshot_date;     ///< trading date actually used
+};
+
+/**
+ * @brief Historical-simulation VaR and ES.
+ *
+ * Every overlapping horizon_days window inside the lookback window
+ * [t0 - lookback_days, t0] is applied to today's positions:
+ *   S_i(scenario) = S_i(t0) × exp(log S_i(t + h) - log S_i(t))
+ * and the portfolio is revalued with PortfolioRevaluer.
+ *
+ * Per-ticker log prices are laid out as contiguous arrays over the dates
+ * on which all portfolio tickers trade, so every horizon return is an
+ * O(1) difference. The scenario set is built in one parallel pass over
+ * scenario blocks.
+ *
+ * @param portfolio Current positions.
+ * @param history Historical price database.
+ * @param snapshot_date Valuation date; aligned to the latest earlier
+ *        date on which every portfolio ticker trades.
+ * @param spec Horizon, window, confidence and threads.
+ *
+ * @return VaR/ES and the number of scenarios used.
+ *
+ * @throws std::runtime_error if a ticker is missing or the window holds
+ *         no complete horizon.
+ */
+HistoricalVarResult compute_historical_var(
+    const Portfolio& portfolio,
+    const MarketDataHistory& history,
+    const std::string& snapshot_date,
+    const HistoricalVarSpec& spec);
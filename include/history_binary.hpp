@@ -0,0 +1,97 @@
+#pragma once
+#include "mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class MarketDataHistory;
+
+/**
+ * @brief Binary history file layout (little-endian, all blocks 8-byte aligned).
+ *
+ *   [HistoryBinaryHeader]
+ *   [calendar block]  n_dates   × int32   union calendar, YYYYMMDD ascending
+ *   [index block]     n_tickers × HistoryBinaryTicker, sorted by name
+ *   [column blocks]   per ticker: count × float64 closes for calendar
+ *                     indices [first_date, first_date + count);
+ *                     days without a quote inside the range are NaN
+ *
+ * The file is designed to be memory-mapped and read in place: a column
+ * is a plain array of doubles and a date lookup is a binary search in
+ * the calendar block.
+ */
+struct HistoryBinaryHeader {
+    char magic[8];              ///< "MCRHIST1"
+    std::uint32_t version;      ///< format version (1)
+    std::uint32_t n_dates;      ///< calendar length
+    std::uint32_t n_tickers;    ///< number of index entries
+    std::uint32_t reserved;
+    std::uint64_t calendar_offset;
+    std::uint64_t index_offset;
+    std::uint64_t data_offset;
+    std::uint64_t file_size;    ///< total size, used to detect truncation
+};
+
+/**
+ * @brief Index entry describing one ticker column.
+ */
+struct HistoryBinaryTicker {
+    char name[24];              ///< NUL-padded ticker symbol
+    std::uint32_t first_date;   ///< calendar index of the first close
+    std::uint32_t count;        ///< number of closes in the column
+    std::uint64_t offset;       ///< byte offset of the column
+};
+
+/**
+ * @brief Read-only, memory-mapped view of a binary history file.
+ */
+class HistoryBinaryFile {
+public:
+    /**
+     * @brief Maps and validates a binary history file.
+     *
+     * @throws std::runtime_error if the file cannot be mapped, has a
+     *         wrong magic/version, or is truncated.
+     */
+    void open(const std::string& path);
+
+    std::size_t n_dates() const { return header->n_dates; }
+    std::size_t n_tickers() const { return header->n_tickers; }
+
+    /// Calendar block (YYYYMMDD, ascending).
+    const std::int32_t* dates() const { return calendar; }
+
+    /// Index entry of the i-th ticker.
+    const HistoryBinaryTicker& ticker(std::size_t i) const { return index[i]; }
+
+    /// Ticker symbol of the i-th entry.
+    std::string ticker_name(std::size_t i) const;
+
+    /// Close column of the i-th ticker (ticker(i).count values).
+    const double* column(std::size_t i) const;
+
+    /// Size of the mapped file in bytes.
+    std::size_t size() const { return file.size(); }
+
+private:
+    MappedFile file;
+    const HistoryBinaryHeader* header = nullptr;
+    const std::int32_t* calendar = nullptr;
+    const HistoryBinaryTicker* index = nullptr;
+};
+
+/**
+ * @brief Writes the contents of a history object as a binary history file.
+ *
+ * @param history Loaded history (e.g. from load_directory(); a mapped
+ *        history is materialized into a copy first).
+ * @param path Output file path.
+ *
+ * @return Number of bytes written.
+ *
+ * @throws std::runtime_error if the file cannot be written, a date is
+ *         not in YYYY-MM-DD format, or a ticker name is longer than 23
+ *         characters.
+ */
+std::size_t write_history_binary(const MarketDataHistory& history, const std::string& path);
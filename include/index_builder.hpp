@@ -0,0 +1,76 @@
+#pragma once
+#include "portfolio.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class MarketDataHistory;
+
+/**
+ * @brief How index constituents are weighted.
+ */
+enum class WeightingScheme {
+    PRICE,   ///< weight ∝ price (DJIA methodology)
+    EQUAL,   ///< same notional in every constituent
+    CUSTOM   ///< user-supplied weights (normalized to sum to 1)
+};
+
+/**
+ * @brief Description of an index-tracking stock portfolio.
+ *
+ *  - universe: constituent tickers (portfolio rows keep this order)
+ *  - weighting: weighting scheme
+ *  - custom_weights: ticker → weight, used with WeightingScheme::CUSTOM;
+ *    constituents without a weight are left out
+ *  - portfolio_value: total notional to allocate
+ */
+struct IndexPortfolioSpec {
+    std::vector<std::string> universe;
+    WeightingScheme weighting = WeightingScheme::PRICE;
+    std::unordered_map<std::string, double> custom_weights;
+    double portfolio_value = 10'000'000;
+};
+
+/**
+ * @brief Portfolio generated for one rebalancing date.
+ */
+struct IndexPortfolio {
+    std::string requested_date; ///< date asked for
+    std::string date;           ///< trading date actually used (≤ requested)
+    Portfolio portfolio;
+};
+
+/**
+ * @brief Parses a weighting scheme name ("price", "equal", "custom").
+ *
+ * @throws std::runtime_error for unknown names.
+ */
+WeightingScheme parse_weighting_scheme(const std::string& name);
+
+/**
+ * @brief Builds index portfolios for many rebalancing dates in one pass.
+ *
+ * Works off the already-loaded history: the universe's closes are laid
+ * out once as dense date-indexed columns (PriceIndex), and every
+ * rebalancing date is then a binary search plus one price read per
+ * constituent. Each date is aligned to the latest earlier date on which
+ * every constituent has a price. Quantities are whole shares:
+ *   quantity = int(portfolio_value * weight / price).
+ *
+ * @param history Loaded price history.
+ * @param spec Universe, weighting and notional.
+ * @param rebalance_dates Dates in YYYY-MM-DD format.
+ * @param threads Number of threads (0 = all threads of the shared scheduler).
+ *
+ * @return One IndexPortfolio per requested date, in the same order.
+ *
+ * @throws std::runtime_error if a constituent is missing in history, a
+ *         date is malformed or precedes all complete dates, or custom
+ *         weights do not sum to a positive number.
+ */
+std::vector<IndexPortfolio> build_index_portfolios(
+    const MarketDataHistory& history,
+    const IndexPortfolioSpec& spec,
+    const std::vector<std::string>& rebalance_dates,
+    int threads = 0);
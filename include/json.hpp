@@ -0,0 +1,74 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Minimal JSON value for line-delimited request / response I/O.
+ *
+ * Supports the full JSON grammar (objects, arrays, strings with escapes,
+ * numbers, booleans, null). Numbers are stored as double. Object keys are
+ * kept sorted, which makes serialization deterministic.
+ */
+class JsonValue {
+public:
+    enum class Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+    JsonValue() = default;
+    JsonValue(bool b) : kind(Type::BOOL), flag(b) {}
+    JsonValue(double n) : kind(Type::NUMBER), number(n) {}
+    JsonValue(int n) : kind(Type::NUMBER), number(n) {}
+    JsonValue(std::size_t n) : kind(Type::NUMBER), number(static_cast<double>(n)) {}
+    JsonValue(const char* s) : kind(Type::STRING), text(s) {}
+    JsonValue(std::string s) : kind(Type::STRING), text(std::move(s)) {}
+
+    static JsonValue array() { JsonValue v; v.kind = Type::ARRAY; return v; }
+    static JsonValue object() { JsonValue v; v.kind = Type::OBJECT; return v; }
+
+    Type type() const { return kind; }
+    bool is_null() const { return kind == Type::NUL; }
+    bool is_number() const { return kind == Type::NUMBER; }
+    bool is_string() const { return kind == Type::STRING; }
+    bool is_array() const { return kind == Type::ARRAY; }
+    bool is_object() const { return kind == Type::OBJECT; }
+
+    /// @throws std::runtime_error on a type mismatch.
+    bool as_bool() const;
+    double as_number() const;
+    const std::string& as_string() const;
+    const std::vector<JsonValue>& as_array() const;
+    const std::map<std::string, JsonValue>& as_object() const;
+
+    /// Object member or nullptr (also for non-objects).
+    const JsonValue* find(const std::string& key) const;
+
+    /// Member access with a default for missing keys.
+    double get(const std::string& key, double fallback) const;
+    std::string get(const std::string& key, const std::string& fallback) const;
+
+    /// Object member (creates it; turns a null value into an object).
+    JsonValue& operator[](const std::string& key);
+    /// Appends to an array (turns a null value into an array).
+    void push_back(JsonValue v);
+
+    /// Compact single-line serialization.
+    std::string dump() const;
+
+private:
+    Type kind = Type::NUL;
+    bool flag = false;
+    double number = 0.0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::map<std::string, JsonValue> members;
+
+    void dump_to(std::string& out) const;
+};
+
+/**
+ * @brief Parses one JSON document.
+ *
+ * @throws std::runtime_error with the byte offset of the first error.
+ */
+JsonValue parse_json(const std::string& text);
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * Used by the history and portfolio loaders to read input files in one
+ * go without copying them through stream buffers. The mapping is shared
+ * with the OS page cache, so several processes reading the same file
+ * share the same physical pages.
+ *
+ * Empty files are valid: data() returns nullptr and size() returns 0.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Maps the given file into memory (read-only).
+     *
+     * Any previously mapped file is released first.
+     *
+     * @param path Path to the file.
+     * @return true on success, false if the file cannot be opened or mapped.
+     */
+    bool open(const std::string& path);
+
+    /// Releases the mapping (no-op if nothing is mapped).
+    void close();
+
+    bool is_open() const { return opened; }
+    const char* data() const { return ptr; }
+    std::size_t size() const { return length; }
+
+private:
+    const char* ptr = nullptr;
+    std::size_t length = 0;
+    bool opened = false;
+};
@@ -1,15 +1,63 @@
 #pragma once
+#include "trading_calendar.hpp"
+
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <map>
 #include <vector>
 
+/**
+ * @brief Statistics reported by the history loaders.
+ */
+struct HistoryLoadStats {
+    std::size_t files = 0;   ///< number of files parsed
+    std::size_t rows = 0;    ///< number of price rows stored
+    std::size_t bytes = 0;   ///< number of bytes read
+    double seconds = 0.0;    ///< wall-clock load time
+
+    // what a HistoryFilter excluded
+    std::size_t files_skipped = 0;  ///< files/columns of unwanted tickers
+    std::size_t rows_skipped = 0;   ///< rows located but outside the date window
+    std::size_t bytes_skipped = 0;  ///< bytes never parsed (skipped files + seeks)
+
+    /// Parsed rows per second of wall-clock time.
+    double rows_per_second() const {
+        return seconds > 0.0 ? rows / seconds : 0.0;
+    }
+};
+
+/**
+ * @brief Restricts what the history loaders read.
+ *
+ * An empty ticker set means "all tickers"; a zero date bound means
+ * "unbounded". Dates are integer keys YYYYMMDD (see parse_date()).
+ */
+struct HistoryFilter {
+    std::unordered_set<std::string> tickers;
+    int from_date = 0;  ///< first date to keep (inclusive)
+    int to_date = 0;    ///< last date to keep (inclusive)
+
+    bool accepts_ticker(const std::string& t) const {
+        return tickers.empty() || tickers.count(t) > 0;
+    }
+    bool accepts_date(int d) const {
+        return (from_date == 0 || d >= from_date) && (to_date == 0 || d <= to_date);
+    }
+};
+
 /**
  * @brief Container for historical daily price data for multiple tickers.
  *
  * Stores:
  *   prices[ticker][date] = close price
  *
+ * or, after load_binary(), the mapped columns of a binary history file,
+ * which the calendar, PriceIndex and get_price() read in place; `prices`
+ * stays empty until materialize_prices() is called.
+ *
  * Provides helper functions for:
  *   - loading CSV files from a directory,
  *   - accessing individual prices,
@@ -29,11 +77,139 @@ public:
      *   Date,Open,High,Low,Close,Adj Close,Volume
      *
      * Ticker name is taken from filename (e.g., AAPL.csv → AAPL).
+     * Only the Date and Close columns are parsed. Files are memory-mapped
+     * and parsed concurrently, one file per task.
+     *
+     * @param path Directory containing historical CSV files.
+     * @param threads Number of parser threads (0 = all threads of the shared scheduler).
+     *
+     * @return Load statistics (files, rows, bytes, rows/second).
+     *
+     * @throws std::runtime_error if a row has a malformed date or close
+     *         price (the message contains file and line number).
+     */
+    HistoryLoadStats load_directory(const std::string& path, int threads = 0);
+
+    /**
+     * @brief Loads only the tickers and date window selected by a filter.
+     *
+     * Files of unwanted tickers are never opened. Rows are expected in
+     * ascending date order (as Yahoo exports them): the loader
+     * binary-searches the mapped file for from_date and stops at the
+     * first row after to_date, so rows outside the window are not parsed.
+     *
+     * @param path Directory containing historical CSV files.
+     * @param filter Tickers and date window to keep.
+     * @param threads Number of parser threads (0 = all threads of the shared scheduler).
+     *
+     * @return Load statistics including what was skipped.
+     */
+    HistoryLoadStats load_directory(const std::string& path,
+                                    const HistoryFilter& filter,
+                                    int threads = 0);
+
+    /**
+     * @brief Loads a binary history file (see history_binary.hpp).
+     *
+     * The file stays memory-mapped for the lifetime of the history and
+     * replaces its contents: the trading calendar is built from the int32
+     * calendar block and the float64 columns (NaN = no price), and
+     * PriceIndex, get_price() and has_ticker() read the columns in place.
+     * No text is parsed and no per-row string or map node is created, so
+     * the pages are shared with other processes through the page cache.
+     * `prices` stays empty; call materialize_prices() for code that walks
+     * the string maps. Use the convert_history tool to build the file
+     * from a CSV directory.
+     *
+     * @param path Path to the binary history file.
+     * @param threads Number of threads scanning the columns
+     *        (0 = all threads of the shared scheduler).
+     *
+     * @return Load statistics (files = 1, rows, bytes of close data read,
+     *         rows/second).
+     *
+     * @throws std::runtime_error if the file is missing or corrupt.
+     */
+    HistoryLoadStats load_binary(const std::string& path, int threads = 0);
+
+    /**
+     * @brief Loads only the tickers and date window selected by a filter
+     *        from a binary history file.
+     *
+     * Unwanted columns and the parts of wanted columns outside the date
+     * window are never touched, so their pages are never faulted in.
+     */
+    HistoryLoadStats load_binary(const std::string& path,
+                                 const HistoryFilter& filter,
+                                 int threads = 0);
+
+    /**
+     * @brief Absorbs rows appended to CSV files since they were loaded.
+     *
+     * For every file read by load_directory() the loader remembers the
+     * byte offset it consumed and the last date it stored. The offset
+     * covers complete lines only and stops before the first row after
+     * to_date, so this call reads exactly the rows not yet seen: a row
+     * that was being written is picked up once it is finished. It stores
+     * rows newer than the last seen date and loads ticker files that
+     * appeared since. A file that shrank is treated as rewritten and is
+     * re-read in full. The ticker set and from_date of the original
+     * filter still apply; to_date does not (updates extend the window).
      *
      * @param path Directory containing historical CSV files.
+     * @param threads Number of parser threads (0 = all threads of the shared scheduler).
+     *
+     * @return Statistics of the update (files read, rows added, bytes read).
+     */
+    HistoryLoadStats append_directory(const std::string& path, int threads = 0);
+
+    /// True while the history is served from a binary file (see load_binary()).
+    bool mapped() const { return mapped_columns != nullptr; }
+
+    /**
+     * @brief Copies a mapped history into `prices` and releases the file.
+     *
+     * For code that walks or edits the string maps; entries already in
+     * `prices` are kept. The CSV loaders call it first, so a mapped
+     * history they extend keeps its data. Does nothing when not mapped.
+     */
+    void materialize_prices();
+
+    /**
+     * @brief Trading calendar of the loaded prices.
+     *
+     * Built by the loaders and updated in place by append_directory().
+     * It is never rebuilt implicitly: call rebuild_calendar() after
+     * modifying `prices` directly. The date queries below and PriceIndex
+     * read this calendar.
+     *
+     * @throws std::runtime_error if the calendar visibly lags `prices`
+     *         (different ticker or row count), or if `prices` was edited
+     *         while the history is mapped. Edits that keep the counts
+     *         cannot be detected.
      */
-    void load_directory(const std::string& path);
+    const TradingCalendar& calendar() const;
 
+    /// Rebuilds the trading calendar from `prices` (materializing a mapped history first).
+    void rebuild_calendar();
+
+    /// Whether the ticker has a price series.
+    bool has_ticker(const std::string& ticker) const;
+
+    /**
+     * @brief Close column of a ticker aligned to calendar().union_dates(),
+     *        NaN on days without a price.
+     *
+     * For a mapped history whose column spans the whole calendar the
+     * result points into the file (kept alive by mapping()); otherwise the
+     * column is assembled in `buf`.
+     *
+     * @throws std::runtime_error if the ticker is unknown.
+     */
+    const double* union_column(const std::string& ticker, std::vector<double>& buf) const;
+
+    /// Owner of the memory union_column() may point into; null when not mapped.
+    std::shared_ptr<const void> mapping() const { return mapped_columns; }
 
     /**
      * @brief Returns the close price for a given ticker and date.
@@ -49,6 +225,7 @@ public:
      * @brief Returns a list of the next horizon_days trading dates
      *        after snapshot_date.
      *
+     * Dates come from the common calendar (days every ticker trades).
      * Used to compute realized (historical) VaR/ES.
      */
 
@@ -58,8 +235,10 @@ public:
     ) const;
 
     /**
-     * @brief Returns a list of lookback_days dates preceding snapshot_date.
+     * @brief Returns a list of lookback_days dates preceding snapshot_date,
+     *        newest first.
      *
+     * Dates come from the common calendar (days every ticker trades).
      * Used to estimate drift, volatility, and correlations.
      */
 
@@ -75,4 +254,18 @@ public:
      */
     std::unordered_map<std::string, std::vector<std::string>> get_all_dates() const;
 
+private:
+    /// Read position of a CSV file, used by append_directory().
+    struct FileCursor {
+        std::size_t offset = 0;  ///< bytes consumed
+        int last_date = 0;       ///< last stored date (YYYYMMDD)
+    };
+
+    /// Binary history file served in place (defined in the .cpp).
+    struct MappedColumns;
+
+    std::unordered_map<std::string, FileCursor> cursors; ///< file path → cursor
+    HistoryFilter load_filter; ///< filter of the last load_directory() call
+    TradingCalendar trading_calendar;
+    std::shared_ptr<const MappedColumns> mapped_columns; ///< set by load_binary()
 };
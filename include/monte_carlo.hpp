@@ -3,10 +3,66 @@
 #include "market_snapshot.hpp"
 #include "portfolio.hpp"
 #include "cholesky.hpp"
+#include "revaluation.hpp"
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <vector>
 #include <string>
-#include <random>   
+#include <unordered_map>
+
+class TaskScheduler;
+class ScenarioFileWriter;
+
+/**
+ * @brief Stage layout of the pipelined compute() (see
+ *        MonteCarloEngine::set_pipeline()).
+ *
+ * Generators draw shocks, correlate them and apply GBM; revaluers price
+ * the portfolio. Each generator/revaluer pair is connected by a
+ * lock-free SPSC ring of scenario chunks. A thread count of 0 is
+ * auto-tuned: a probe of a few hundred scenarios measures the per-scenario
+ * cost of both stages and total_threads is split in that proportion.
+ */
+struct McPipelineSpec {
+    bool enabled = false;
+    int generator_threads = 0;          ///< 0 = auto
+    int revaluation_threads = 0;        ///< 0 = auto
+    int total_threads = 0;              ///< budget for auto (0 = hardware concurrency)
+    std::size_t chunk_scenarios = 256;  ///< scenarios per ring entry (capped at ~256 KB)
+    std::size_t ring_capacity = 8;      ///< chunks in flight per generator/revaluer pair
+};
+
+/// What the last pipelined compute() did.
+struct McPipelineStats {
+    int generator_threads = 0;
+    int revaluation_threads = 0;
+    double generate_seconds = 0.0;    ///< busy time summed over generators
+    double revalue_seconds = 0.0;     ///< busy time summed over revaluers
+    double probe_generate_us = 0.0;   ///< per scenario, 0 if not auto-tuned
+    double probe_revalue_us = 0.0;    ///< per scenario, 0 if not auto-tuned
+};
+
+/**
+ * @brief Per-scenario output of compute() (see
+ *        MonteCarloEngine::set_scenario_output()).
+ */
+struct McScenarioOutput {
+    std::string path;       ///< scenario file to write; empty = none
+    bool prices = false;    ///< add one terminal-price column per ticker
+    bool books = false;     ///< add one P&L column per underlying
+};
+
+/**
+ * @brief One point of a parameter sweep (see MonteCarloEngine::sweep()).
+ */
+struct McSweepPoint {
+    double vol_scale = 1.0;    ///< every σ multiplied by this
+    double corr_shift = 0.0;   ///< off-diagonal ρ moved to ρ + shift·(1 - ρ)
+    double var = 0.0;
+    double es = 0.0;
+};
 
 /**
  * @brief Monte Carlo simulation engine for multi-asset portfolios.
@@ -18,6 +74,23 @@
  *   - computes portfolio-level P&L,
  *   - estimates Value-at-Risk (VaR) and Expected Shortfall (ES).
  *
+ * Scenarios are simulated in blocks of MC_BLOCK on the shared
+ * work-stealing scheduler. Shocks come from the counter-based Philox
+ * generator: scenario s uses stream s of SEED (see counter_rng.hpp), so
+ * results are reproducible, independent of the number of threads, and
+ * any single scenario can be regenerated with scenario_pnl().
+ *
+ * Each block writes its slice of the P&L buffer (first touch, so pages
+ * land on the worker's NUMA node) and keeps only its worst tail_count()
+ * values; the tails are merged at the end.
+ *
+ * The engine keeps no copy of its inputs: binding a snapshot or a
+ * portfolio compiles what the simulation needs (GBM terms, Cholesky
+ * factor, revaluer), and P&L / tail buffers live in one arena sized to
+ * the largest run so far. A long-lived engine rebound per request
+ * (bind_market(), bind_portfolio()) therefore performs no heap
+ * allocation in compute() once warmed up.
+ *
  * Supports stocks and European-style options.
  */
 
@@ -37,6 +110,69 @@ public:
     MonteCarloEngine(const MarketSnapshot& snap,
                      const Portfolio& portfolio,
                      int horizon_days);
+
+    /**
+     * @brief Constructs the engine from an already factorized correlation.
+     *
+     * Lets a caller that keeps calibrations warm (the risk server) skip
+     * the Cholesky step.
+     *
+     * @param cholesky_factor Lower-triangular L with L·Lᵀ = snap.corr.
+     *
+     * @throws std::runtime_error if the factor does not match the snapshot size.
+     */
+    MonteCarloEngine(const MarketSnapshot& snap,
+                     const Portfolio& portfolio,
+                     int horizon_days,
+                     std::vector<std::vector<double>> cholesky_factor);
+
+    /**
+     * @brief Constructs an unbound engine for reuse; bind_market() and
+     *        bind_portfolio() must be called before compute().
+     */
+    explicit MonteCarloEngine(int horizon_days);
+
+    /**
+     * @brief Binds a new calibration, factorizing snap.corr.
+     *
+     * Nothing of snap is referenced afterwards. With the same ticker list
+     * as before the bound portfolio is kept (revalued at the new spots);
+     * otherwise bind_portfolio() must follow.
+     *
+     * @throws std::runtime_error for an empty snapshot or a correlation
+     *         matrix that is not positive definite.
+     */
+    void bind_market(const MarketSnapshot& snap);
+
+    /**
+     * @brief Binds a calibration with an already factorized correlation.
+     *
+     * The factor is used by reference, not copied: it must stay alive and
+     * unchanged while bound (e.g. a warm calibration cache entry).
+     *
+     * @throws std::runtime_error if the factor does not match the snapshot size.
+     */
+    void bind_market(const MarketSnapshot& snap,
+                     const std::vector<std::vector<double>>& cholesky_factor);
+
+    /**
+     * @brief Binds a portfolio against the bound market's tickers.
+     *
+     * @throws std::runtime_error if an instrument has no market data.
+     */
+    void bind_portfolio(const Portfolio& portfolio);
+
+    /**
+     * @brief Grows the workspace for runs of up to @p scenarios, so that
+     *        even the first compute() of that size allocates nothing.
+     */
+    void reserve(int scenarios);
+
+    /// VaR horizon in trading days.
+    int horizon() const { return horizon_days; }
+
+    /// Bytes currently held by the scenario workspace.
+    std::size_t workspace_bytes() const { return workspace.capacity * sizeof(double); }
     
     /**
      * @brief Runs Monte Carlo simulation and computes VaR and ES.
@@ -51,26 +187,222 @@ public:
     void compute(int scenarios, double confidence,
                  double& var_out, double& es_out);
 
+    /**
+     * @brief Threads used by compute() (1 = calling thread only, 0 = all
+     *        threads of the shared TaskScheduler, otherwise at most n of
+     *        them; see parallel_for()).
+     */
+    void set_threads(int n) { threads = n; }
+
+    /**
+     * @brief Runs compute() on a specific scheduler (e.g. a pinned pool)
+     *        instead of the shared one; nullptr restores the default.
+     */
+    void set_scheduler(TaskScheduler* s) { scheduler = s; }
+
+    /**
+     * @brief Runs compute() as a generation → revaluation pipeline.
+     *
+     * Same scenarios and VaR as the block-parallel path (ES up to
+     * summation order). Pays off when one stage dominates — shock
+     * generation for large stock-only universes, revaluation for
+     * option-heavy books — and the stages can overlap on separate cores.
+     * Stage threads are dedicated threads, not scheduler workers.
+     */
+    void set_pipeline(const McPipelineSpec& spec) { pipeline = spec; }
+
+    /// Stage layout and timings of the last pipelined compute().
+    const McPipelineStats& pipeline_stats() const { return last_pipeline; }
+
+    /**
+     * @brief Streams every scenario of compute() to a scenario file
+     *        (scenario_file.hpp).
+     *
+     * Columns: portfolio P&L, then optionally the terminal price of every
+     * ticker and the P&L of every underlying's positions (its "book"; the
+     * books sum to the portfolio P&L). Each block — each chunk when
+     * pipelined — is one row group, written as a single positioned write
+     * by the thread that simulated it.
+     */
+    void set_scenario_output(const McScenarioOutput& spec) { output = spec; }
+
+    /**
+     * @brief Regenerates scenario @p index of compute() on its own.
+     *
+     * Scenario streams are counter-based, so this reproduces exactly the
+     * P&L compute() produced for that index, without simulating the
+     * others — handy for inspecting a tail scenario.
+     *
+     * @param prices_out Optional: receives the terminal prices.
+     * @param shocks_out Optional: receives the independent normal shocks.
+     */
+    double scenario_pnl(std::uint64_t index,
+                        std::vector<double>* prices_out = nullptr,
+                        std::vector<double>* shocks_out = nullptr) const;
+
+    /**
+     * @brief compute(), keeping what an intraday re-VaR needs.
+     *
+     * GBM terminal prices are spot × a per-scenario multiplier, and the
+     * portfolio value is additive over assets. This caches, for the
+     * current calibration, every multiplier M[a][s] and every per-asset
+     * P&L contribution, plus their sum per scenario. Same scenarios as
+     * compute() (equal up to summation rounding).
+     *
+     * Memory: 2 × assets × scenarios doubles.
+     */
+    void compute_cached(int scenarios, double confidence,
+                        double& var_out, double& es_out);
+
+    /**
+     * @brief Moves spots and re-derives VaR/ES from the cached scenarios.
+     *
+     * Only the listed assets' contributions are recomputed (stock-only
+     * assets in one multiply per scenario) and applied to the cached
+     * P&L as deltas; shocks, multipliers and the calibration are reused.
+     * The new spots also become the engine's spots for compute() and
+     * base_value().
+     *
+     * @param spots New spot for some or all tickers.
+     *
+     * @throws std::runtime_error without a prior compute_cached(), or for
+     *         an unknown ticker or a non-positive spot.
+     */
+    void update_spots(const std::unordered_map<std::string, double>& spots,
+                      double confidence, double& var_out, double& es_out);
+
+    /**
+     * @brief VaR/ES surface over volatility and correlation stresses with
+     *        common random numbers.
+     *
+     * Every grid point uses the independent normals of compute(),
+     * regenerated per block from the same Philox streams, so differences
+     * between points reflect the parameters rather than sampling noise.
+     * The correlation matrix is recovered from the bound factor (L·Lᵀ),
+     * shifted towards one and refactorized once per corr_shift; a
+     * vol_scale only rescales the GBM drift and diffusion (μ unchanged),
+     * so a block's correlated shocks are shared by every vol_scale. All
+     * (corr, block) pairs run in parallel.
+     *
+     * The point (1, 0) reproduces compute() exactly.
+     *
+     * Memory: one block of scratch per thread plus, as in compute(), the
+     * worst tail_count() P&Ls of each block for every grid point.
+     *
+     * @param vol_scales Positive σ multipliers (e.g. 0.8 … 1.5).
+     * @param corr_shifts Shifts in [0, 1); 0 keeps the calibrated matrix.
+     *
+     * @return One point per (corr_shift, vol_scale), corr_shift-major.
+     *
+     * @throws std::runtime_error for an empty grid, a parameter out of
+     *         range, or a shifted matrix that is not positive definite.
+     */
+    std::vector<McSweepPoint> sweep(const std::vector<double>& vol_scales,
+                                    const std::vector<double>& corr_shifts,
+                                    int scenarios, double confidence);
+
+    /// Portfolio value at the snapshot spot prices.
+    double base_value() const { return bound_revaluer().base_value(); }
+
+    /// Net positions valued per scenario (rows after netting).
+    std::size_t position_count() const { return bound_revaluer().position_count(); }
+
+    /**
+     * @brief Values option books through per-underlying grids.
+     *
+     * See PortfolioRevaluer::enable_option_grid().
+     *
+     * @return Largest interpolation error found by the grid check.
+     */
+    double enable_option_grid(std::size_t min_options = 2, double tolerance = 1e-9) {
+        cached_scenarios = 0;   // contributions were priced without the grid
+        bound_revaluer();
+        return revaluer->enable_option_grid(min_options, tolerance);
+    }
+
 private:
-    MarketSnapshot snapshot; ///< calibrated market data
-    Portfolio portfolio;  ///< list of instruments
     int horizon_days;  ///< VaR horizon in days
+    int threads = 0;   ///< see set_threads()
+    TaskScheduler* scheduler = nullptr;   ///< see set_scheduler()
+    McPipelineSpec pipeline;               ///< see set_pipeline()
+    McPipelineStats last_pipeline;
+    McScenarioOutput output;               ///< see set_scenario_output()
+    std::vector<double> book_base;         ///< per-asset value at spot, for book columns
+
+    static constexpr std::size_t MC_BLOCK = 1024;    ///< scenarios per task
+    static constexpr std::size_t SHOCK_BATCH = 64;   ///< scenarios per fill_normal_streams()
+    static constexpr std::uint64_t SEED = 42;        ///< Philox key of all streams
+
+    std::vector<std::string> tickers;                   ///< bound asset order
+    std::vector<std::vector<double>> own_factor;        ///< factor computed by bind_market()
+    const std::vector<std::vector<double>>* L = nullptr; ///< bound Cholesky factor
+    std::optional<PortfolioRevaluer> revaluer;  ///< positions compiled against tickers
+
+    // per-asset GBM terms over the horizon, rebuilt by bind_market()
+    std::vector<double> spot0;      ///< S0
+    std::vector<double> drift;      ///< (mu - sigma²/2)·dt
+    std::vector<double> diffusion;  ///< sigma·sqrt(dt)
+    std::unordered_map<std::string, std::size_t> ticker_index;
+
+    // compute_cached() state, asset-major: [a * cached_scenarios + s]
+    std::size_t cached_scenarios = 0;
+    std::vector<double> cached_mult;      ///< S'/S per asset and scenario
+    std::vector<double> cached_contrib;   ///< P&L contribution per asset and scenario
+    std::vector<double> cached_pnl;       ///< scenario P&L = Σ contributions
+    std::vector<double> tail_work;        ///< scratch copy for tail_risk()
+    std::vector<double> cached_base;      ///< asset values at spot
 
-    std::vector<std::vector<double>> L; // Cholesky matrix
-    
     /**
-     * @brief Builds Cholesky matrix L from correlation matrix.
+     * @brief compute() buffers in one arena, grown to the largest run.
      *
-     * Throws if the correlation matrix is not positive definite.
+     * Left uninitialized on growth so block workers touch their slices
+     * first. Shock and price scratch is per thread (see compute()).
      */
-    void build_cholesky();
+    struct Workspace {
+        std::unique_ptr<double[]> arena;
+        std::size_t capacity = 0;   ///< doubles in arena
+
+        /// Ensures room for `doubles` values; returns the arena.
+        double* reserve(std::size_t doubles);
+    };
+    Workspace workspace;
+
+    /// Throws unless a market and a portfolio are bound.
+    const PortfolioRevaluer& bound_revaluer() const;
+
+    /// Binds tickers / spots / GBM terms; keeps the portfolio if possible.
+    void bind_terms(const MarketSnapshot& snap);
+    
     
     /**
-     * @brief Simulates a single correlated GBM scenario and computes P&L.
+     * @brief P&L of one correlated GBM scenario from its shocks.
      *
-     * @param rng Reference to random number generator.
+     * @param z Independent standard normal shocks (n assets).
+     * @param prices Scratch buffer for terminal prices (n assets).
      *
      * @return Scenario P&L (positive = profit, negative = loss).
      */
-    double simulate_once(std::mt19937_64& rng);
+    double scenario_from_shocks(const double* z, double* prices) const;
+
+    /// compute() through the stage pipeline (mc_pipeline.cpp).
+    void compute_pipelined(std::size_t total, double confidence,
+                           double& var_out, double& es_out);
+
+    /// Creates the scenario file of a compute() run (none if output.path is empty).
+    std::unique_ptr<ScenarioFileWriter> open_output(std::size_t total, std::size_t group_rows);
+
+    /// Columns per scenario in the scenario file.
+    std::size_t output_columns() const;
+
+    /// Stores scenario k of a row group of `rows` (column after column).
+    void output_row(const double* prices, double pnl, std::size_t k,
+                    std::size_t rows, double* group) const;
+
+    /// Terminal prices of scenarios [first, first + count) into prices
+    /// (row-major, count × assets); z is SHOCK_BATCH × assets scratch.
+    void generate_prices(std::size_t first, std::size_t count,
+                         double* z, double* prices) const;
+
+    /// Terminal price multipliers exp(drift + diffusion·(L z)) of one scenario.
+    void scenario_multipliers(const double* z, double* mult) const;
 };
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief Resolves a user-supplied thread count.
+ *
+ * @param requested Requested number of threads (0 or negative = auto).
+ *
+ * @return requested if positive, otherwise the hardware concurrency
+ *         (at least 1).
+ */
+int resolve_thread_count(int requested);
+
+/**
+ * @brief Runs body(i) for every i in [0, count) in parallel.
+ *
+ * Work is submitted to the shared work-stealing TaskScheduler, so
+ * uneven work items (e.g. files of different size) are balanced and
+ * nested calls (a parallel batch whose jobs run parallel simulations)
+ * share one set of threads. The call returns once every index has been
+ * processed.
+ *
+ * @param count Number of work items.
+ * @param threads Maximum number of items processed at once. 1 runs the
+ *        items inline on the calling thread; 0 (or negative) uses every
+ *        thread of the shared scheduler, whose size is set once through
+ *        TaskScheduler::configure_global() (default: hardware
+ *        concurrency). Larger values are capped by that size.
+ * @param body Work function, called concurrently from several threads.
+ *
+ * @throws Rethrows the first exception raised by body (remaining items
+ *         are skipped once an exception has been seen).
+ */
+void parallel_for(std::size_t count, int threads,
+                  const std::function<void(std::size_t)>& body);
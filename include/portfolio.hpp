@@ -1,33 +1,50 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 /**
  * @brief Type of financial instrument supported by the system.
  */
 enum class InstrumentType { STOCK, OPTION };
 
+/**
+ * @brief Option right; NONE for stock positions.
+ */
+enum class OptionType { NONE, CALL, PUT };
+
+/**
+ * @brief CSV spelling of an option type ("CALL", "PUT", empty for NONE).
+ */
+const char* option_type_name(OptionType t);
+
 /**
  * @brief Represents a single portfolio position.
  *
  * STOCK fields:
- *   - ticker
+ *   - ticker_id
  *   - quantity
  *
  * OPTION fields:
  *   - strike
  *   - maturity (not used yet in pricing)
- *   - option_type: "CALL" or "PUT"
+ *   - option_type: CALL or PUT
+ *
+ * The ticker is stored only as ticker_id, an index into the owning
+ * Portfolio::tickers; resolve the name with Portfolio::ticker().
  */
 struct Instrument {
-    InstrumentType type;
-    std::string ticker;
-    int quantity;
+    InstrumentType type = InstrumentType::STOCK;
+    std::uint32_t ticker_id = 0; ///< index into Portfolio::tickers
+    int quantity = 0;
 
     // option-specific
     double strike = 0.0; ///< option strike price
     double maturity = 0.0;  ///< option maturity in years
-    std::string option_type; // CALL or PUT
+    OptionType option_type = OptionType::NONE;
 };
 
 /**
@@ -36,21 +53,67 @@ struct Instrument {
  * Provides loading from CSV format:
  *   type,ticker,quantity,strike,maturity,option_type
  *
+ * Numbers may carry a leading '+'. A quantity is an integer; an integral
+ * decimal such as "100.0" is accepted, a fractional one is an error.
  * Unknown instrument types trigger exceptions.
  */
 class Portfolio {
 public:
     std::vector<Instrument> instruments;
 
+    /// Distinct tickers in order of first appearance; indexed by Instrument::ticker_id.
+    std::vector<std::string> tickers;
+
+    /// Ticker name of one of this portfolio's instruments.
+    const std::string& ticker(const Instrument& inst) const { return tickers[inst.ticker_id]; }
+
+    /**
+     * @brief Returns the id of a ticker, appending it to tickers if new.
+     */
+    std::uint32_t intern(std::string_view name);
+
+    /**
+     * @brief Appends a position on a ticker.
+     *
+     * @return The new instrument, so option fields can be filled in.
+     */
+    Instrument& add(InstrumentType type, std::string_view ticker, int quantity);
+
     /**
      * @brief Loads portfolio positions from a CSV file.
      *
+     * The file is memory-mapped and split at line boundaries into chunks
+     * that are parsed in parallel without per-field allocations; chunk
+     * results are concatenated in file order and chunk-local ticker ids
+     * are remapped into tickers.
+     *
      * @param file Path to portfolio CSV.
+     * @param threads Number of threads (0 = all threads of the shared scheduler).
      *
-     * @throws std::runtime_error if:
+     * @throws std::runtime_error (as "file:line: reason") if:
      *   - file cannot be opened,
-     *   - row format is invalid,
-     *   - instrument type is unknown.
+     *   - row format is invalid (including a fractional quantity),
+     *   - instrument or option type is unknown.
      */
-    void load(const std::string& file);
+    void load(const std::string& file, int threads = 0);
+
+    /**
+     * @brief Parses positions from CSV text held in memory (same format
+     *        and errors as load(); source names the text in messages).
+     */
+    void load_from_string(const std::string& csv, const std::string& source = "<inline>");
+
+    /**
+     * @brief Writes positions to a CSV file in the format read by load().
+     *
+     * @param file Output path.
+     *
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    void save(const std::string& file) const;
+
+private:
+    std::unordered_map<std::string, std::uint32_t> ticker_ids; ///< tickers -> id
+
+    void parse(const char* data, std::size_t size, const std::string& file, int threads);
 };
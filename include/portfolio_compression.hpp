@@ -0,0 +1,35 @@
+#pragma once
+#include "portfolio.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Result of netting a portfolio.
+ *
+ * row_to_position[i] is the index in portfolio.instruments of the net
+ * position that absorbed original row i, or NO_POSITION if the row's
+ * exposure netted to zero.
+ */
+struct CompressedPortfolio {
+    static constexpr std::size_t NO_POSITION = static_cast<std::size_t>(-1);
+
+    Portfolio portfolio;
+    std::vector<std::size_t> row_to_position;
+};
+
+/**
+ * @brief Nets identical exposures of a portfolio.
+ *
+ * Rows are merged when they describe the same exposure:
+ *   - STOCK:  same ticker (one net quantity per asset)
+ *   - OPTION: same ticker, option type, strike and maturity
+ *
+ * Positions whose net quantity is zero are dropped. Net positions keep
+ * the order in which their exposure first appears, and the returned
+ * portfolio is interned. Since valuation is linear in quantity, the net
+ * book has the same value as the original in every scenario.
+ *
+ * @throws std::runtime_error if a net quantity overflows int.
+ */
+CompressedPortfolio compress_portfolio(const Portfolio& portfolio);
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+class MarketDataHistory;
+
+/**
+ * @brief Dense close-price columns for a set of tickers.
+ *
+ * Every column is aligned to the union calendar of the history, so a
+ * price is looked up by (ticker position, date index) in O(1) instead of
+ * through the string-keyed maps of MarketDataHistory. Days on which a
+ * ticker has no quote hold NaN. For a mapped history the columns point
+ * into the binary file where they line up with the calendar, and the
+ * index keeps the mapping alive.
+ *
+ * The index also records the dates on which *all* of its tickers have a
+ * price, which is the calendar portfolio-level calculations need.
+ */
+class PriceIndex {
+public:
+    /**
+     * @brief Builds the columns for the given tickers.
+     *
+     * @param history Loaded price history.
+     * @param tickers Tickers to index (order is preserved).
+     *
+     * @throws std::runtime_error if a ticker is missing in history.
+     */
+    PriceIndex(const MarketDataHistory& history, const std::vector<std::string>& tickers);
+
+    // columns may point into `owned`, which a copy would not carry along
+    PriceIndex(const PriceIndex&) = delete;
+    PriceIndex& operator=(const PriceIndex&) = delete;
+    PriceIndex(PriceIndex&&) = default;
+    PriceIndex& operator=(PriceIndex&&) = default;
+
+    /// Union calendar (YYYYMMDD ascending).
+    const std::vector<int>& dates() const { return calendar; }
+
+    const std::vector<std::string>& tickers() const { return names; }
+
+    /// Close column of the t-th ticker, dates().size() values.
+    const double* column(std::size_t t) const { return closes[t]; }
+
+    double price(std::size_t t, std::size_t k) const { return closes[t][k]; }
+
+    /// Index of a date in dates(), or -1 if absent.
+    int date_index(int date) const;
+
+    /// Indices into dates() on which every ticker has a price, ascending.
+    const std::vector<std::size_t>& complete_dates() const { return complete; }
+
+    /**
+     * @brief Latest date index ≤ date on which every ticker has a price.
+     *
+     * @return Index into dates(), or -1 if there is none.
+     */
+    int previous_complete_index(int date) const;
+
+private:
+    std::vector<int> calendar;
+    std::vector<std::string> names;
+    std::vector<const double*> closes;          ///< into owned or the mapped file
+    std::vector<std::vector<double>> owned;     ///< columns assembled by the history
+    std::shared_ptr<const void> backing;        ///< mapped file, if any
+    std::vector<std::size_t> complete;
+};
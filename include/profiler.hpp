@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Stage-level timing and counters for a run.
+ *
+ * Instrumentation points use the PROFILE_* macros below. They compile to
+ * nothing unless RISK_ENGINE_PROFILING is defined (CMake option
+ * RISK_ENGINE_PROFILE, on by default), and cost one relaxed atomic load
+ * while the profiler is disabled at run time.
+ *
+ * Recorded data:
+ *   - stages: calls, wall seconds and heap allocations per named scope
+ *   - counters: monotonically added totals (rows parsed, bytes read, ...)
+ *   - threads: busy seconds and tasks per parallel_for worker slot
+ *
+ * Stages are meant for coarse steps (a load, a factorization, a
+ * simulation), and counters are added once per batch, never per element.
+ * Allocation counts come from the executable's replacement operator
+ * new calling profiler::count_allocation(); they are process-wide, so a
+ * stage also sees allocations made by other threads while it runs.
+ */
+namespace profiler {
+
+void set_enabled(bool on);
+
+inline std::atomic<bool>& enabled_flag() {
+    static std::atomic<bool> flag{false};
+    return flag;
+}
+
+inline bool enabled() { return enabled_flag().load(std::memory_order_relaxed); }
+
+/// Clears all recorded stages, counters and thread statistics.
+void reset();
+
+void add_stage(const char* name, double seconds, std::uint64_t allocations);
+void add_counter(const char* name, std::uint64_t value);
+void add_thread_busy(std::size_t slot, double seconds, std::uint64_t tasks);
+
+/// Called by the allocation hook; counts only while enabled.
+void count_allocation();
+std::uint64_t allocations();
+
+/**
+ * @brief Writes the report as JSON.
+ *
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+void write_report(const std::string& file);
+
+/**
+ * @brief Records the lifetime of a scope as one call of a stage.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* stage_name)
+        : name(enabled() ? stage_name : nullptr) {
+        if (name) {
+            allocs = allocations();
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedTimer() {
+        if (!name) return;
+        std::chrono::duration<double> dt = std::chrono::steady_clock::now() - start;
+        add_stage(name, dt.count(), allocations() - allocs);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* name;
+    std::uint64_t allocs = 0;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace profiler
+
+#ifdef RISK_ENGINE_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ::profiler::ScopedTimer PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_COUNT(name, value) \
+    do { if (::profiler::enabled()) ::profiler::add_counter(name, (value)); } while (0)
+#else
+#define PROFILE_SCOPE(name) do {} while (0)
+#define PROFILE_COUNT(name, value) do {} while (0)
+#endif
@@ -24,8 +24,8 @@ class MarketDataHistory;
  *   3. Computes percentage returns.
  *   4. Converts them to losses.
  *   5. Computes:
- *        VaR = 95th percentile of losses,
- *        ES  = mean of worst 5% losses.
+ *        VaR = confidence-quantile of losses (95th percentile by default),
+ *        ES  = mean of losses at or beyond VaR.
  *
  * VaR/ES are capped at zero (cannot be negative).
  *
@@ -33,6 +33,7 @@ class MarketDataHistory;
  * @param history Historical price database.
  * @param snapshot_date Starting date of VaR horizon.
  * @param horizon_days Number of future trading days to examine.
+ * @param confidence Confidence level (e.g. 0.95).
  *
  * @return RealizedRisk struct with VaR and ES.
  *
@@ -42,5 +43,6 @@ RealizedRisk compute_realized_risk(
     const Portfolio& portfolio,
     const MarketDataHistory& history,
     const std::string& snapshot_date,
-    int horizon_days
+    int horizon_days,
+    double confidence = 0.95
 );
@@ -0,0 +1,143 @@
+#pragma once
+#include "portfolio.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Portfolio compiled against an ordered asset list for fast
+ *        scenario revaluation.
+ *
+ * The portfolio is netted first (see compress_portfolio()), and positions
+ * refer to assets by index instead of ticker strings, so a scenario is
+ * revalued from a plain array of terminal prices.
+ * Valuation follows the Monte Carlo engine:
+ *   - STOCK:  quantity × S
+ *   - OPTION: quantity × intrinsic payoff (max(S-K,0) / max(K-S,0))
+ *
+ * Scenario P&L = V(terminal prices) - V(spot).
+ */
+class PortfolioRevaluer {
+public:
+    /**
+     * @param portfolio Portfolio to compile.
+     * @param tickers Asset order used by price arrays.
+     * @param spot Spot price of every asset (same order as tickers).
+     *
+     * @throws std::runtime_error if an instrument's ticker is not in tickers.
+     */
+    PortfolioRevaluer(const Portfolio& portfolio,
+                      const std::vector<std::string>& tickers,
+                      const std::vector<double>& spot);
+
+    /// Portfolio value at spot.
+    double base_value() const { return v0; }
+
+    /// Number of assets expected in a price array.
+    std::size_t assets() const { return spot.size(); }
+
+    /// Number of net positions valued per scenario.
+    std::size_t position_count() const { return positions.size(); }
+
+    /**
+     * @brief Replaces per-option valuation by one grid lookup per underlying.
+     *
+     * For every asset carrying at least min_options net options, the
+     * aggregate option-book value is tabulated once on a spot grid and
+     * scenarios are valued by linear interpolation. Intrinsic payoffs are
+     * piecewise linear with kinks at the strikes, so the grid nodes are
+     * the strikes themselves (plus linear tails beyond the extreme ones);
+     * a uniform bucket table maps a spot to its grid cell in O(1).
+     *
+     * Each grid is checked against exact per-option pricing at every node,
+     * every cell midpoint and points beyond both tails. Assets whose
+     * maximum error exceeds tolerance × (1 + Σ|quantity| × max strike)
+     * keep exact pricing.
+     *
+     * @return Largest interpolation error observed over the gridded assets.
+     */
+    double enable_option_grid(std::size_t min_options = 2, double tolerance = 1e-9);
+
+    /// Number of underlyings valued through an option grid.
+    std::size_t grid_count() const { return grids.size(); }
+
+    /// Scenario P&L for one array of terminal prices.
+    double pnl(const double* prices) const;
+
+    /**
+     * @brief P&L of `count` scenarios.
+     *
+     * @param prices Row-major scenarios × assets terminal prices.
+     * @param count Number of scenarios.
+     * @param out Output array of count P&L values.
+     */
+    void pnl_batch(const double* prices, std::size_t count, double* out) const;
+
+    /**
+     * @brief Value of everything written on one asset at price S.
+     *
+     * Portfolio value is additive over assets, so a scenario P&L is the
+     * sum over assets of asset_value(a, S'_a) - asset_value(a, spot_a).
+     */
+    double asset_value(std::size_t asset, double S) const;
+
+    /**
+     * @brief True if the asset only carries stock positions; quantity
+     *        then receives their net quantity (value = quantity × S).
+     */
+    bool linear_asset(std::size_t asset, double& quantity) const;
+
+    /// Current spot of an asset.
+    double spot_price(std::size_t asset) const { return spot[asset]; }
+
+    /**
+     * @brief Moves the spot of one asset; base_value() and later P&L are
+     *        measured from the new spot.
+     */
+    void set_spot(std::size_t asset, double S);
+
+private:
+    enum class Kind { STOCK, CALL, PUT };
+
+    struct Position {
+        std::size_t asset;
+        Kind kind;
+        double quantity;
+        double strike;
+    };
+
+    /// Aggregate option book of one underlying as a piecewise-linear function.
+    struct OptionGrid {
+        std::size_t asset;
+        std::vector<double> nodes;    ///< sorted distinct strikes
+        std::vector<double> values;   ///< book value at each node
+        double slope_lo;              ///< d value / dS left of nodes.front()
+        double slope_hi;              ///< d value / dS right of nodes.back()
+        double inv_bucket;            ///< buckets per unit of spot
+        std::vector<std::uint32_t> bucket;  ///< first cell of each bucket
+
+        double eval(double S) const;
+    };
+
+    std::vector<Position> positions;
+    std::vector<OptionGrid> grids;
+
+    // positions / grid per asset, rebuilt by index_assets()
+    std::vector<std::size_t> asset_begin;       ///< CSR offsets into asset_positions
+    std::vector<std::size_t> asset_positions;   ///< indices into positions
+    std::vector<int> asset_grid;                ///< index into grids, -1 if none
+
+    void index_assets();
+    std::vector<double> spot;
+    double v0 = 0.0;
+
+    double value(const Position& p, double S) const {
+        switch (p.kind) {
+            case Kind::CALL: return p.quantity * (S > p.strike ? S - p.strike : 0.0);
+            case Kind::PUT:  return p.quantity * (p.strike > S ? p.strike - S : 0.0);
+            default:         return p.quantity * S;
+        }
+    }
+};
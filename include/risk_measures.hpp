@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * @brief Computes VaR and ES from a set of scenario P&L values.
+ *
+ * Uses the engine's order-statistic convention:
+ *   idx = int((1 - confidence) * n), clamped to [0, n-1]
+ *   VaR = -pnl_(idx)                      (idx-th smallest P&L)
+ *   ES  = -mean(pnl_(0) .. pnl_(idx))
+ *
+ * Runs in O(n) with std::nth_element; the array is partially reordered.
+ *
+ * @param pnl Scenario P&L values (positive = profit), modified in place.
+ * @param n Number of scenarios (must be > 0).
+ * @param confidence Confidence level (e.g. 0.95).
+ * @param var_out Output VaR (positive = loss).
+ * @param es_out Output ES (positive = loss).
+ */
+void tail_risk(double* pnl, std::size_t n, double confidence,
+               double& var_out, double& es_out);
+
+/**
+ * @brief Number of worst scenarios tail_risk() looks at: idx + 1.
+ */
+std::size_t tail_count(std::size_t n, double confidence);
+
+/**
+ * @brief tail_risk() over n scenarios, given only candidate tail values.
+ *
+ * For scenario sets produced in blocks: each block keeps its
+ * tail_count(n, confidence) smallest P&L values and the union is passed
+ * here. Values past the real candidates may be padded with +infinity.
+ *
+ * @param candidates Candidate P&L values (modified in place).
+ * @param m Number of candidates (>= tail_count(n, confidence)).
+ * @param n Total number of scenarios the candidates were taken from.
+ */
+void tail_risk_candidates(double* candidates, std::size_t m, std::size_t n,
+                          double confidence, double& var_out, double& es_out);
@@ -0,0 +1,117 @@
+#pragma once
+#include "json.hpp"
+#include "market_snapshot.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class MarketDataHistory;
+
+/**
+ * @brief Settings of a long-running risk server.
+ *
+ *  - lookback_days: default calibration window of requests
+ *  - threads: worker threads answering requests (0 = hardware concurrency);
+ *    each request computes on an equal share of the shared TaskScheduler
+ *  - cache_capacity: calibrations kept warm (oldest evicted first)
+ */
+struct RiskServerConfig {
+    int lookback_days = 252;
+    int threads = 0;
+    std::size_t cache_capacity = 64;
+};
+
+/**
+ * @brief Answers VaR/ES requests against a history loaded once.
+ *
+ * Requests and responses are single-line JSON objects. A request:
+ *
+ *   {"id": 7, "date": "2025-08-08", "portfolio": "data/portfolio_djia.csv",
+ *    "horizon": 10, "confidence": 0.95, "scenarios": 10000,
+ *    "lookback": 252, "method": "mc"}
+ *
+ * The portfolio is given by path ("portfolio"), as inline CSV text
+ * ("portfolio_csv") or as an array of positions ("positions": [{"type":
+ * "STOCK", "ticker": "AAPL", "quantity": 10}, ...]). method is "mc"
+ * (default) or "historical". {"cmd": "stats"} reports server counters and
+ * {"cmd": "shutdown"} stops the serving loop.
+ *
+ * Responses echo "id" and carry "ok"; successful ones add the aligned
+ * "date", "var", "es", "portfolio_value", "cache" ("hit" / "miss") and
+ * "elapsed_ms", failed ones an "error" message.
+ *
+ * Calibrated snapshots and their Cholesky factors are cached by
+ * (date, lookback, ticker set), so a warm request only simulates.
+ * Requests compute side by side, each capped at the scheduler's
+ * concurrency divided by the worker count, so concurrent requests never
+ * ask for more threads than the scheduler has.
+ * The history must not be modified while the server runs.
+ */
+class RiskServer {
+public:
+    RiskServer(const MarketDataHistory& history, RiskServerConfig config = {});
+
+    /// Answers one request line; never throws (errors become responses).
+    std::string handle(const std::string& request_line);
+
+    /**
+     * @brief Line-delimited JSON over streams (e.g. stdin / stdout).
+     *
+     * Requests are answered concurrently on the worker pool, so responses
+     * may come back out of order; match them by "id". Returns at end of
+     * input or after a shutdown request, once all responses are written.
+     */
+    void serve_stream(std::istream& in, std::ostream& out);
+
+    /**
+     * @brief Line-delimited JSON over a Unix domain socket.
+     *
+     * Each connection is served by one worker, requests on a connection
+     * are answered in order, and up to `threads` connections are served
+     * at once. Returns after a shutdown request.
+     *
+     * @throws std::runtime_error if the socket cannot be created or bound.
+     */
+    void serve_unix_socket(const std::string& path);
+
+    /// Asks the serving loop to return.
+    void stop();
+
+    std::size_t cache_size() const;
+    std::uint64_t requests_served() const { return served.load(); }
+
+private:
+    struct Calibration {
+        MarketSnapshot snapshot;
+        std::vector<std::vector<double>> cholesky;
+    };
+
+    std::shared_ptr<const Calibration> calibration(const std::vector<std::string>& tickers,
+                                                   const std::string& date,
+                                                   int lookback, bool& hit);
+    JsonValue run(const JsonValue& request);
+
+    const MarketDataHistory& history;
+    RiskServerConfig config;
+    int request_threads;   ///< scheduler share of one request
+
+    mutable std::mutex cache_mutex;
+    std::map<std::string, std::shared_ptr<const Calibration>> cache;
+    std::list<std::string> cache_order;   ///< insertion order for eviction
+
+    std::atomic<std::uint64_t> served{0};
+    std::atomic<std::uint64_t> cache_hits{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<int> listen_fd{-1};
+    std::mutex connection_mutex;
+    std::unordered_set<int> connections;   ///< open socket connections
+};
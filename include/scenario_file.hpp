@@ -0,0 +1,165 @@
+#pragma once
+#include "mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Binary scenario file layout (little-endian, all blocks 8-byte aligned).
+ *
+ *   [ScenarioFileHeader]
+ *   [column index]   n_columns × ScenarioFileColumn
+ *   [row groups]     ceil(n_scenarios / group_rows) groups; group g holds
+ *                    scenarios [g·group_rows, g·group_rows + rows) as
+ *                    n_columns consecutive float64 columns of `rows`
+ *                    values each (the last group may be shorter)
+ *
+ * Every group starts at data_offset + g·group_rows·n_columns·8, so
+ * writers can emit groups in any order and from several threads, each as
+ * one sequential write; a reader maps the file and gathers a column from
+ * the groups. The header is written last, so a file whose writer did not
+ * finish has no magic and is rejected.
+ */
+struct ScenarioFileHeader {
+    char magic[8];                ///< "MCRSCEN1"
+    std::uint32_t version;        ///< format version (1)
+    std::uint32_t n_columns;
+    std::uint64_t n_scenarios;
+    std::uint32_t group_rows;     ///< scenarios per row group
+    std::uint32_t horizon_days;   ///< simulation horizon, 0 if not applicable
+    std::uint64_t seed;           ///< RNG key; scenario s used Philox stream s
+    std::uint64_t column_offset;
+    std::uint64_t data_offset;
+    std::uint64_t file_size;      ///< total size, used to detect truncation
+};
+
+/// What a scenario file column holds.
+enum class ScenarioColumnKind : std::uint32_t {
+    PNL = 0,        ///< portfolio P&L
+    PRICE = 1,      ///< terminal price of one ticker
+    BOOK_PNL = 2,   ///< P&L of every position on one underlying
+};
+
+/**
+ * @brief Index entry describing one column.
+ */
+struct ScenarioFileColumn {
+    char name[24];              ///< NUL-padded ticker symbol ("pnl" for PNL)
+    ScenarioColumnKind kind;
+    std::uint32_t asset;        ///< ticker index in the engine, 0 for PNL
+};
+
+/**
+ * @brief Builds an index entry.
+ *
+ * @throws std::runtime_error if name is longer than 23 characters.
+ */
+ScenarioFileColumn scenario_column(ScenarioColumnKind kind, const std::string& name,
+                                   std::uint32_t asset = 0);
+
+/**
+ * @brief Writes a scenario file group by group.
+ *
+ * The constructor writes the index and sizes the file;
+ * write_group() may then be called concurrently for distinct groups
+ * (positioned writes on one descriptor, no shared state). close()
+ * writes the header; a writer destroyed without close() leaves an
+ * incomplete file that ScenarioFile::open() refuses.
+ */
+class ScenarioFileWriter {
+public:
+    /**
+     * @throws std::runtime_error if the file cannot be created, or
+     *         n_scenarios, group_rows or columns is empty.
+     */
+    ScenarioFileWriter(const std::string& path,
+                       std::uint64_t n_scenarios,
+                       std::uint32_t group_rows,
+                       const std::vector<ScenarioFileColumn>& columns,
+                       std::uint32_t horizon_days = 0,
+                       std::uint64_t seed = 0);
+    ~ScenarioFileWriter();
+
+    ScenarioFileWriter(const ScenarioFileWriter&) = delete;
+    ScenarioFileWriter& operator=(const ScenarioFileWriter&) = delete;
+
+    std::size_t n_columns() const { return header.n_columns; }
+    std::size_t group_rows() const { return header.group_rows; }
+    std::size_t n_groups() const;
+
+    /// Number of scenarios in group g.
+    std::size_t rows_in_group(std::size_t g) const;
+
+    /**
+     * @brief Writes group g.
+     *
+     * @param data n_columns() × rows_in_group(g) values, column after column.
+     *
+     * @throws std::runtime_error on a write error or an invalid group.
+     */
+    void write_group(std::size_t g, const double* data);
+
+    /**
+     * @brief Writes the header, marking the file complete, and closes it.
+     *
+     * Call once every group has been written.
+     *
+     * @throws std::runtime_error if writing the header or closing fails.
+     */
+    void close();
+
+private:
+    ScenarioFileHeader header{};
+    std::string path;
+    int fd = -1;
+};
+
+/**
+ * @brief Read-only, memory-mapped view of a scenario file.
+ */
+class ScenarioFile {
+public:
+    /**
+     * @brief Maps and validates a scenario file.
+     *
+     * @throws std::runtime_error if the file cannot be mapped, was not
+     *         completed by its writer, has a wrong magic/version, or is
+     *         truncated.
+     */
+    void open(const std::string& path);
+
+    std::size_t n_scenarios() const { return header->n_scenarios; }
+    std::size_t n_columns() const { return header->n_columns; }
+    std::size_t group_rows() const { return header->group_rows; }
+    std::size_t n_groups() const;
+    int horizon_days() const { return static_cast<int>(header->horizon_days); }
+    std::uint64_t seed() const { return header->seed; }
+
+    /// Index entry of the i-th column.
+    const ScenarioFileColumn& column(std::size_t i) const { return index[i]; }
+
+    /// Name stored for the i-th column.
+    std::string column_name(std::size_t i) const;
+
+    /// Index of the column with this kind and name, or -1.
+    int find_column(ScenarioColumnKind kind, const std::string& name = "pnl") const;
+
+    /// Number of scenarios in group g.
+    std::size_t rows_in_group(std::size_t g) const;
+
+    /// Column c of group g (rows_in_group(g) values, in place).
+    const double* group_column(std::size_t g, std::size_t c) const;
+
+    /// Column c over all scenarios.
+    std::vector<double> read_column(std::size_t c) const;
+
+    /// Size of the mapped file in bytes.
+    std::size_t size() const { return file.size(); }
+
+private:
+    MappedFile file;
+    const ScenarioFileHeader* header = nullptr;
+    const ScenarioFileColumn* index = nullptr;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief Lock-free single-producer / single-consumer ring buffer.
+ *
+ * Exactly one thread may call try_push() and exactly one (other) thread
+ * may call try_pop(). Head and tail live on separate cache lines and each
+ * side caches the other side's index, so an uncontended push or pop
+ * touches no shared line except when the cached index is exhausted.
+ *
+ * Capacity is rounded up to a power of two. Nothing blocks: callers spin
+ * or yield on failure, which suits stages that are expected to keep up
+ * with each other.
+ */
+template <class T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity) {
+        std::size_t cap = 2;
+        while (cap < capacity) cap *= 2;
+        mask = cap - 1;
+        slots = std::make_unique<T[]>(cap);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const { return mask + 1; }
+
+    /// Producer side. @return false if the ring is full.
+    bool try_push(const T& item) {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head_cache > mask) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (t - head_cache > mask) return false;
+        }
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side. @return false if the ring is empty.
+    bool try_pop(T& item) {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail_cache) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h == tail_cache) return false;
+        }
+        item = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Approximate; exact only when both sides are quiescent.
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr std::size_t LINE = 64;
+
+    std::unique_ptr<T[]> slots;
+    std::size_t mask = 0;
+
+    alignas(LINE) std::atomic<std::size_t> head{0};   ///< next slot to pop
+    std::size_t tail_cache = 0;                       ///< consumer's view of tail
+    alignas(LINE) std::atomic<std::size_t> tail{0};   ///< next slot to push
+    std::size_t head_cache = 0;                       ///< producer's view of head
+};
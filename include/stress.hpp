@@ -0,0 +1,115 @@
+#pragma once
+#include "market_snapshot.hpp"
+#include "portfolio.hpp"
+#include "revaluation.hpp"
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class MarketDataHistory;
+
+/**
+ * @brief Named deterministic price shocks.
+ *
+ * shocks is a scenarios × tickers matrix (row-major) of simple returns:
+ * scenario s moves ticker i from S to S × (1 + shocks[s·n + i]).
+ */
+struct StressScenarios {
+    std::vector<std::string> tickers;   ///< shock columns
+    std::vector<std::string> names;     ///< one per scenario
+    std::vector<double> shocks;         ///< names.size() × tickers.size()
+
+    std::size_t size() const { return names.size(); }
+    const double* row(std::size_t s) const { return shocks.data() + s * tickers.size(); }
+
+    /// Appends the scenarios of another set, mapping its columns by ticker
+    /// (tickers it does not shock get 0).
+    void append(const StressScenarios& other);
+};
+
+/**
+ * @brief Every horizon-day window of the history as a stress scenario.
+ *
+ * Windows run over the dates on which all tickers trade; a window
+ * starting on date t is the move S(t + h) / S(t) - 1 of every ticker and
+ * is named "YYYY-MM-DD+h". Both ends lie in [from_date, to_date]. Prices
+ * come from the in-memory history (PriceIndex columns).
+ *
+ * @throws std::runtime_error if a ticker is missing, a date is invalid,
+ *         or no complete window fits in the range.
+ */
+StressScenarios historical_stress_windows(const MarketDataHistory& history,
+                                          const std::vector<std::string>& tickers,
+                                          const std::string& from_date,
+                                          const std::string& to_date,
+                                          int horizon_days);
+
+/**
+ * @brief Reads a ticker → sector map (CSV: ticker,sector; optional header).
+ *
+ * @throws std::runtime_error if the file cannot be read or a line has no comma.
+ */
+std::unordered_map<std::string, std::string> load_sector_map(const std::string& file);
+
+/**
+ * @brief Reads hypothetical stress scenarios.
+ *
+ * CSV lines `scenario,target,shock` (optional header, '#' comments).
+ * target is a ticker, `sector:NAME` or `*` (every ticker); shock is a
+ * simple return (-0.2 = down 20%). Within a scenario a ticker shock
+ * overrides its sector's, which overrides `*`, regardless of line order.
+ * Scenarios keep the order of their first line. Tickers outside
+ * `tickers` are ignored, so one file serves any portfolio.
+ *
+ * @throws std::runtime_error (as "file:line: reason") for a malformed
+ *         line, a shock ≤ -1, or a sector missing from `sectors`.
+ */
+StressScenarios load_stress_scenarios(const std::string& file,
+                                      const std::vector<std::string>& tickers,
+                                      const std::unordered_map<std::string, std::string>& sectors = {});
+
+/**
+ * @brief P&L of every stress scenario.
+ */
+struct StressResult {
+    std::vector<double> pnl;            ///< per scenario, same order as the input
+    std::vector<std::size_t> worst;     ///< indices of the worst scenarios, largest loss first
+    double portfolio_value = 0.0;       ///< V0 at the snapshot spots
+};
+
+/**
+ * @brief Applies stress scenarios to a compiled portfolio.
+ *
+ * The portfolio is compiled once (PortfolioRevaluer, as in
+ * MonteCarloEngine); run() turns blocks of shock rows into terminal
+ * prices and revalues each block with one pnl_batch() call, blocks in
+ * parallel.
+ */
+class StressEngine {
+public:
+    /**
+     * @throws std::runtime_error if a portfolio ticker is not in the snapshot.
+     */
+    StressEngine(const Portfolio& portfolio, const MarketSnapshot& snap);
+
+    /**
+     * @brief Revalues every scenario and ranks the worst.
+     *
+     * Shock columns are matched to the snapshot tickers by name; tickers
+     * the set does not cover stay at spot.
+     *
+     * @param worst_n Number of worst scenarios to rank (capped at size()).
+     * @param threads Number of threads (0 = all threads of the shared scheduler).
+     */
+    StressResult run(const StressScenarios& scenarios, std::size_t worst_n,
+                     int threads = 0) const;
+
+    double base_value() const { return revaluer.base_value(); }
+
+private:
+    std::vector<std::string> tickers;
+    std::vector<double> spot;
+    PortfolioRevaluer revaluer;
+};
@@ -0,0 +1,196 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Work counters of one scheduler thread.
+ */
+struct WorkerStats {
+    std::uint64_t tasks = 0;          ///< ranges executed
+    std::uint64_t steals = 0;         ///< ranges taken from another worker
+    std::uint64_t failed_steals = 0;  ///< steal attempts that found nothing
+    double busy_seconds = 0.0;        ///< time spent running ranges
+    double idle_seconds = 0.0;        ///< time spent sleeping for work
+    int cpu = -1;                     ///< pinned CPU, -1 if not pinned
+    int node = 0;                     ///< NUMA node the thread prefers
+};
+
+/**
+ * @brief CPUs usable by this process, grouped by NUMA node.
+ *
+ * Read from /sys/devices/system/node and intersected with the process
+ * affinity mask; a machine without NUMA information (or a non-Linux
+ * build) is reported as a single node holding every usable CPU.
+ */
+struct NumaTopology {
+    std::vector<std::vector<int>> nodes;   ///< CPU ids per node, never empty
+
+    static NumaTopology detect();
+
+    std::size_t cpu_count() const;
+};
+
+/**
+ * @brief Counters of a scheduler: index 0 aggregates external threads
+ *        (callers of parallel_for), then one entry per worker thread.
+ */
+struct SchedulerStats {
+    std::vector<WorkerStats> threads;
+
+    WorkerStats total() const;
+};
+
+/**
+ * @brief Work-stealing fork/join scheduler shared by all parallel code.
+ *
+ * Every thread owns a deque of index ranges. parallel_for() splits its
+ * range in halves: the upper half is pushed onto the current thread's
+ * deque (threads outside the pool use a shared injection queue) and the
+ * lower half is processed immediately, down to the grain size. Owners
+ * pop their newest range, idle threads steal the oldest — and thus
+ * largest — range from a victim, so a heavy job next to light ones is
+ * split up by whoever runs out of work.
+ *
+ * A thread waiting for its ranges to finish runs other pending ranges
+ * meanwhile, so nested parallel_for calls (jobs → scenario blocks) share
+ * the same threads without oversubscription or deadlock.
+ *
+ * Tasks are plain structs {function pointer, context, range, group} kept
+ * in growable rings; no allocation happens per task once the rings have
+ * reached their working size.
+ *
+ * With pinning enabled, worker k is bound to the k-th CPU of the
+ * NumaTopology taken node by node, and idle workers steal from victims
+ * on their own node before crossing to another one. Memory a task
+ * touches first (scenario slices, shock buffers) is then placed on the
+ * node of the worker that produces it, and stays there.
+ */
+class TaskScheduler {
+public:
+    /**
+     * @param threads Total concurrency including the calling thread (>= 1).
+     * @param pin_threads Bind workers to CPUs, node by node (Linux only;
+     *        ignored elsewhere). The calling thread is never pinned.
+     */
+    explicit TaskScheduler(int threads, bool pin_threads = false);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /**
+     * @brief Shared scheduler, created on first use with
+     *        configure_global()'s size (default: hardware concurrency).
+     */
+    static TaskScheduler& global();
+
+    /**
+     * @brief Sets the size of the shared scheduler.
+     *
+     * Takes effect if called before the first global() use; later calls
+     * are ignored. @return true if the size was applied.
+     */
+    static bool configure_global(int threads, bool pin_threads = false);
+
+    /// Total concurrency (background workers + the calling thread).
+    std::size_t concurrency() const { return workers.size() + 1; }
+
+    /// True if the workers were bound to CPUs.
+    bool pinned() const { return pin; }
+
+    /// NUMA node of the calling thread (0 outside the pool or unpinned).
+    int current_node() const;
+
+    /**
+     * @brief Runs body(i) for i in [0, count) and waits for completion.
+     *
+     * @param grain Ranges of at most this many indices are not split.
+     *
+     * Rethrows the first exception thrown by body; remaining ranges are
+     * skipped once a body has failed.
+     */
+    void parallel_for(std::size_t count, std::size_t grain,
+                      const std::function<void(std::size_t)>& body);
+
+    SchedulerStats stats() const;
+    void reset_stats();
+
+private:
+    struct Group;
+
+    struct Task {
+        void (*fn)(const void* ctx, std::size_t begin, std::size_t end);
+        const void* ctx;
+        std::size_t begin;
+        std::size_t end;
+        std::size_t grain;
+        Group* group;
+    };
+
+    /// Double-ended ring of tasks; grows by doubling and never shrinks,
+    /// so a warmed-up scheduler pushes and pops without allocating.
+    class TaskRing {
+    public:
+        bool empty() const { return count == 0; }
+        void push_back(const Task& t) {
+            if (count == slots.size()) grow();
+            slots[(head + count) & (slots.size() - 1)] = t;
+            count++;
+        }
+        Task& back() { return slots[(head + count - 1) & (slots.size() - 1)]; }
+        Task& front() { return slots[head]; }
+        void pop_back() { count--; }
+        void pop_front() { head = (head + 1) & (slots.size() - 1); count--; }
+
+    private:
+        std::vector<Task> slots;   ///< power-of-two size
+        std::size_t head = 0;
+        std::size_t count = 0;
+
+        void grow() {
+            std::vector<Task> bigger(slots.empty() ? 64 : 2 * slots.size());
+            for (std::size_t i = 0; i < count; i++)
+                bigger[i] = slots[(head + i) & (slots.size() - 1)];
+            slots.swap(bigger);
+            head = 0;
+        }
+    };
+
+    struct Queue {
+        mutable std::mutex mutex;
+        TaskRing tasks;
+    };
+
+    struct Counters {
+        std::atomic<std::uint64_t> tasks{0}, steals{0}, failed_steals{0};
+        std::atomic<std::uint64_t> busy_ns{0}, idle_ns{0};
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;     ///< one per worker
+    Queue injection;                                ///< shared by external threads
+    std::vector<std::unique_ptr<Counters>> counters; ///< [0] external, [1..] workers
+    std::vector<std::thread> workers;
+    std::vector<int> worker_cpu;    ///< pinned CPU per worker, -1 if none
+    std::vector<int> worker_node;   ///< NUMA node per worker
+    bool pin = false;
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<std::size_t> pending{0};   ///< queued ranges, for wakeups
+    std::atomic<bool> stopping{false};
+
+    void worker_loop(std::size_t index);
+    void push(int self, const Task& t);
+    bool pop_local(int self, Task& t);
+    bool steal(int self, Task& t);
+    bool try_run_one(int self);
+    void execute(int self, Task t);
+};
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Trading calendar index over a set of price series.
+ *
+ * Built once from the history price store and kept next to it:
+ *   - union calendar: every date on which at least one ticker trades,
+ *   - common calendar: dates on which every ticker trades,
+ *   - per-ticker availability bitmaps over the union calendar.
+ *
+ * Dates are stored as sorted integer keys YYYYMMDD (see parse_date()),
+ * so "previous common date", past/future windows and date offsets are
+ * binary searches on a contiguous array rather than string set
+ * intersections or map copies.
+ */
+class TradingCalendar {
+public:
+    using PriceStore = std::unordered_map<std::string, std::map<std::string, double>>;
+
+    /**
+     * @brief Close column over a slice of a date axis, NaN on days without
+     *        a quote (the layout of a binary history file).
+     */
+    struct Column {
+        std::string ticker;
+        std::size_t first = 0;          ///< axis index of values[0]
+        std::size_t count = 0;          ///< number of values
+        const double* values = nullptr;
+    };
+
+    /**
+     * @brief Rebuilds the calendar from a price store.
+     *
+     * @throws std::runtime_error if a date is not in YYYY-MM-DD format.
+     */
+    void build(const PriceStore& prices);
+
+    /**
+     * @brief Rebuilds the calendar from columns over a date axis.
+     *
+     * The union calendar keeps the axis dates on which some column has a
+     * value. Nothing is parsed or copied per row, so a mapped binary
+     * history is indexed in place.
+     *
+     * @param axis Ascending YYYYMMDD dates the columns are indexed by.
+     * @param n_axis Length of axis.
+     */
+    void build(const std::int32_t* axis, std::size_t n_axis, const std::vector<Column>& columns);
+
+    /**
+     * @brief Updates the calendar after rows were appended to some tickers.
+     *
+     * Dates later than the current last union date are appended in place;
+     * anything else (new tickers, back-filled dates) triggers a rebuild.
+     *
+     * @param prices Price store after the update.
+     * @param changed Tickers whose series received new rows.
+     */
+    void extend(const PriceStore& prices, const std::vector<std::string>& changed);
+
+    /**
+     * @brief Cheap consistency check against a price store.
+     *
+     * Catches a store that gained or lost tickers or rows; an edit that
+     * keeps both counts goes unnoticed, so this is a guard against a
+     * forgotten rebuild, not a substitute for one.
+     *
+     * @return true if the store has the same tickers count and row count
+     *         the calendar was built from.
+     */
+    bool matches(const PriceStore& prices) const;
+
+    const std::vector<int>& union_dates() const { return all_dates; }
+    const std::vector<int>& common_dates() const { return common; }
+    const std::vector<std::string>& tickers() const { return names; }
+
+    /// Number of prices the calendar was built from.
+    std::size_t row_count() const { return rows; }
+
+    /// Index of a ticker in tickers(), or -1 if unknown.
+    int ticker_index(const std::string& ticker) const;
+
+    /// Index of a date in union_dates(), or -1 if nobody trades that day.
+    int union_index(int date) const;
+
+    /// Whether the ticker has a price on the given union-calendar index.
+    bool available(int ticker, std::size_t union_idx) const {
+        return (bits[ticker][union_idx >> 6] >> (union_idx & 63)) & 1u;
+    }
+
+    /**
+     * @brief Latest common trading date ≤ target.
+     *
+     * @throws std::runtime_error if there is no common date or target
+     *         precedes all common dates.
+     */
+    int previous_common_date(int target) const;
+
+    /**
+     * @brief Common date `k` trading days away from `date`.
+     *
+     * `date` is first aligned to the latest common date ≤ date.
+     *
+     * @return Shifted date, or -1 if it falls outside the calendar.
+     */
+    int offset_date(int date, int k) const;
+
+    /**
+     * @brief Up to n common dates strictly before `date`, newest first.
+     */
+    std::vector<int> past_dates(int date, int n) const;
+
+    /**
+     * @brief Up to n common dates strictly after `date`, oldest first.
+     */
+    std::vector<int> future_dates(int date, int n) const;
+
+private:
+    std::vector<int> all_dates;                     ///< union calendar
+    std::vector<int> common;                        ///< common calendar
+    std::vector<std::string> names;                 ///< sorted tickers
+    std::unordered_map<std::string, int> index;     ///< ticker → position
+    std::vector<std::vector<std::uint64_t>> bits;   ///< availability bitmaps
+    std::size_t rows = 0;                           ///< rows indexed
+
+    void rebuild_common(std::size_t from_idx);
+};
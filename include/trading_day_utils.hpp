@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -27,3 +28,34 @@ std::string find_common_previous_date(
     const std::unordered_map<std::string, std::vector<std::string>>& ticker_dates,
     const std::string& target
 );
+
+/**
+ * @brief Parses a YYYY-MM-DD date into an integer key YYYYMMDD.
+ *
+ * Non-allocating; used by the history loaders on every CSV row.
+ * Integer keys sort in the same order as the ISO date strings.
+ *
+ * @param s Pointer to the first character of the date.
+ * @param len Number of characters available (must be exactly 10).
+ *
+ * @return YYYYMMDD, or -1 if the text is not a well-formed date.
+ */
+int parse_date(const char* s, std::size_t len);
+
+/// Convenience overload of parse_date() for std::string.
+int parse_date(const std::string& s);
+
+/**
+ * @brief Formats an integer date key YYYYMMDD as YYYY-MM-DD.
+ */
+std::string format_date(int yyyymmdd);
+
+/**
+ * @brief Shifts an integer date key YYYYMMDD by a number of calendar days.
+ *
+ * @param yyyymmdd Valid date key (see parse_date()).
+ * @param days Number of days to add (may be negative).
+ *
+ * @return Shifted date key.
+ */
+int add_calendar_days(int yyyymmdd, int days);
@@ -0,0 +1,276 @@
+#include "backtest.hpp"
+#include "market_data_history.hpp"
+#include "market_snapshot.hpp"
+#include "monte_carlo.hpp"
+#include "parallel.hpp"
+#include "portfolio.hpp"
+#include "price_index.hpp"
+#include "profiler.hpp"
+#include "revaluation.hpp"
+#include "trading_day_utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+// ---------------------------------------------------------------------
+// Exception statistics
+// ---------------------------------------------------------------------
+
+// x * log(y) with the 0 * log(0) = 0 convention
+static double xlogy(double x, double y) {
+    return x == 0.0 ? 0.0 : x * std::log(y);
+}
+
+static double chi2_p_value(double lr, int dof) {
+    if (lr <= 0.0) return 1.0;
+    // closed forms for 1 and 2 degrees of freedom
+    return dof == 1 ? std::erfc(std::sqrt(lr / 2.0)) : std::exp(-lr / 2.0);
+}
+
+LikelihoodRatio kupiec_test(std::size_t exceptions, std::size_t observations,
+                            double expected_rate)
+{
+    LikelihoodRatio out;
+    if (observations == 0) return out;
+
+    double x = static_cast<double>(exceptions);
+    double T = static_cast<double>(observations);
+    double pi = x / T;
+
+    double log_null = xlogy(T - x, 1.0 - expected_rate) + xlogy(x, expected_rate);
+    double log_alt = xlogy(T - x, 1.0 - pi) + xlogy(x, pi);
+
+    out.lr = std::max(0.0, -2.0 * (log_null - log_alt));
+    out.p_value = chi2_p_value(out.lr, 1);
+    return out;
+}
+
+LikelihoodRatio christoffersen_independence_test(const std::vector<bool>& hits)
+{
+    double n00 = 0, n01 = 0, n10 = 0, n11 = 0;
+    for (std::size_t i = 1; i < hits.size(); i++) {
+        if (!hits[i - 1]) (hits[i] ? n01 : n00) += 1;
+        else              (hits[i] ? n11 : n10) += 1;
+    }
+
+    LikelihoodRatio out;
+    double total = n00 + n01 + n10 + n11;
+    if (total == 0) return out;
+
+    double pi = (n01 + n11) / total;
+    double pi0 = (n00 + n01) > 0 ? n01 / (n00 + n01) : 0.0;
+    double pi1 = (n10 + n11) > 0 ? n11 / (n10 + n11) : 0.0;
+
+    double log_null = xlogy(n00 + n10, 1.0 - pi) + xlogy(n01 + n11, pi);
+    double log_alt = xlogy(n00, 1.0 - pi0) + xlogy(n01, pi0)
+                   + xlogy(n10, 1.0 - pi1) + xlogy(n11, pi1);
+
+    out.lr = std::max(0.0, -2.0 * (log_null - log_alt));
+    out.p_value = chi2_p_value(out.lr, 1);
+    return out;
+}
+
+// ---------------------------------------------------------------------
+// Rolling calibration
+// ---------------------------------------------------------------------
+namespace {
+
+// Running sums of (shifted) daily log returns and their cross products
+// over a sliding window; reproduces build_snapshot()'s mu/sigma/corr.
+class RollingCalibrator {
+public:
+    RollingCalibrator(const std::vector<std::vector<double>>& returns,
+                      const std::vector<double>& shift)
+        : r(returns), c(shift), n(returns.size()),
+          sum(n, 0.0), prod(n * n, 0.0) {}
+
+    void reset() {
+        std::fill(sum.begin(), sum.end(), 0.0);
+        std::fill(prod.begin(), prod.end(), 0.0);
+        count = 0;
+    }
+
+    void add(std::size_t m, double sign) {
+        for (std::size_t i = 0; i < n; i++) {
+            double xi = r[i][m] - c[i];
+            sum[i] += sign * xi;
+            for (std::size_t j = i; j < n; j++)
+                prod[i * n + j] += sign * xi * (r[j][m] - c[j]);
+        }
+        count += sign > 0 ? 1 : -1;
+    }
+
+    void fill(MarketSnapshot& snap) const {
+        double N = static_cast<double>(count);
+        snap.mu.resize(n);
+        snap.sigma.resize(n);
+        snap.corr.assign(n, std::vector<double>(n, 1.0));
+
+        std::vector<double> cov(n * n);
+        for (std::size_t i = 0; i < n; i++) {
+            for (std::size_t j = i; j < n; j++) {
+                cov[i * n + j] = (prod[i * n + j] - sum[i] * sum[j] / N) / (N - 1);
+            }
+            snap.mu[i] = c[i] + sum[i] / N;
+            snap.sigma[i] = std::sqrt(std::max(cov[i * n + i], 0.0));
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            for (std::size_t j = i + 1; j < n; j++) {
+                double rho = cov[i * n + j] / (snap.sigma[i] * snap.sigma[j]);
+                snap.corr[i][j] = rho;
+                snap.corr[j][i] = rho;
+            }
+        }
+    }
+
+private:
+    const std::vector<std::vector<double>>& r;
+    const std::vector<double>& c;
+    std::size_t n;
+    std::vector<double> sum;
+    std::vector<double> prod;   // upper triangle, row-major n × n
+    long count = 0;
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------
+// Backtest driver
+// ---------------------------------------------------------------------
+BacktestResult run_backtest(const Portfolio& portfolio,
+                            const MarketDataHistory& history,
+                            const BacktestSpec& spec)
+{
+    PROFILE_SCOPE("backtest");
+
+    const std::vector<std::string>& tickers = portfolio.tickers;
+    if (tickers.empty())
+        throw std::runtime_error("run_backtest: empty portfolio");
+
+    const std::size_t n = tickers.size();
+    const std::size_t L = std::max(spec.lookback_days, 0);
+    const std::size_t h = std::max(spec.horizon_days, 1);
+
+    // ---- 1. Dense prices and daily log returns on the complete calendar ----
+    PriceIndex index(history, tickers);
+    const auto& complete = index.complete_dates();
+    const std::size_t M = complete.size();
+
+    std::vector<std::vector<double>> price(n, std::vector<double>(M));
+    std::vector<std::vector<double>> ret(n, std::vector<double>(M, 0.0));
+    std::vector<double> shift(n, 0.0);
+
+    for (std::size_t i = 0; i < n; i++) {
+        for (std::size_t m = 0; m < M; m++) price[i][m] = index.price(i, complete[m]);
+        for (std::size_t m = 1; m < M; m++) ret[i][m] = std::log(price[i][m] / price[i][m - 1]);
+        // centre the running sums to keep them well conditioned
+        if (M > 1) {
+            for (std::size_t m = 1; m < M; m++) shift[i] += ret[i][m];
+            shift[i] /= (M - 1);
+        }
+    }
+
+    // ---- 2. Backtest dates: position t needs >= 2 returns behind it and t + h ahead ----
+    int from = parse_date(spec.from_date);
+    int to = parse_date(spec.to_date);
+    if (from < 0 || to < 0)
+        throw std::runtime_error("run_backtest: invalid date range");
+
+    std::vector<std::size_t> dates;
+    for (std::size_t t = 0; t + h < M; t++) {
+        int d = index.dates()[complete[t]];
+        if (d < from || d > to) continue;
+        if (std::min(L, t) < 3) continue;
+        dates.push_back(t);
+    }
+    if (dates.empty())
+        throw std::runtime_error("run_backtest: no usable dates in range");
+
+    // ---- 3. Evaluate contiguous chunks in parallel, rolling the calibration ----
+    BacktestResult res;
+    res.rows.resize(dates.size());
+    res.expected_rate = 1.0 - spec.confidence;
+
+    int workers = resolve_thread_count(spec.threads);
+    std::size_t chunks = std::min<std::size_t>(dates.size(), std::size_t(workers) * 2);
+    std::size_t per_chunk = (dates.size() + chunks - 1) / chunks;
+
+    parallel_for(chunks, workers, [&](std::size_t c) {
+        std::size_t lo = c * per_chunk;
+        std::size_t hi = std::min(dates.size(), lo + per_chunk);
+        if (lo >= hi) return;
+
+        RollingCalibrator calib(ret, shift);
+        // returns of the window behind t are r[m] for m in [t - L + 1, t - 1]
+        std::size_t win_lo = 0, win_hi = 0;   // current window [win_lo, win_hi)
+
+        MarketSnapshot snap;
+        snap.tickers = tickers;
+        std::vector<double> spot(n), future(n);
+
+        for (std::size_t k = lo; k < hi; k++) {
+            std::size_t t = dates[k];
+            std::size_t want_lo = (t >= L ? t - L : 0) + 1;
+            std::size_t want_hi = t;
+
+            if (k == lo || want_lo >= win_hi) {
+                calib.reset();
+                for (std::size_t m = want_lo; m < want_hi; m++) calib.add(m, +1.0);
+            } else {
+                for (std::size_t m = win_hi; m < want_hi; m++) calib.add(m, +1.0);
+                for (std::size_t m = win_lo; m < want_lo; m++) calib.add(m, -1.0);
+            }
+            win_lo = want_lo;
+            win_hi = want_hi;
+
+            calib.fill(snap);
+            for (std::size_t i = 0; i < n; i++) {
+                spot[i] = price[i][t];
+                future[i] = price[i][t + h];
+                snap.spot[tickers[i]] = spot[i];
+            }
+
+            BacktestRow& row = res.rows[k];
+            row.date = format_date(index.dates()[complete[t]]);
+
+            MonteCarloEngine mc(snap, portfolio, spec.horizon_days);
+            mc.compute(spec.scenarios, spec.confidence, row.var, row.es);
+
+            PortfolioRevaluer revaluer(portfolio, tickers, spot);
+            row.portfolio_value = revaluer.base_value();
+            row.realized_loss = -revaluer.pnl(future.data());
+            row.exception = row.realized_loss > row.var;
+        }
+    });
+
+    // ---- 4. Exception statistics ----
+    std::vector<bool> hits;
+    hits.reserve(res.rows.size());
+    for (const auto& row : res.rows) {
+        hits.push_back(row.exception);
+        if (row.exception) res.exceptions++;
+    }
+
+    res.exception_rate = double(res.exceptions) / res.rows.size();
+    res.kupiec = kupiec_test(res.exceptions, res.rows.size(), res.expected_rate);
+    res.independence = christoffersen_independence_test(hits);
+    res.conditional.lr = res.kupiec.lr + res.independence.lr;
+    res.conditional.p_value = chi2_p_value(res.conditional.lr, 2);
+
+    return res;
+}
+
+void write_backtest_csv(const BacktestResult& result, const std::string& file)
+{
+    std::ofstream out(file);
+    if (!out.is_open())
+        throw std::runtime_error("Cannot open backtest output: " + file);
+
+    out << "date,portfolio_value,var,es,realized_loss,exception\n";
+    for (const auto& r : result.rows) {
+        out << r.date << "," << r.portfolio_value << "," << r.var << ","
+            << r.es << "," << r.realized_loss << "," << (r.exception ? 1 : 0) << "\n";
+    }
+}
@@ -0,0 +1,232 @@
+#include "batch_runner.hpp"
+#include "bounded_queue.hpp"
+#include "cholesky.hpp"
+#include "market_data_history.hpp"
+#include "market_snapshot.hpp"
+#include "monte_carlo.hpp"
+#include "portfolio.hpp"
+#include "profiler.hpp"
+#include "task_scheduler.hpp"
+#include "trading_day_utils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// A job travelling through the pipeline.
+struct BatchItem {
+    BatchRow row;
+    Portfolio portfolio;
+    std::vector<std::string> tickers;
+    MarketSnapshot snapshot;
+    std::vector<std::vector<double>> cholesky_factor;
+};
+
+using ItemPtr = std::unique_ptr<BatchItem>;
+using ItemQueue = BoundedQueue<ItemPtr>;
+
+double elapsed(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Runs `step` on every item from `in` (skipping failed ones), forwards
+// items to `out` and accumulates busy time. The last worker of a stage
+// closes `out`.
+void run_stage(ItemQueue& in, ItemQueue& out, std::atomic<int>& workers_left,
+               std::atomic<double>& busy, const std::function<void(BatchItem&)>& step) {
+    double mine = 0.0;
+    while (auto item = in.pop()) {
+        auto t0 = std::chrono::steady_clock::now();
+        BatchItem& it = **item;
+        if (it.row.error.empty()) {
+            try {
+                step(it);
+            } catch (const std::exception& e) {
+                it.row.error = e.what();
+            }
+        }
+        mine += elapsed(t0);
+        if (!out.push(std::move(*item))) break;
+    }
+
+    double cur = busy.load();
+    while (!busy.compare_exchange_weak(cur, cur + mine)) {}
+    if (--workers_left == 0) out.close();
+}
+
+void write_header(std::ofstream& out) {
+    out << "index,portfolio,requested_date,date,portfolio_value,var,es,error\n";
+}
+
+void write_row(std::ofstream& out, const BatchRow& r) {
+    std::string error = r.error;
+    std::replace(error.begin(), error.end(), ',', ';');
+    std::replace(error.begin(), error.end(), '\n', ' ');
+    out << r.index << "," << r.portfolio << "," << r.requested_date << "," << r.date << ","
+        << r.portfolio_value << "," << r.var << "," << r.es << "," << error << "\n";
+}
+
+} // namespace
+
+std::vector<BatchJob> read_batch_jobs(const std::string& file) {
+    std::ifstream f(file);
+    if (!f.is_open())
+        throw std::runtime_error("Cannot open batch file: " + file);
+
+    std::vector<BatchJob> jobs;
+    std::string line;
+    std::size_t line_no = 0;
+    while (std::getline(f, line)) {
+        line_no++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        auto comma = line.find(',');
+        if (comma == std::string::npos)
+            throw std::runtime_error(file + ":" + std::to_string(line_no) + ": expected portfolio,date");
+
+        BatchJob job{line.substr(0, comma), line.substr(comma + 1)};
+        if (parse_date(job.date) < 0) {
+            if (jobs.empty() && line_no == 1) continue; // header
+            throw std::runtime_error(file + ":" + std::to_string(line_no) + ": invalid date " + job.date);
+        }
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
+
+BatchResult run_batch(const MarketDataHistory& history,
+                      const std::vector<BatchJob>& jobs,
+                      const BatchSpec& spec,
+                      const std::string& out_csv)
+{
+    PROFILE_SCOPE("batch");
+    auto t_start = std::chrono::steady_clock::now();
+
+    std::ofstream out;
+    if (!out_csv.empty()) {
+        out.open(out_csv);
+        if (!out.is_open())
+            throw std::runtime_error("Cannot open batch output: " + out_csv);
+        write_header(out);
+    }
+
+    // simulators run their scenario blocks on the shared scheduler; each
+    // engine gets an equal slice of it, less what the calibrators occupy
+    int cal_threads = std::max(1, spec.calibration_threads);
+    int sim_threads = std::max(1, spec.simulation_threads);
+    int pool = static_cast<int>(TaskScheduler::global().concurrency());
+    int engine_threads = std::max(1, (pool - cal_threads) / sim_threads);
+
+    ItemQueue loaded(spec.queue_capacity), calibrated(spec.queue_capacity),
+              factorized(spec.queue_capacity), simulated(spec.queue_capacity);
+
+    std::atomic<double> load_busy{0.0}, calibrate_busy{0.0}, factorize_busy{0.0},
+                        simulate_busy{0.0};
+    std::atomic<int> calibrate_left{cal_threads}, factorize_left{1}, simulate_left{sim_threads};
+
+    BatchResult result;
+    result.rows.resize(jobs.size());
+
+    // ---- load: portfolio file + date alignment ----
+    std::thread loader([&] {
+        double busy = 0.0;
+        for (std::size_t i = 0; i < jobs.size(); i++) {
+            auto t0 = std::chrono::steady_clock::now();
+            auto item = std::make_unique<BatchItem>();
+            item->row.index = i;
+            item->row.portfolio = jobs[i].portfolio;
+            item->row.requested_date = jobs[i].date;
+            try {
+                item->portfolio.load(jobs[i].portfolio, 1);
+                for (const auto& name : item->portfolio.tickers) {
+                    if (!history.has_ticker(name))
+                        throw std::runtime_error("no history for ticker " + name);
+                }
+                item->tickers = item->portfolio.tickers;
+                int target = parse_date(jobs[i].date);
+                if (target < 0) throw std::runtime_error("invalid date " + jobs[i].date);
+                item->row.date = format_date(history.calendar().previous_common_date(target));
+            } catch (const std::exception& e) {
+                item->row.error = e.what();
+            }
+            busy += elapsed(t0);
+            if (!loaded.push(std::move(item))) break;
+        }
+        load_busy = busy;
+        loaded.close();
+    });
+
+    // ---- calibrate ----
+    std::vector<std::thread> calibrators;
+    for (int t = 0; t < cal_threads; t++) {
+        calibrators.emplace_back([&] {
+            run_stage(loaded, calibrated, calibrate_left, calibrate_busy, [&](BatchItem& it) {
+                it.snapshot = build_snapshot(history, it.tickers, it.row.date, spec.lookback_days);
+            });
+        });
+    }
+
+    // ---- factorize ----
+    std::thread factorizer([&] {
+        run_stage(calibrated, factorized, factorize_left, factorize_busy, [&](BatchItem& it) {
+            it.cholesky_factor = cholesky(it.snapshot.corr);
+        });
+    });
+
+    // ---- simulate ----
+    std::vector<std::thread> simulators;
+    for (int t = 0; t < sim_threads; t++) {
+        simulators.emplace_back([&] {
+            // one engine per simulator, rebound per job: its scenario
+            // workspace is reused across the whole batch
+            MonteCarloEngine mc(spec.horizon_days);
+            mc.set_threads(engine_threads);
+            run_stage(factorized, simulated, simulate_left, simulate_busy, [&](BatchItem& it) {
+                mc.bind_market(it.snapshot, it.cholesky_factor);
+                mc.bind_portfolio(it.portfolio);
+                mc.compute(spec.scenarios, spec.confidence, it.row.var, it.row.es);
+                it.row.portfolio_value = mc.base_value();
+                it.cholesky_factor = {};
+
+                // the snapshot and book are no longer needed downstream
+                it.snapshot = MarketSnapshot();
+                it.portfolio = Portfolio();
+            });
+        });
+    }
+
+    // ---- write (this thread) ----
+    double write_busy = 0.0;
+    while (auto item = simulated.pop()) {
+        auto t0 = std::chrono::steady_clock::now();
+        BatchRow& row = (*item)->row;
+        if (out.is_open()) {
+            write_row(out, row);
+            out.flush();
+        }
+        if (!row.error.empty()) result.failed++;
+        result.rows[row.index] = std::move(row);
+        write_busy += elapsed(t0);
+    }
+
+    loader.join();
+    for (auto& t : calibrators) t.join();
+    factorizer.join();
+    for (auto& t : simulators) t.join();
+
+    result.load_seconds = load_busy;
+    result.calibrate_seconds = calibrate_busy;
+    result.factorize_seconds = factorize_busy;
+    result.simulate_seconds = simulate_busy;
+    result.write_seconds = write_busy;
+    result.seconds = elapsed(t_start);
+    return result;
+}
@@ -0,0 +1,130 @@
+#include "bootstrap.hpp"
+#include "market_data_history.hpp"
+#include "parallel.hpp"
+#include "portfolio.hpp"
+#include "price_index.hpp"
+#include "profiler.hpp"
+#include "revaluation.hpp"
+#include "risk_measures.hpp"
+#include "trading_day_utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+// scenarios generated per task
+static const std::size_t BOOT_BLOCK = 1024;
+
+BootstrapResult compute_bootstrap_var(
+    const Portfolio& portfolio,
+    const MarketDataHistory& history,
+    const std::string& snapshot_date,
+    const BootstrapSpec& spec)
+{
+    PROFILE_SCOPE("bootstrap_var");
+
+    if (spec.horizon_days < 1 || spec.block_length < 1 || spec.scenarios < 1)
+        throw std::runtime_error("compute_bootstrap_var: horizon, block length and scenarios must be positive");
+
+    const std::vector<std::string>& tickers = portfolio.tickers;
+    if (tickers.empty())
+        throw std::runtime_error("compute_bootstrap_var: empty portfolio");
+
+    const std::size_t n = tickers.size();
+    PriceIndex index(history, tickers);
+    const auto& complete = index.complete_dates();
+
+    int snap_k = index.previous_complete_index(parse_date(snapshot_date));
+    if (snap_k < 0)
+        throw std::runtime_error("compute_bootstrap_var: no prices on or before " + snapshot_date);
+
+    std::size_t t0 = std::lower_bound(complete.begin(), complete.end(), (std::size_t)snap_k)
+                     - complete.begin();
+    std::size_t first = t0 > (std::size_t)spec.lookback_days ? t0 - spec.lookback_days : 0;
+
+    // ---- 1. Days × assets matrix of daily log returns in the window ----
+    const std::size_t T = t0 - first;   // returns ending at first+1 .. t0
+    const std::size_t b = spec.block_length;
+    if (T < b)
+        throw std::runtime_error("compute_bootstrap_var: not enough history for one block");
+
+    std::vector<double> spot(n);
+    std::vector<double> R(T * n);
+    for (std::size_t i = 0; i < n; i++) {
+        const double* col = index.column(i);
+        for (std::size_t d = 0; d < T; d++) {
+            R[d * n + i] = std::log(col[complete[first + d + 1]] / col[complete[first + d]]);
+        }
+        spot[i] = col[complete[t0]];
+    }
+
+    // ---- 2. Optional volatility filter (EWMA, RiskMetrics style) ----
+    if (spec.filtered) {
+        const double lambda = spec.ewma_lambda;
+        for (std::size_t i = 0; i < n; i++) {
+            // seed the recursion with the window variance
+            double var0 = 0.0;
+            for (std::size_t d = 0; d < T; d++) var0 += R[d * n + i] * R[d * n + i];
+            var0 = std::max(var0 / T, 1e-16);
+
+            std::vector<double> vol(T);
+            double v = var0;
+            for (std::size_t d = 0; d < T; d++) {
+                vol[d] = std::sqrt(v);   // forecast for day d from days < d
+                double r = R[d * n + i];
+                v = lambda * v + (1.0 - lambda) * r * r;
+            }
+            double vol_now = std::sqrt(v);
+            for (std::size_t d = 0; d < T; d++)
+                R[d * n + i] *= vol_now / vol[d];
+        }
+    }
+
+    // ---- 3. Prefix sums: block return = P[start + len] - P[start] ----
+    std::vector<double> P((T + 1) * n, 0.0);
+    for (std::size_t d = 0; d < T; d++) {
+        for (std::size_t i = 0; i < n; i++)
+            P[(d + 1) * n + i] = P[d * n + i] + R[d * n + i];
+    }
+
+    // ---- 4. Resample, revalue, collect P&L ----
+    PortfolioRevaluer revaluer(portfolio, tickers, spot);
+    const std::size_t scenarios = spec.scenarios;
+    const std::size_t h = spec.horizon_days;
+    std::vector<double> pnl(scenarios);
+
+    std::size_t blocks = (scenarios + BOOT_BLOCK - 1) / BOOT_BLOCK;
+    parallel_for(blocks, spec.threads, [&](std::size_t blk) {
+        std::seed_seq seq{spec.seed, static_cast<std::uint64_t>(blk)};
+        std::mt19937_64 rng(seq);
+        std::uniform_int_distribution<std::size_t> start(0, T - b);
+
+        std::vector<double> acc(n), prices(n);
+        std::size_t lo = blk * BOOT_BLOCK;
+        std::size_t hi = std::min(scenarios, lo + BOOT_BLOCK);
+
+        for (std::size_t s = lo; s < hi; s++) {
+            std::fill(acc.begin(), acc.end(), 0.0);
+
+            for (std::size_t covered = 0; covered < h; covered += b) {
+                std::size_t len = std::min(b, h - covered);
+                std::size_t d0 = start(rng);
+                const double* p0 = &P[d0 * n];
+                const double* p1 = &P[(d0 + len) * n];
+                for (std::size_t i = 0; i < n; i++) acc[i] += p1[i] - p0[i];
+            }
+
+            for (std::size_t i = 0; i < n; i++) prices[i] = spot[i] * std::exp(acc[i]);
+            pnl[s] = revaluer.pnl(prices.data());
+        }
+    });
+
+    BootstrapResult res;
+    res.portfolio_value = revaluer.base_value();
+    res.history_days = T;
+    res.snapshot_date = format_date(index.dates()[snap_k]);
+    PROFILE_COUNT("bootstrap.scenarios", scenarios);
+    tail_risk(pnl.data(), scenarios, spec.confidence, res.var, res.es);
+    return res;
+}
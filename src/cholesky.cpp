@@ -1,8 +1,11 @@
 #include "cholesky.hpp"
+#include "profiler.hpp"
 #include <cmath>
 #include <stdexcept>
 
 std::vector<std::vector<double>> cholesky(const std::vector<std::vector<double>>& A) {
+    PROFILE_SCOPE("cholesky");
+
     int n = A.size();
     std::vector<std::vector<double>> L(n, std::vector<double>(n, 0.0));
 
@@ -0,0 +1,42 @@
+#include <iostream>
+
+#include "market_data_history.hpp"
+#include "history_binary.hpp"
+
+// Converts a directory of Yahoo-style CSV files into a binary history
+// file that risk_engine can memory-map via --history <file>.
+int main(int argc, char** argv){
+
+    if (argc < 3) {
+        std::cerr << "Usage: convert_history <history_dir> <output.bin> [--threads N]\n";
+        return 1;
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    int threads = 0;
+
+    for (int i = 3; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--threads") threads = std::stoi(argv[++i]);
+    }
+
+    try {
+        MarketDataHistory history;
+        HistoryLoadStats stats = history.load_directory(input, threads);
+
+        std::cout << "Parsed " << stats.rows << " rows from " << stats.files
+                  << " files in " << stats.seconds << " s\n";
+
+        std::size_t bytes = write_history_binary(history, output);
+
+        std::cout << "Binary history saved: " << output
+                  << " (" << bytes << " bytes)\n";
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "ERROR: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include "counter_rng.hpp"
+
+#include <bit>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr double HALF_ULP_52 = 1.0 / 9007199254740992.0;   // 2^-53
+
+// 52 random bits -> (0, 1): they become the mantissa of a double in
+// [1, 2) (no integer -> double conversion, which SSE2 cannot vectorize);
+// the half-step offset excludes both ends so log() never sees 0.
+inline double to_unit(std::uint32_t hi, std::uint32_t lo) {
+    std::uint64_t x = ((std::uint64_t(hi) << 32) | lo) >> 12;
+    return std::bit_cast<double>(x | 0x3ff0000000000000ULL) - (1.0 - HALF_ULP_52);
+}
+
+// Uniform pairs [first_pair, first_pair + pairs) of one stream into out.
+// Counters are processed LANES at a time as structure-of-arrays, so each
+// Philox round is a handful of independent 32x32->64 multiplies and xors
+// per lane that the compiler maps onto SIMD registers.
+void uniform_pairs(std::uint64_t seed, std::uint64_t stream,
+                   std::uint64_t first_pair, std::size_t pairs, double* out) {
+    constexpr std::size_t LANES = 32;
+    const Philox4x32::Key key = Philox4x32::key(seed);
+    const std::uint32_t s_lo = std::uint32_t(stream), s_hi = std::uint32_t(stream >> 32);
+
+    std::size_t j = 0;
+    for (; j + LANES <= pairs; j += LANES) {
+        std::uint32_t c0[LANES], c1[LANES], c2[LANES], c3[LANES];
+        for (std::size_t l = 0; l < LANES; l++) {
+            std::uint64_t p = first_pair + j + l;
+            c0[l] = std::uint32_t(p);
+            c1[l] = std::uint32_t(p >> 32);
+            c2[l] = s_lo;
+            c3[l] = s_hi;
+        }
+        std::uint32_t k0 = key[0], k1 = key[1];
+        for (int r = 0; r < 10; r++) {
+            for (std::size_t l = 0; l < LANES; l++) {
+                std::uint64_t p0 = std::uint64_t(Philox4x32::M0) * c0[l];
+                std::uint64_t p1 = std::uint64_t(Philox4x32::M1) * c2[l];
+                std::uint32_t n0 = std::uint32_t(p1 >> 32) ^ c1[l] ^ k0;
+                std::uint32_t n2 = std::uint32_t(p0 >> 32) ^ c3[l] ^ k1;
+                c1[l] = std::uint32_t(p1);
+                c3[l] = std::uint32_t(p0);
+                c0[l] = n0;
+                c2[l] = n2;
+            }
+            k0 += Philox4x32::W0;
+            k1 += Philox4x32::W1;
+        }
+        for (std::size_t l = 0; l < LANES; l++) {
+            out[2 * (j + l)] = to_unit(c0[l], c1[l]);
+            out[2 * (j + l) + 1] = to_unit(c2[l], c3[l]);
+        }
+    }
+
+    for (; j < pairs; j++) {
+        std::uint64_t p = first_pair + j;
+        Philox4x32::Counter c = Philox4x32::block(
+            {std::uint32_t(p), std::uint32_t(p >> 32), s_lo, s_hi}, key);
+        out[2 * j] = to_unit(c[0], c[1]);
+        out[2 * j + 1] = to_unit(c[2], c[3]);
+    }
+}
+
+// ---- branch-free log / sincos for the Box-Muller loop ----
+//
+// libm calls cannot be vectorized (and std::sin/std::cos each do a full
+// argument reduction), so the transform uses the fdlibm log kernel and
+// the Cephes sin/cos kernels on [-pi/4, pi/4]. Both are accurate to about
+// one ulp; the arguments are known to be in range (u in (0, 1)), which is
+// what makes branch-free versions possible.
+
+constexpr std::uint64_t SQRT_HALF_BITS = 0x3fe6a09e00000000ULL;   // ~sqrt(1/2)
+constexpr double LN2_HI = 6.93147180369123816490e-01;
+constexpr double LN2_LO = 1.90821492927058770002e-10;
+constexpr double PI_2 = 1.57079632679489661923;
+constexpr double TWO_52 = 4503599627370496.0;
+constexpr double ROUND_MAGIC = 6755399441055744.0;   // 1.5 * 2^52
+
+inline std::uint64_t bits_of(double x) { return std::bit_cast<std::uint64_t>(x); }
+inline double from_bits(std::uint64_t b) { return std::bit_cast<double>(b); }
+
+// Picks a where mask is all ones, b where it is zero.
+inline double select(std::uint64_t mask, double a, double b) {
+    return from_bits((bits_of(a) & mask) | (bits_of(b) & ~mask));
+}
+
+// log(u) for a normal positive u.
+inline double log_kernel(double u) {
+    // split u = 2^e · m with m in [sqrt(1/2), sqrt(2)) using integer ops
+    // only: offsetting the bits moves the exponent boundary to sqrt(1/2)
+    std::uint64_t b = bits_of(u) + (0x3ff0000000000000ULL - SQRT_HALF_BITS);
+    double e = from_bits(0x4330000000000000ULL | (b >> 52)) - (TWO_52 + 1023.0);
+    double m = from_bits((b & 0x000fffffffffffffULL) + SQRT_HALF_BITS);
+
+    double f = m - 1.0;
+    double hfsq = 0.5 * f * f;
+    double s = f / (2.0 + f);
+    double z = s * s;
+    double w = z * z;
+    double t1 = w * (3.999999999940941908e-01 + w * (2.222219843214978396e-01 +
+                w * 1.531383769920937332e-01));
+    double t2 = z * (6.666666666666735130e-01 + w * (2.857142874366239149e-01 +
+                w * (1.818357216161805012e-01 + w * 1.479819860511658591e-01)));
+    double r = t1 + t2;
+    return e * LN2_HI - ((hfsq - (s * (hfsq + r) + e * LN2_LO)) - f);
+}
+
+// sin and cos of 2·pi·u for u in (0, 1).
+inline void sincos_turns(double u, double& sin_out, double& cos_out) {
+    // quarter turns: 4u = q + f with q = round(4u), f in [-1/2, 1/2];
+    // adding 1.5·2^52 rounds to an integer whose low bits are q
+    double v = 4.0 * u;
+    double shifted = v + ROUND_MAGIC;
+    std::uint64_t q = bits_of(shifted);
+    double x = (v - (shifted - ROUND_MAGIC)) * PI_2;
+    double z = x * x;
+
+    double sn = x + x * z * (-1.66666666666666307295e-1 + z * (8.33333333332211858878e-3 +
+                z * (-1.98412698295895385996e-4 + z * (2.75573136213857245213e-6 +
+                z * (-2.50507477628578072866e-8 + z * 1.58962301576546568060e-10)))));
+    double cs = 1.0 - 0.5 * z + z * z * (4.16666666666665929218e-2 + z * (-1.38888888888730564116e-3 +
+                z * (2.48015872888517045348e-5 + z * (-2.75573141792967388112e-7 +
+                z * (2.08757008419747316778e-9 + z * -1.13585365213876817300e-11)))));
+
+    // rotate by q quarter turns: odd q swaps sin/cos, then sign flips
+    std::uint64_t swap = -(q & 1);
+    double a = select(swap, cs, sn);
+    double c = select(swap, sn, cs);
+    sin_out = from_bits(bits_of(a) ^ ((q & 2) << 62));
+    cos_out = from_bits(bits_of(c) ^ (((q + 1) & 2) << 62));
+}
+
+// In-place Box-Muller over m uniform pairs.
+void box_muller(double* u, std::size_t m) {
+    for (std::size_t j = 0; j < m; j++) {
+        double r = std::sqrt(-2.0 * log_kernel(u[2 * j]));
+        double s, c;
+        sincos_turns(u[2 * j + 1], s, c);
+        u[2 * j] = r * c;
+        u[2 * j + 1] = r * s;
+    }
+}
+
+} // namespace
+
+void fill_uniform(std::uint64_t seed, std::uint64_t stream, double* out, std::size_t n) {
+    std::size_t full = n / 2;
+    uniform_pairs(seed, stream, 0, full, out);
+    if (n % 2) {
+        double tail[2];
+        uniform_pairs(seed, stream, full, 1, tail);
+        out[n - 1] = tail[0];
+    }
+}
+
+void fill_normal(std::uint64_t seed, std::uint64_t stream, double* out, std::size_t n) {
+    fill_normal_streams(seed, stream, 1, n, out);
+}
+
+void fill_normal_streams(std::uint64_t seed, std::uint64_t first_stream,
+                         std::size_t streams, std::size_t per_stream, double* out)
+{
+    if (streams == 0 || per_stream == 0) return;
+    const std::size_t pairs = (per_stream + 1) / 2;
+
+    if (per_stream % 2 == 0) {
+        // rows are whole pairs: generate and transform in place
+        for (std::size_t k = 0; k < streams; k++)
+            uniform_pairs(seed, first_stream + k, 0, pairs, out + k * per_stream);
+        box_muller(out, streams * pairs);
+        return;
+    }
+
+    // odd rows: work on padded rows, then drop each row's last sine
+    thread_local std::vector<double> scratch;
+    const std::size_t stride = 2 * pairs;
+    scratch.resize(streams * stride);
+    for (std::size_t k = 0; k < streams; k++)
+        uniform_pairs(seed, first_stream + k, 0, pairs, scratch.data() + k * stride);
+    box_muller(scratch.data(), streams * pairs);
+    for (std::size_t k = 0; k < streams; k++) {
+        const double* src = scratch.data() + k * stride;
+        double* dst = out + k * per_stream;
+        for (std::size_t i = 0; i < per_stream; i++) dst[i] = src[i];
+    }
+}
@@ -1,9 +1,8 @@
 #include "djia_builder.hpp"
+#include "index_builder.hpp"
 #include "market_data_history.hpp"
 
-#include <fstream>
 #include <iostream>
-#include <unordered_map>
 #include <filesystem>
 
 namespace fs = std::filesystem;
@@ -15,39 +14,41 @@ static const std::vector<std::string> DJIA_TICKERS = {
     "MMM","CVX","PG","WMT","DIS","MRK","CSCO","KO","NKE","VZ"
 };
 
+const std::vector<std::string>& djia_tickers()
+{
+    return DJIA_TICKERS;
+}
+
 // ---------------------------------------------------------------------
-// Helper: read Close price for given date from a Yahoo CSV file
+// Generate the DJIA portfolio CSV from an already-loaded history
 // ---------------------------------------------------------------------
-static double read_price_yahoo(const std::string& file, const std::string& target_date)
+bool build_djia_portfolio(const MarketDataHistory& history, const DjiaPortfolioSpec& spec)
 {
-    std::ifstream f(file);
-    if (!f.is_open())
-        throw std::runtime_error("Cannot open history file: " + file);
-
-    std::string line;
-    std::getline(f, line); // skip header
-
-    while (std::getline(f, line))
+    IndexPortfolioSpec index_spec;
+    index_spec.universe = DJIA_TICKERS;
+    index_spec.weighting = WeightingScheme::PRICE;
+    index_spec.portfolio_value = spec.portfolio_value;
+
+    std::vector<IndexPortfolio> built;
+    try {
+        built = build_index_portfolios(history, index_spec, {spec.snapshot_date}, 1);
+    }
+    catch (const std::exception& ex)
     {
-        if (line.size() < 10) continue;
-
-        // Extract date (first column)
-        std::string date = line.substr(0, 10);
-        if (date == target_date)
-        {
-            // Yahoo format: Date,Open,High,Low,Close,Adj Close,Volume
-            //               0    1     2    3    4     5          6
-            size_t p1 = line.find(',', 11);
-            size_t p2 = line.find(',', p1 + 1);
-            size_t p3 = line.find(',', p2 + 1);
-            size_t p4 = line.find(',', p3 + 1);
+        std::cerr << "Error building DJIA portfolio: " << ex.what() << "\n";
+        return false;
+    }
 
-            std::string close_str = line.substr(p3 + 1, p4 - p3 - 1);
-            return std::stod(close_str);
-        }
+    try {
+        built[0].portfolio.save(spec.output_file);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << "\n";
+        return false;
     }
 
-    throw std::runtime_error("No price for " + file + " at date " + target_date);
+    return true;
 }
 
 // ---------------------------------------------------------------------
@@ -61,49 +62,18 @@ bool build_djia_portfolio(const DjiaPortfolioSpec& spec)
         return false;
     }
 
-    std::unordered_map<std::string,double> price;
-    double total_sum = 0.0;
-
-    // Load prices for each ticker
-    for (const auto& t : DJIA_TICKERS)
-    {
-        std::string file = spec.history_dir + "/" + t + ".csv";
+    HistoryFilter filter;
+    filter.tickers.insert(DJIA_TICKERS.begin(), DJIA_TICKERS.end());
 
-        try {
-            double p = read_price_yahoo(file, spec.snapshot_date);
-            price[t] = p;
-            total_sum += p;
-        }
-        catch (const std::exception& ex)
-        {
-            std::cerr << "Error reading " << t << ": " << ex.what() << "\n";
-            return false;
-        }
+    MarketDataHistory history;
+    try {
+        history.load_directory(spec.history_dir, filter);
     }
-
-    // Compute quantities
-    std::unordered_map<std::string,int> qty;
-    for (const auto& t : DJIA_TICKERS)
+    catch (const std::exception& ex)
     {
-        double weight = price[t] / total_sum;
-        double alloc  = spec.portfolio_value * weight;
-
-        qty[t] = static_cast<int>(alloc / price[t]);
-    }
-
-    // Save portfolio CSV
-    std::ofstream out(spec.output_file);
-    if (!out.is_open()) {
-        std::cerr << "Cannot open output: " << spec.output_file << "\n";
+        std::cerr << "Error reading history: " << ex.what() << "\n";
         return false;
     }
 
-    out << "type,ticker,quantity,strike,maturity,option_type\n";
-
-    for (const auto& t : DJIA_TICKERS)
-    {
-        out << "STOCK," << t << "," << qty[t] << ",,,\n";
-    }
-
-    return true;
+    return build_djia_portfolio(history, spec);
 }
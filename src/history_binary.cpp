@@ -0,0 +1,160 @@
+#include "history_binary.hpp"
+#include "market_data_history.hpp"
+#include "trading_day_utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+static const char HISTORY_MAGIC[8] = {'M','C','R','H','I','S','T','1'};
+static const std::uint32_t HISTORY_VERSION = 1;
+
+static std::uint64_t align8(std::uint64_t x) {
+    return (x + 7) & ~std::uint64_t(7);
+}
+
+void HistoryBinaryFile::open(const std::string& path) {
+    if (!file.open(path))
+        throw std::runtime_error("Cannot open binary history: " + path);
+
+    if (file.size() < sizeof(HistoryBinaryHeader))
+        throw std::runtime_error("Binary history too small: " + path);
+
+    header = reinterpret_cast<const HistoryBinaryHeader*>(file.data());
+    if (std::memcmp(header->magic, HISTORY_MAGIC, sizeof(HISTORY_MAGIC)) != 0)
+        throw std::runtime_error("Not a binary history file: " + path);
+    if (header->version != HISTORY_VERSION)
+        throw std::runtime_error("Unsupported binary history version in " + path);
+    if (header->file_size != file.size())
+        throw std::runtime_error("Binary history truncated: " + path);
+
+    std::uint64_t index_end = header->index_offset
+        + std::uint64_t(header->n_tickers) * sizeof(HistoryBinaryTicker);
+    if (header->calendar_offset + std::uint64_t(header->n_dates) * 4 > file.size()
+        || index_end > file.size())
+        throw std::runtime_error("Corrupt binary history header: " + path);
+
+    calendar = reinterpret_cast<const std::int32_t*>(file.data() + header->calendar_offset);
+    index = reinterpret_cast<const HistoryBinaryTicker*>(file.data() + header->index_offset);
+
+    for (std::size_t i = 0; i < header->n_tickers; i++) {
+        const auto& t = index[i];
+        if (std::uint64_t(t.first_date) + t.count > header->n_dates
+            || t.offset + std::uint64_t(t.count) * sizeof(double) > file.size())
+            throw std::runtime_error("Corrupt binary history column: " + path);
+    }
+}
+
+std::string HistoryBinaryFile::ticker_name(std::size_t i) const {
+    const char* n = index[i].name;
+    return std::string(n, strnlen(n, sizeof(index[i].name)));
+}
+
+const double* HistoryBinaryFile::column(std::size_t i) const {
+    return reinterpret_cast<const double*>(file.data() + index[i].offset);
+}
+
+std::size_t write_history_binary(const MarketDataHistory& history, const std::string& path)
+{
+    if (history.mapped()) {
+        // the writer walks the string maps
+        MarketDataHistory copy = history;
+        copy.materialize_prices();
+        return write_history_binary(copy, path);
+    }
+
+    // ---- 1. Union calendar ----
+    std::vector<std::int32_t> calendar;
+    for (const auto& [ticker, series] : history.prices) {
+        for (const auto& [d, _] : series) {
+            int key = parse_date(d);
+            if (key < 0)
+                throw std::runtime_error("Invalid date '" + d + "' for " + ticker);
+            calendar.push_back(key);
+        }
+    }
+    std::sort(calendar.begin(), calendar.end());
+    calendar.erase(std::unique(calendar.begin(), calendar.end()), calendar.end());
+
+    std::vector<std::string> tickers;
+    for (const auto& [ticker, _] : history.prices) tickers.push_back(ticker);
+    std::sort(tickers.begin(), tickers.end());
+
+    // ---- 2. Layout ----
+    HistoryBinaryHeader header{};
+    std::memcpy(header.magic, HISTORY_MAGIC, sizeof(HISTORY_MAGIC));
+    header.version = HISTORY_VERSION;
+    header.n_dates = static_cast<std::uint32_t>(calendar.size());
+    header.n_tickers = static_cast<std::uint32_t>(tickers.size());
+    header.calendar_offset = align8(sizeof(HistoryBinaryHeader));
+    header.index_offset = align8(header.calendar_offset + calendar.size() * 4);
+    header.data_offset = align8(header.index_offset + tickers.size() * sizeof(HistoryBinaryTicker));
+
+    std::vector<HistoryBinaryTicker> index(tickers.size());
+    std::uint64_t offset = header.data_offset;
+
+    for (std::size_t i = 0; i < tickers.size(); i++) {
+        const auto& name = tickers[i];
+        if (name.size() >= sizeof(index[i].name))
+            throw std::runtime_error("Ticker name too long for binary history: " + name);
+
+        std::memset(index[i].name, 0, sizeof(index[i].name));
+        std::memcpy(index[i].name, name.data(), name.size());
+
+        const auto& series = history.prices.at(name);
+        if (series.empty()) {
+            index[i].first_date = 0;
+            index[i].count = 0;
+        } else {
+            int first = parse_date(series.begin()->first);
+            int last = parse_date(series.rbegin()->first);
+            auto lo = std::lower_bound(calendar.begin(), calendar.end(), first) - calendar.begin();
+            auto hi = std::lower_bound(calendar.begin(), calendar.end(), last) - calendar.begin();
+            index[i].first_date = static_cast<std::uint32_t>(lo);
+            index[i].count = static_cast<std::uint32_t>(hi - lo + 1);
+        }
+        index[i].offset = offset;
+        offset += std::uint64_t(index[i].count) * sizeof(double);
+    }
+    header.file_size = offset;
+
+    // ---- 3. Write ----
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+        throw std::runtime_error("Cannot write binary history: " + path);
+
+    auto pad_to = [&](std::uint64_t pos) {
+        static const char zeros[8] = {};
+        std::uint64_t cur = static_cast<std::uint64_t>(out.tellp());
+        out.write(zeros, static_cast<std::streamsize>(pos - cur));
+    };
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad_to(header.calendar_offset);
+    out.write(reinterpret_cast<const char*>(calendar.data()),
+              static_cast<std::streamsize>(calendar.size() * 4));
+    pad_to(header.index_offset);
+    out.write(reinterpret_cast<const char*>(index.data()),
+              static_cast<std::streamsize>(index.size() * sizeof(HistoryBinaryTicker)));
+    pad_to(header.data_offset);
+
+    std::vector<double> column;
+    for (std::size_t i = 0; i < tickers.size(); i++) {
+        column.assign(index[i].count, std::numeric_limits<double>::quiet_NaN());
+        for (const auto& [d, v] : history.prices.at(tickers[i])) {
+            auto k = std::lower_bound(calendar.begin(), calendar.end(), parse_date(d)) - calendar.begin();
+            column[k - index[i].first_date] = v;
+        }
+        out.write(reinterpret_cast<const char*>(column.data()),
+                  static_cast<std::streamsize>(column.size() * sizeof(double)));
+    }
+
+    if (!out)
+        throw std::runtime_error("Error writing binary history: " + path);
+
+    return static_cast<std::size_t>(header.file_size);
+}
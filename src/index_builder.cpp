@@ -0,0 +1,87 @@
+#include "index_builder.hpp"
+#include "market_data_history.hpp"
+#include "parallel.hpp"
+#include "price_index.hpp"
+#include "trading_day_utils.hpp"
+
+#include <stdexcept>
+
+WeightingScheme parse_weighting_scheme(const std::string& name)
+{
+    if (name == "price") return WeightingScheme::PRICE;
+    if (name == "equal") return WeightingScheme::EQUAL;
+    if (name == "custom") return WeightingScheme::CUSTOM;
+    throw std::runtime_error("Unknown weighting scheme: " + name);
+}
+
+std::vector<IndexPortfolio> build_index_portfolios(
+    const MarketDataHistory& history,
+    const IndexPortfolioSpec& spec,
+    const std::vector<std::string>& rebalance_dates,
+    int threads)
+{
+    // ---- 1. Constituents and static weights ----
+    std::vector<std::string> members;
+    std::vector<double> custom;
+
+    for (const auto& t : spec.universe) {
+        if (spec.weighting == WeightingScheme::CUSTOM) {
+            auto it = spec.custom_weights.find(t);
+            if (it == spec.custom_weights.end()) continue;
+            custom.push_back(it->second);
+        }
+        members.push_back(t);
+    }
+
+    if (members.empty())
+        throw std::runtime_error("build_index_portfolios: empty universe");
+
+    if (spec.weighting == WeightingScheme::CUSTOM) {
+        double total = 0.0;
+        for (double w : custom) total += w;
+        if (total <= 0.0)
+            throw std::runtime_error("build_index_portfolios: custom weights must sum to a positive value");
+        for (double& w : custom) w /= total;
+    }
+
+    // ---- 2. Dense date-indexed prices, built once for all dates ----
+    PriceIndex index(history, members);
+
+    std::vector<IndexPortfolio> out(rebalance_dates.size());
+
+    parallel_for(rebalance_dates.size(), threads, [&](std::size_t r) {
+        const std::string& requested = rebalance_dates[r];
+        int key = parse_date(requested);
+        if (key < 0)
+            throw std::runtime_error("build_index_portfolios: invalid date " + requested);
+
+        int k = index.previous_complete_index(key);
+        if (k < 0)
+            throw std::runtime_error("build_index_portfolios: no prices on or before " + requested);
+
+        std::size_t n = members.size();
+        double total_sum = 0.0;
+        for (std::size_t i = 0; i < n; i++) total_sum += index.price(i, k);
+
+        IndexPortfolio& res = out[r];
+        res.requested_date = requested;
+        res.date = format_date(index.dates()[k]);
+        res.portfolio.instruments.reserve(n);
+
+        for (std::size_t i = 0; i < n; i++) {
+            double p = index.price(i, k);
+
+            double weight = 0.0;
+            switch (spec.weighting) {
+                case WeightingScheme::PRICE:  weight = p / total_sum; break;
+                case WeightingScheme::EQUAL:  weight = 1.0 / n; break;
+                case WeightingScheme::CUSTOM: weight = custom[i]; break;
+            }
+            double alloc = spec.portfolio_value * weight;
+
+            res.portfolio.add(InstrumentType::STOCK, members[i], static_cast<int>(alloc / p));
+        }
+    });
+
+    return out;
+}
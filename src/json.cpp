@@ -0,0 +1,316 @@
+#include "json.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+// ---------------------------------------------------------------------
+// Accessors
+// ---------------------------------------------------------------------
+
+static void type_error(const char* expected) {
+    throw std::runtime_error(std::string("JSON: expected ") + expected);
+}
+
+bool JsonValue::as_bool() const {
+    if (kind != Type::BOOL) type_error("boolean");
+    return flag;
+}
+
+double JsonValue::as_number() const {
+    if (kind != Type::NUMBER) type_error("number");
+    return number;
+}
+
+const std::string& JsonValue::as_string() const {
+    if (kind != Type::STRING) type_error("string");
+    return text;
+}
+
+const std::vector<JsonValue>& JsonValue::as_array() const {
+    if (kind != Type::ARRAY) type_error("array");
+    return items;
+}
+
+const std::map<std::string, JsonValue>& JsonValue::as_object() const {
+    if (kind != Type::OBJECT) type_error("object");
+    return members;
+}
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+    if (kind != Type::OBJECT) return nullptr;
+    auto it = members.find(key);
+    return it == members.end() ? nullptr : &it->second;
+}
+
+double JsonValue::get(const std::string& key, double fallback) const {
+    const JsonValue* v = find(key);
+    return v && !v->is_null() ? v->as_number() : fallback;
+}
+
+std::string JsonValue::get(const std::string& key, const std::string& fallback) const {
+    const JsonValue* v = find(key);
+    return v && !v->is_null() ? v->as_string() : fallback;
+}
+
+JsonValue& JsonValue::operator[](const std::string& key) {
+    if (kind == Type::NUL) kind = Type::OBJECT;
+    if (kind != Type::OBJECT) type_error("object");
+    return members[key];
+}
+
+void JsonValue::push_back(JsonValue v) {
+    if (kind == Type::NUL) kind = Type::ARRAY;
+    if (kind != Type::ARRAY) type_error("array");
+    items.push_back(std::move(v));
+}
+
+// ---------------------------------------------------------------------
+// Serialization
+// ---------------------------------------------------------------------
+
+static void dump_string(const std::string& s, std::string& out) {
+    out += '"';
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    out += '"';
+}
+
+void JsonValue::dump_to(std::string& out) const {
+    switch (kind) {
+        case Type::NUL:  out += "null"; break;
+        case Type::BOOL: out += flag ? "true" : "false"; break;
+        case Type::NUMBER: {
+            if (!std::isfinite(number)) { out += "null"; break; }
+            char buf[32];
+            auto r = std::to_chars(buf, buf + sizeof(buf), number);
+            out.append(buf, r.ptr);
+            break;
+        }
+        case Type::STRING: dump_string(text, out); break;
+        case Type::ARRAY:
+            out += '[';
+            for (std::size_t i = 0; i < items.size(); i++) {
+                if (i) out += ',';
+                items[i].dump_to(out);
+            }
+            out += ']';
+            break;
+        case Type::OBJECT: {
+            out += '{';
+            bool first = true;
+            for (const auto& [k, v] : members) {
+                if (!first) out += ',';
+                first = false;
+                dump_string(k, out);
+                out += ':';
+                v.dump_to(out);
+            }
+            out += '}';
+            break;
+        }
+    }
+}
+
+std::string JsonValue::dump() const {
+    std::string out;
+    dump_to(out);
+    return out;
+}
+
+// ---------------------------------------------------------------------
+// Parsing (recursive descent)
+// ---------------------------------------------------------------------
+namespace {
+
+class Parser {
+public:
+    explicit Parser(const std::string& s) : p(s.data()), begin(s.data()), end(s.data() + s.size()) {}
+
+    JsonValue document() {
+        JsonValue v = value(0);
+        skip_ws();
+        if (p != end) fail("trailing characters");
+        return v;
+    }
+
+private:
+    const char* p;
+    const char* begin;
+    const char* end;
+
+    static constexpr int MAX_DEPTH = 64;
+
+    [[noreturn]] void fail(const char* what) const {
+        throw std::runtime_error("JSON parse error at offset " + std::to_string(p - begin) + ": " + what);
+    }
+
+    void skip_ws() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    }
+
+    bool consume(const char* word) {
+        const char* q = p;
+        for (; *word; word++, q++)
+            if (q >= end || *q != *word) return false;
+        p = q;
+        return true;
+    }
+
+    JsonValue value(int depth) {
+        if (depth > MAX_DEPTH) fail("nesting too deep");
+        skip_ws();
+        if (p >= end) fail("unexpected end of input");
+
+        switch (*p) {
+            case '{': return object(depth);
+            case '[': return array(depth);
+            case '"': return JsonValue(string());
+            case 't': if (consume("true")) return JsonValue(true); break;
+            case 'f': if (consume("false")) return JsonValue(false); break;
+            case 'n': if (consume("null")) return JsonValue(); break;
+            default:  return JsonValue(number());
+        }
+        fail("invalid literal");
+    }
+
+    JsonValue object(int depth) {
+        JsonValue v = JsonValue::object();
+        p++; // {
+        skip_ws();
+        if (p < end && *p == '}') { p++; return v; }
+
+        for (;;) {
+            skip_ws();
+            if (p >= end || *p != '"') fail("expected object key");
+            std::string key = string();
+            skip_ws();
+            if (p >= end || *p != ':') fail("expected ':'");
+            p++;
+            v[key] = value(depth + 1);
+            skip_ws();
+            if (p < end && *p == ',') { p++; continue; }
+            if (p < end && *p == '}') { p++; return v; }
+            fail("expected ',' or '}'");
+        }
+    }
+
+    JsonValue array(int depth) {
+        JsonValue v = JsonValue::array();
+        p++; // [
+        skip_ws();
+        if (p < end && *p == ']') { p++; return v; }
+
+        for (;;) {
+            v.push_back(value(depth + 1));
+            skip_ws();
+            if (p < end && *p == ',') { p++; continue; }
+            if (p < end && *p == ']') { p++; return v; }
+            fail("expected ',' or ']'");
+        }
+    }
+
+    unsigned hex4() {
+        if (end - p < 4) fail("truncated \\u escape");
+        unsigned cp = 0;
+        for (int i = 0; i < 4; i++, p++) {
+            char c = *p;
+            cp <<= 4;
+            if (c >= '0' && c <= '9') cp |= c - '0';
+            else if (c >= 'a' && c <= 'f') cp |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') cp |= c - 'A' + 10;
+            else fail("invalid \\u escape");
+        }
+        return cp;
+    }
+
+    static void append_utf8(std::string& out, unsigned cp) {
+        if (cp < 0x80) out += static_cast<char>(cp);
+        else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    std::string string() {
+        std::string out;
+        p++; // opening quote
+        while (p < end && *p != '"') {
+            char c = *p++;
+            if (static_cast<unsigned char>(c) < 0x20) fail("control character in string");
+            if (c != '\\') { out += c; continue; }
+            if (p >= end) break;
+            switch (*p++) {
+                case '"':  out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/'; break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u': {
+                    unsigned cp = hex4();
+                    if (cp >= 0xD800 && cp < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                        p += 2;
+                        unsigned lo = hex4();
+                        if (lo < 0xDC00 || lo >= 0xE000) fail("invalid surrogate pair");
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    }
+                    append_utf8(out, cp);
+                    break;
+                }
+                default: fail("invalid escape");
+            }
+        }
+        if (p >= end) fail("unterminated string");
+        p++; // closing quote
+        return out;
+    }
+
+    double number() {
+        const char* start = p;
+        if (p < end && *p == '-') p++;
+        while (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E'
+                           || *p == '+' || *p == '-'))
+            p++;
+        double v = 0.0;
+        auto r = std::from_chars(start, p, v);
+        if (r.ec != std::errc() || r.ptr != p || start == p) {
+            p = start;
+            fail("invalid number");
+        }
+        return v;
+    }
+};
+
+} // namespace
+
+JsonValue parse_json(const std::string& text) {
+    return Parser(text).document();
+}
@@ -1,36 +1,265 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
-#include <unordered_set>
+#include <new>
+#include <unordered_map>
 
 #include "market_data_history.hpp"
 #include "market_snapshot.hpp"
 #include "portfolio.hpp"
 #include "monte_carlo.hpp"
+#include "parallel.hpp"
 #include "realized_risk.hpp"
+#include "risk_server.hpp"
+#include "stress.hpp"
+#include "historical_var.hpp"
+#include "backtest.hpp"
+#include "batch_runner.hpp"
+#include "bootstrap.hpp"
 #include "djia_builder.hpp"
+#include "index_builder.hpp"
+#include "profiler.hpp"
+#include "task_scheduler.hpp"
 #include "trading_day_utils.hpp"
 
-std::vector<std::string> get_unique_tickers(const Portfolio& p) {
-    std::unordered_set<std::string> s;
-    std::vector<std::string> out;
-    for (auto& inst : p.instruments) {
-        if (!s.count(inst.ticker)) {
-            s.insert(inst.ticker);
-            out.push_back(inst.ticker);
+#ifdef RISK_ENGINE_PROFILING
+// Allocation hook for the profiler: counts heap allocations while
+// profiling is enabled. Array and nothrow forms forward here.
+void* operator new(std::size_t size) {
+    profiler::count_allocation();
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+// Writes the --profile report when main returns, whichever path it takes.
+struct ProfileReport {
+    std::string file;
+
+    ~ProfileReport() {
+        if (file.empty()) return;
+        try {
+            profiler::write_report(file);
+            std::cout << "Profile written: " << file << "\n";
+        } catch (const std::exception& e) {
+            std::cerr << "WARNING: " << e.what() << "\n";
         }
     }
-    return out;
-}
+};
 
 void remove_missing_tickers(Portfolio& p, const MarketDataHistory& h) {
-    std::vector<Instrument> cleaned;
+    Portfolio cleaned;
     for (auto& inst : p.instruments) {
-        if (h.prices.count(inst.ticker))
-            cleaned.push_back(inst);
-        else
-            std::cout << "WARNING: Ticker " << inst.ticker 
+        const std::string& name = p.ticker(inst);
+        if (h.has_ticker(name)) {
+            Instrument& kept = cleaned.add(inst.type, name, inst.quantity);
+            kept.strike = inst.strike;
+            kept.maturity = inst.maturity;
+            kept.option_type = inst.option_type;
+        } else {
+            std::cout << "WARNING: Ticker " << name
                       << " missing in history => removed\n";
+        }
     }
-    p.instruments = cleaned;
+    p = std::move(cleaned);
+}
+
+// Non-empty lines of a text file (header-less lists of dates / tickers).
+std::vector<std::string> read_lines(const std::string& file) {
+    std::ifstream f(file);
+    if (!f.is_open())
+        throw std::runtime_error("Cannot open file: " + file);
+
+    std::vector<std::string> out;
+    std::string line;
+    while (std::getline(f, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) out.push_back(line);
+    }
+    return out;
+}
+
+// Comma-separated numbers ("0.8,1,1.2").
+std::vector<double> parse_number_list(const std::string& text) {
+    std::vector<double> out;
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        std::size_t comma = text.find(',', start);
+        if (comma == std::string::npos) comma = text.size();
+        if (comma > start) out.push_back(std::stod(text.substr(start, comma - start)));
+        start = comma + 1;
+    }
+    return out;
+}
+
+void load_history(MarketDataHistory& history, const std::string& path,
+                  const HistoryFilter& filter, int threads, std::ostream& log = std::cout) {
+    // a regular file is a binary history built by convert_history
+    HistoryLoadStats load_stats = std::filesystem::is_regular_file(path)
+        ? history.load_binary(path, filter, threads)
+        : history.load_directory(path, filter, threads);
+
+    log << "Loaded " << load_stats.rows << " rows from "
+              << load_stats.files << " files in " << load_stats.seconds
+              << " s (" << load_stats.rows_per_second() << " rows/s)\n";
+    if (load_stats.files_skipped || load_stats.bytes_skipped)
+        log << "Skipped " << load_stats.files_skipped << " tickers, "
+                  << load_stats.rows_skipped << " rows outside the window, "
+                  << load_stats.bytes_skipped << " bytes unread\n";
+    log << "\n";
+}
+
+// --serve / --socket mode: keep the full history warm and answer requests.
+int run_server(const std::string& history_path, const std::string& socket_path,
+               int lookback_days, int threads) {
+    // stdout carries responses in stream mode, so progress goes to stderr
+    MarketDataHistory history;
+    load_history(history, history_path, HistoryFilter{}, threads, std::cerr);
+
+    RiskServerConfig config;
+    config.lookback_days = lookback_days;
+    config.threads = threads;
+    RiskServer server(history, config);
+
+    if (socket_path.empty()) {
+        std::cerr << "Serving line-delimited JSON on stdin/stdout\n";
+        server.serve_stream(std::cin, std::cout);
+    } else {
+        std::cerr << "Serving line-delimited JSON on " << socket_path << "\n";
+        server.serve_unix_socket(socket_path);
+    }
+    std::cerr << "Served " << server.requests_served() << " requests\n";
+    return 0;
+}
+
+// --batch mode: pipelined Monte Carlo VaR over (portfolio, date) jobs.
+int run_batch_mode(const std::string& history_path, const std::string& jobs_file,
+                   const std::string& out_file, const BatchSpec& spec, int threads) {
+    std::vector<BatchJob> jobs = read_batch_jobs(jobs_file);
+    if (jobs.empty()) {
+        std::cout << "No jobs in " << jobs_file << "\n";
+        return 1;
+    }
+
+    // load only the date range the jobs need
+    HistoryFilter filter;
+    int lo = 0, hi = 0;
+    for (const auto& job : jobs) {
+        int d = parse_date(job.date);
+        if (d < 0) continue;
+        lo = lo ? std::min(lo, d) : d;
+        hi = std::max(hi, d);
+    }
+    if (lo > 0) {
+        filter.from_date = add_calendar_days(lo, -(spec.lookback_days * 3 / 2 + 30));
+        filter.to_date = hi;
+    }
+
+    MarketDataHistory history;
+    load_history(history, history_path, filter, threads);
+
+    BatchResult res = run_batch(history, jobs, spec, out_file);
+
+    std::cout << "=== BATCH (" << jobs.size() << " jobs) ===\n";
+    std::cout << "Failed     = " << res.failed << "\n";
+    std::cout << "Wall time  = " << res.seconds << " s\n";
+    std::cout << "Stage busy = load " << res.load_seconds
+              << " s, calibrate " << res.calibrate_seconds
+              << " s, factorize " << res.factorize_seconds
+              << " s, simulate " << res.simulate_seconds
+              << " s, write " << res.write_seconds << " s\n";
+    std::cout << "Results written to " << out_file << "\n";
+    return res.failed ? 2 : 0;
+}
+
+// --rebalance mode: one index portfolio per date, written to out_dir.
+int run_rebalance(const std::string& history_path, const std::string& dates_file,
+                  const std::string& universe_file, const std::string& weighting,
+                  const std::string& weights_file, const std::string& out_dir,
+                  double portfolio_value, int threads) {
+    IndexPortfolioSpec spec;
+    spec.weighting = parse_weighting_scheme(weighting);
+    spec.portfolio_value = portfolio_value;
+    spec.universe = universe_file.empty() ? djia_tickers() : read_lines(universe_file);
+
+    if (!weights_file.empty()) {
+        // ticker,weight
+        for (const auto& line : read_lines(weights_file)) {
+            auto comma = line.find(',');
+            if (comma == std::string::npos) continue;
+            try {
+                spec.custom_weights[line.substr(0, comma)] = std::stod(line.substr(comma + 1));
+            } catch (const std::invalid_argument&) {
+                // header row
+            }
+        }
+    }
+
+    std::vector<std::string> dates = read_lines(dates_file);
+
+    HistoryFilter filter;
+    filter.tickers.insert(spec.universe.begin(), spec.universe.end());
+
+    MarketDataHistory history;
+    load_history(history, history_path, filter, threads);
+
+    auto built = build_index_portfolios(history, spec, dates, threads);
+
+    // files are named by trading date; requested dates that align to the
+    // same day (a weekend and the Friday before it) would overwrite each
+    // other, so only the first one is written
+    std::filesystem::create_directories(out_dir);
+    std::unordered_map<std::string, std::string> written;   // date -> requested
+    for (const auto& b : built) {
+        auto [it, fresh] = written.emplace(b.date, b.requested_date);
+        if (!fresh) {
+            std::cerr << "Skipping " << b.requested_date << ": aligns to " << b.date
+                      << ", already written for " << it->second << "\n";
+            continue;
+        }
+        b.portfolio.save(out_dir + "/portfolio_" + b.date + ".csv");
+    }
+
+    std::cout << "Generated " << written.size() << " portfolios in " << out_dir << "\n";
+    return 0;
+}
+
+// --backtest mode: rolling Monte Carlo VaR against realized losses.
+int run_backtest_mode(const std::string& history_path, const std::string& portfolio_path,
+                      const BacktestSpec& spec, const std::string& out_file) {
+    Portfolio portfolio;
+    portfolio.load(portfolio_path, spec.threads);
+
+    HistoryFilter filter;
+    filter.tickers.insert(portfolio.tickers.begin(), portfolio.tickers.end());
+    int from = parse_date(spec.from_date);
+    int to = parse_date(spec.to_date);
+    if (from > 0 && to > 0) {
+        filter.from_date = add_calendar_days(from, -(spec.lookback_days * 3 / 2 + 30));
+        filter.to_date = add_calendar_days(to, spec.horizon_days * 3 / 2 + 30);
+    }
+
+    MarketDataHistory history;
+    load_history(history, history_path, filter, spec.threads);
+    remove_missing_tickers(portfolio, history);
+
+    BacktestResult bt = run_backtest(portfolio, history, spec);
+    write_backtest_csv(bt, out_file);
+
+    std::cout << "=== VaR BACKTEST " << spec.from_date << " .. " << spec.to_date << " ===\n";
+    std::cout << "Dates                = " << bt.rows.size() << "\n";
+    std::cout << "Exceptions           = " << bt.exceptions << " (rate " << bt.exception_rate
+              << ", expected " << bt.expected_rate << ")\n";
+    std::cout << "Kupiec POF           LR = " << bt.kupiec.lr << ", p = " << bt.kupiec.p_value << "\n";
+    std::cout << "Christoffersen ind.  LR = " << bt.independence.lr << ", p = " << bt.independence.p_value << "\n";
+    std::cout << "Conditional coverage LR = " << bt.conditional.lr << ", p = " << bt.conditional.p_value << "\n";
+    std::cout << "Per-date results: " << out_file << "\n";
+    return 0;
 }
 
 int main(int argc, char** argv){
@@ -45,6 +274,40 @@ int main(int argc, char** argv){
     int horizon_days = 10;
     int scenarios = 10000;
     double confidence = 0.95;
+    int threads = 0;
+    bool pin_threads = false;
+    bool full_history = false;
+
+    std::string rebalance_dates;
+    std::string universe_file;
+    std::string weighting = "price";
+    std::string weights_file;
+    std::string out_dir = "data/portfolios";
+
+    std::string backtest_from, backtest_to;
+    std::string backtest_out = "backtest.csv";
+
+    bool bootstrap = false;
+    bool filtered = false;
+    int block_length = 5;
+    bool option_grid = false;
+    bool pipelined = false;
+    McScenarioOutput scenario_out;
+
+    std::string stress_file, sectors_file;
+    std::string stress_from, stress_to;
+    int stress_worst = 10;
+
+    std::vector<double> sweep_vols, sweep_corrs;
+
+    std::string batch_file;
+    std::string batch_out = "batch_results.csv";
+
+    bool serve = false;
+    std::string socket_path;
+
+    bool profile = false;
+    std::string profile_out = "profile.json";
 
     // === CLI ===
     for (int i = 1; i < argc; i++) {
@@ -60,16 +323,121 @@ int main(int argc, char** argv){
         else if (a == "--scenarios") scenarios = std::stoi(argv[++i]);
         else if (a == "--confidence") confidence = std::stod(argv[++i]);
         else if (a == "--out") portfolio_path = argv[++i];
+        else if (a == "--threads") threads = std::stoi(argv[++i]);
+        else if (a == "--pin-threads") pin_threads = true;
+        else if (a == "--full-history") full_history = true;
+        else if (a == "--rebalance") rebalance_dates = argv[++i];
+        else if (a == "--universe") universe_file = argv[++i];
+        else if (a == "--weighting") weighting = argv[++i];
+        else if (a == "--weights") weights_file = argv[++i];
+        else if (a == "--out-dir") out_dir = argv[++i];
+        else if (a == "--backtest") { backtest_from = argv[++i]; backtest_to = argv[++i]; }
+        else if (a == "--backtest-out") backtest_out = argv[++i];
+        else if (a == "--option-grid") option_grid = true;
+        else if (a == "--pipeline") pipelined = true;
+        else if (a == "--pnl-out") scenario_out.path = argv[++i];
+        else if (a == "--pnl-prices") scenario_out.prices = true;
+        else if (a == "--pnl-books") scenario_out.books = true;
+        else if (a == "--stress") stress_file = argv[++i];
+        else if (a == "--sectors") sectors_file = argv[++i];
+        else if (a == "--stress-history") { stress_from = argv[++i]; stress_to = argv[++i]; }
+        else if (a == "--stress-worst") stress_worst = std::stoi(argv[++i]);
+        else if (a == "--sweep-vol") sweep_vols = parse_number_list(argv[++i]);
+        else if (a == "--sweep-corr") sweep_corrs = parse_number_list(argv[++i]);
+        else if (a == "--batch") batch_file = argv[++i];
+        else if (a == "--batch-out") batch_out = argv[++i];
+        else if (a == "--serve") serve = true;
+        else if (a == "--socket") { serve = true; socket_path = argv[++i]; }
+        else if (a == "--profile") profile = true;
+        else if (a == "--profile-out") { profile = true; profile_out = argv[++i]; }
+        else if (a == "--bootstrap") bootstrap = true;
+        else if (a == "--fhs") { bootstrap = true; filtered = true; }
+        else if (a == "--block") block_length = std::stoi(argv[++i]);
+    }
+
+    // size the shared work-stealing pool before any parallel code runs
+    if (threads > 0 || pin_threads) TaskScheduler::configure_global(threads, pin_threads);
+
+    ProfileReport report;
+    if (profile) {
+#ifdef RISK_ENGINE_PROFILING
+        profiler::set_enabled(true);
+        report.file = profile_out;
+#else
+        std::cout << "WARNING: built without RISK_ENGINE_PROFILE, --profile ignored\n";
+#endif
+    }
+
+    if (serve) {
+        return run_server(history_path, socket_path, lookback_days, threads);
+    }
+
+    if (!batch_file.empty()) {
+        BatchSpec spec;
+        spec.lookback_days = lookback_days;
+        spec.horizon_days = horizon_days;
+        spec.scenarios = scenarios;
+        spec.confidence = confidence;
+        spec.calibration_threads = std::max(1, resolve_thread_count(threads) / 4);
+        return run_batch_mode(history_path, batch_file, batch_out, spec, threads);
+    }
+
+    if (!backtest_from.empty()) {
+        BacktestSpec spec;
+        spec.from_date = backtest_from;
+        spec.to_date = backtest_to;
+        spec.lookback_days = lookback_days;
+        spec.horizon_days = horizon_days;
+        spec.scenarios = scenarios;
+        spec.confidence = confidence;
+        spec.threads = threads;
+        return run_backtest_mode(history_path, portfolio_path, spec, backtest_out);
+    }
+
+    if (!rebalance_dates.empty()) {
+        return run_rebalance(history_path, rebalance_dates, universe_file, weighting,
+                             weights_file, out_dir, portfolio_value, threads);
+    }
+
+    // === Select the tickers and date window this run needs ===
+    // A user portfolio is read up front to learn its tickers; the DJIA
+    // portfolio is generated later from the loaded history.
+    Portfolio portfolio;
+    HistoryFilter filter;
+
+    if (!full_history) {
+        if (use_djia) {
+            for (const auto& t : djia_tickers()) filter.tickers.insert(t);
+        } else {
+            portfolio.load(portfolio_path, threads);
+            filter.tickers.insert(portfolio.tickers.begin(), portfolio.tickers.end());
+        }
+
+        // trading days -> calendar days, with room for holidays and for
+        // snapshot alignment to an earlier common date
+        int target = parse_date(snapshot_date);
+        if (target > 0) {
+            filter.from_date = add_calendar_days(target, -(lookback_days * 3 / 2 + 30));
+            filter.to_date = add_calendar_days(target, horizon_days * 3 / 2 + 30);
+        }
+        // historical stress windows may lie far outside that window
+        if (!stress_from.empty()) {
+            int from = parse_date(stress_from), to = parse_date(stress_to);
+            if (filter.from_date != 0 && from > 0) filter.from_date = std::min(filter.from_date, from);
+            if (filter.to_date != 0 && to > 0) filter.to_date = std::max(filter.to_date, to);
+        }
     }
 
     // === Load history BEFORE DJIA generation ===
     MarketDataHistory history;
-    history.load_directory(history_path);
-
-    auto all_dates = history.get_all_dates();
+    load_history(history, history_path, filter, threads);
 
     // === Align snapshot date to available trading day ===
-    snapshot_date = find_common_previous_date(all_dates, snapshot_date);
+    {
+        PROFILE_SCOPE("calendar.align");
+        snapshot_date = format_date(
+            history.calendar().previous_common_date(parse_date(snapshot_date)));
+    }
 
     if (use_djia) {
         std::cout << "=== GENERATING DJIA PORTFOLIO FOR " << snapshot_date << " ===\n";
@@ -80,7 +448,7 @@ int main(int argc, char** argv){
         spec.history_dir = history_path;
         spec.output_file = portfolio_path;
 
-        if (!build_djia_portfolio(spec)) {
+        if (!build_djia_portfolio(history, spec)) {
             std::cout << "DJIA portfolio generation failed.\n";
             return 1;
         }
@@ -89,12 +457,12 @@ int main(int argc, char** argv){
     }
 
     // === Load portfolio ===
-    Portfolio portfolio;
-    portfolio.load(portfolio_path);
+    if (use_djia || full_history)
+        portfolio.load(portfolio_path, threads);
 
     remove_missing_tickers(portfolio, history);
 
-    auto tickers = get_unique_tickers(portfolio);
+    const auto& tickers = portfolio.tickers;
 
     // === Build snapshot (already aligned) ===
     MarketSnapshot snap = build_snapshot(history, tickers, snapshot_date, lookback_days);
@@ -102,12 +470,34 @@ int main(int argc, char** argv){
     // Compute initial portfolio value
     double V0 = 0.0;
     for (auto& inst : portfolio.instruments)
-        V0 += inst.quantity * snap.spot.at(inst.ticker);
+        V0 += inst.quantity * snap.spot.at(portfolio.ticker(inst));
 
     // === Monte Carlo ===
     MonteCarloEngine mc(snap, portfolio, horizon_days);
+    std::cout << "Positions: " << portfolio.instruments.size() << " rows, "
+              << mc.position_count() << " after netting\n\n";
+    mc.set_threads(threads);
+    if (pipelined) {
+        McPipelineSpec spec;
+        spec.enabled = true;
+        spec.total_threads = threads;
+        mc.set_pipeline(spec);
+    }
+    mc.set_scenario_output(scenario_out);
+    if (option_grid) {
+        double err = mc.enable_option_grid();
+        std::cout << "Option grid: max interpolation error " << err << "\n\n";
+    }
     double var_mc, es_mc;
     mc.compute(scenarios, confidence, var_mc, es_mc);
+    if (pipelined) {
+        const McPipelineStats& ps = mc.pipeline_stats();
+        std::cout << "Pipeline: " << ps.generator_threads << " generator + "
+                  << ps.revaluation_threads << " revaluation threads\n\n";
+    }
+    if (!scenario_out.path.empty())
+        std::cout << "Scenario file: " << scenario_out.path << " ("
+                  << std::filesystem::file_size(scenario_out.path) << " bytes)\n\n";
 
     std::cout << "=== MONTE CARLO RISK ===\n";
     std::cout << "VaR abs = " << var_mc << "\n";
@@ -115,14 +505,88 @@ int main(int argc, char** argv){
     std::cout << "ES  abs = " << es_mc << "\n";
     std::cout << "ES  rel = " << es_mc / V0 << "\n\n";
 
+    // === Vol / correlation sweep on common random numbers ===
+    if (!sweep_vols.empty() || !sweep_corrs.empty()) {
+        if (sweep_vols.empty()) sweep_vols = {1.0};
+        if (sweep_corrs.empty()) sweep_corrs = {0.0};
+        auto surface = mc.sweep(sweep_vols, sweep_corrs, scenarios, confidence);
+
+        std::cout << "=== MONTE CARLO SWEEP (" << surface.size() << " points, common draws) ===\n";
+        std::cout << "vol_scale,corr_shift,var,es,var_rel\n";
+        for (const auto& pt : surface)
+            std::cout << pt.vol_scale << "," << pt.corr_shift << "," << pt.var << ","
+                      << pt.es << "," << pt.var / V0 << "\n";
+        std::cout << "\n";
+    }
+
     // === Realized risk (use SAME aligned date) ===
-    RealizedRisk rr = compute_realized_risk(portfolio, history, snapshot_date, horizon_days);
+    RealizedRisk rr = compute_realized_risk(portfolio, history, snapshot_date,
+                                            horizon_days, confidence);
 
     std::cout << "=== REALIZED (HISTORICAL) RISK ===\n";
     std::cout << "VaR abs = " << rr.historical_var * V0 << "\n";
     std::cout << "VaR rel = " << rr.historical_var << "\n";
     std::cout << "ES  abs = " << rr.historical_es * V0 << "\n";
-    std::cout << "ES  rel = " << rr.historical_es << "\n";
+    std::cout << "ES  rel = " << rr.historical_es << "\n\n";
+
+    // === Historical simulation over the lookback window ===
+    HistoricalVarSpec hs_spec;
+    hs_spec.horizon_days = horizon_days;
+    hs_spec.lookback_days = lookback_days;
+    hs_spec.confidence = confidence;
+    hs_spec.threads = threads;
+
+    HistoricalVarResult hs = compute_historical_var(portfolio, history, snapshot_date, hs_spec);
+
+    std::cout << "=== HISTORICAL SIMULATION RISK (" << hs.scenarios << " scenarios) ===\n";
+    std::cout << "VaR abs = " << hs.var << "\n";
+    std::cout << "VaR rel = " << hs.var / hs.portfolio_value << "\n";
+    std::cout << "ES  abs = " << hs.es << "\n";
+    std::cout << "ES  rel = " << hs.es / hs.portfolio_value << "\n";
+
+    // === Block bootstrap / filtered historical simulation ===
+    if (bootstrap) {
+        BootstrapSpec bs_spec;
+        bs_spec.lookback_days = lookback_days;
+        bs_spec.horizon_days = horizon_days;
+        bs_spec.block_length = block_length;
+        bs_spec.filtered = filtered;
+        bs_spec.scenarios = scenarios;
+        bs_spec.confidence = confidence;
+        bs_spec.threads = threads;
+
+        BootstrapResult bs = compute_bootstrap_var(portfolio, history, snapshot_date, bs_spec);
+
+        std::cout << "\n=== " << (filtered ? "FILTERED HISTORICAL SIMULATION" : "BLOCK BOOTSTRAP")
+                  << " RISK ===\n";
+        std::cout << "VaR abs = " << bs.var << "\n";
+        std::cout << "VaR rel = " << bs.var / bs.portfolio_value << "\n";
+        std::cout << "ES  abs = " << bs.es << "\n";
+        std::cout << "ES  rel = " << bs.es / bs.portfolio_value << "\n";
+    }
+
+    // === Stress scenarios ===
+    if (!stress_file.empty() || !stress_from.empty()) {
+        StressScenarios set;
+        set.tickers = snap.tickers;
+        if (!stress_from.empty())
+            set.append(historical_stress_windows(history, snap.tickers, stress_from,
+                                                 stress_to, horizon_days));
+        if (!stress_file.empty()) {
+            std::unordered_map<std::string, std::string> sectors;
+            if (!sectors_file.empty()) sectors = load_sector_map(sectors_file);
+            set.append(load_stress_scenarios(stress_file, snap.tickers, sectors));
+        }
+
+        StressEngine stress(portfolio, snap);
+        StressResult sr = stress.run(set, static_cast<std::size_t>(std::max(stress_worst, 0)), threads);
+
+        std::cout << "\n=== STRESS (" << set.size() << " scenarios, worst "
+                  << sr.worst.size() << ") ===\n";
+        for (std::size_t s : sr.worst)
+            std::cout << set.names[s] << "  P&L = " << sr.pnl[s]
+                      << "  rel = " << sr.pnl[s] / sr.portfolio_value << "\n";
+    }
 
     return 0;
 }
@@ -0,0 +1,69 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : ptr(other.ptr), length(other.length), opened(other.opened)
+{
+    other.ptr = nullptr;
+    other.length = 0;
+    other.opened = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        ptr = other.ptr;
+        length = other.length;
+        opened = other.opened;
+        other.ptr = nullptr;
+        other.length = 0;
+        other.opened = false;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    length = static_cast<std::size_t>(st.st_size);
+    if (length > 0) {
+        void* p = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        ::madvise(p, length, MADV_SEQUENTIAL);
+        ptr = static_cast<const char*>(p);
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (ptr != nullptr)
+        ::munmap(const_cast<char*>(ptr), length);
+    ptr = nullptr;
+    length = 0;
+    opened = false;
+}
@@ -1,39 +1,473 @@
 #include "market_data_history.hpp"
+#include "history_binary.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "trading_day_utils.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <limits>
+#include <mutex>
 #include <stdexcept>
 
 namespace fs = std::filesystem;
 
-void MarketDataHistory::load_directory(const std::string& path) {
-    for (const auto& entry : fs::directory_iterator(path)) {
-        if (entry.path().extension() == ".csv") {
-            std::string ticker = entry.path().stem().string();
-            std::ifstream f(entry.path());
-            if (!f.is_open()) continue;
-
-            std::string line;
-            getline(f, line); // skip header
-
-            while (getline(f, line)) {
-                std::stringstream ss(line);
-                std::string date, open, high, low, close, adj, vol;
-                getline(ss, date, ',');
-                getline(ss, open, ',');
-                getline(ss, high, ',');
-                getline(ss, low, ',');
-                getline(ss, close, ',');
-                getline(ss, adj, ',');
-                getline(ss, vol, ',');
-
-                prices[ticker][date] = std::stod(close);
+// ---------------------------------------------------------------------
+// Helpers for parsing Yahoo-style CSV rows from a mapped buffer.
+// ---------------------------------------------------------------------
+namespace {
+
+void count_load(const HistoryLoadStats& stats) {
+    PROFILE_COUNT("history.files", stats.files);
+    PROFILE_COUNT("history.rows", stats.rows);
+    PROFILE_COUNT("history.bytes", stats.bytes);
+    PROFILE_COUNT("history.rows_skipped", stats.rows_skipped);
+    PROFILE_COUNT("history.bytes_skipped", stats.bytes_skipped);
+}
+
+struct RowScan {
+    int last_date = 0;
+    std::size_t rows = 0;
+    std::size_t rows_skipped = 0;
+    std::size_t bytes_skipped = 0;
+};
+
+const char* next_line(const char* p, const char* end) {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return nl ? nl + 1 : end;
+}
+
+// Reports a bad row as file:line when base is the start of the file,
+// or as file@byte-offset when only a tail of the file was read.
+[[noreturn]] void row_error(const std::string& file, const char* base,
+                            std::size_t base_offset, const char* p, const char* what) {
+    if (base_offset == 0) {
+        std::size_t line = 1 + static_cast<std::size_t>(std::count(base, p, '\n'));
+        throw std::runtime_error(file + ":" + std::to_string(line) + ": " + what);
+    }
+    throw std::runtime_error(file + "@" + std::to_string(base_offset + (p - base)) + ": " + what);
+}
+
+// Binary search over byte offsets for the first row with date >= from.
+// Returns a line start at or before that row; every row before the
+// returned position is known to be older than `from`.
+const char* seek_date(const char* first_row, const char* end, int from) {
+    const char* lo = first_row;
+    const char* hi = end;
+
+    while (hi - lo > 4096) {
+        const char* mid = next_line(lo + (hi - lo) / 2, hi);
+        if (mid >= hi || hi - mid < 10) break;
+
+        int d = parse_date(mid, 10);
+        if (d < 0) break; // unexpected content: fall back to a linear scan
+
+        if (d < from) lo = mid;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Parses Date and Close of the rows in [p, end). Other columns are never
+// materialized; the close is parsed in place with std::from_chars.
+// Returns where parsing stopped: end, or the first row after to_date.
+const char* parse_yahoo_rows(
+    const char* base, std::size_t base_offset,
+    const char* p, const char* end,
+    const std::string& file,
+    const HistoryFilter& filter,
+    std::map<std::string, double>& out,
+    RowScan& scan)
+{
+    while (p < end) {
+        const char* next = next_line(p, end);
+        const char* line_end = (next > p && next[-1] == '\n') ? next - 1 : next;
+        if (line_end > p && line_end[-1] == '\r') line_end--;
+        if (line_end == p) { // blank line
+            p = next;
+            continue;
+        }
+
+        // Date (column 0)
+        const char* date_end = static_cast<const char*>(std::memchr(p, ',', line_end - p));
+        int date = date_end ? parse_date(p, date_end - p) : -1;
+        if (date < 0)
+            row_error(file, base, base_offset, p, "invalid date");
+
+        if (!filter.accepts_date(date)) {
+            if (filter.to_date != 0 && date > filter.to_date) {
+                // rows are date-ordered: nothing after this one is wanted
+                scan.bytes_skipped += end - p;
+                return p;
             }
+            scan.rows_skipped++;
+            p = next;
+            continue;
+        }
+
+        // skip Open, High, Low to reach Close (column 4)
+        const char* c = date_end + 1;
+        for (int col = 1; col < 4 && c; col++) {
+            const char* comma = static_cast<const char*>(std::memchr(c, ',', line_end - c));
+            c = comma ? comma + 1 : nullptr;
+        }
+        if (!c)
+            row_error(file, base, base_offset, p, "missing Close column");
+
+        const char* close_end = static_cast<const char*>(std::memchr(c, ',', line_end - c));
+        if (!close_end) close_end = line_end;
+
+        double close = 0.0;
+        auto [ptr, ec] = std::from_chars(c, close_end, close);
+        if (ec != std::errc() || ptr == c)
+            row_error(file, base, base_offset, p, "invalid Close value");
+
+        // rows are date-ordered, so the end hint makes this O(1);
+        // duplicates keep the last value like the map assignment did
+        auto it = out.emplace_hint(out.end(), std::string(p, date_end), close);
+        it->second = close;
+        scan.rows++;
+        scan.last_date = date;
+
+        p = next;
+    }
+    return end;
+}
+
+// End of the last complete line in [base, end); a row that is still
+// being written is left for append_directory().
+const char* complete_lines_end(const char* base, const char* end) {
+    while (end > base && end[-1] != '\n') end--;
+    return end;
+}
+
+} // namespace
+
+// Moves a parsed series into the store (caller holds the store lock).
+static void merge_series(std::map<std::string, double>& dst,
+                         std::map<std::string, double>&& series)
+{
+    if (dst.empty()) {
+        dst = std::move(series);
+    } else {
+        for (auto& [d, v] : series) dst[d] = v;
+    }
+}
+
+HistoryLoadStats MarketDataHistory::load_directory(const std::string& path, int threads) {
+    return load_directory(path, HistoryFilter{}, threads);
+}
+
+HistoryLoadStats MarketDataHistory::load_directory(
+    const std::string& path, const HistoryFilter& filter, int threads)
+{
+    PROFILE_SCOPE("history.load_directory");
+    auto t0 = std::chrono::steady_clock::now();
+    materialize_prices();
+
+    HistoryLoadStats stats;
+    std::vector<fs::path> files;
+
+    for (const auto& entry : fs::directory_iterator(path)) {
+        if (entry.path().extension() != ".csv") continue;
+
+        if (!filter.accepts_ticker(entry.path().stem().string())) {
+            stats.files_skipped++;
+            stats.bytes_skipped += entry.file_size();
+            continue;
         }
+        files.push_back(entry.path());
     }
+    std::sort(files.begin(), files.end());
+
+    load_filter = filter;
+    std::mutex store_mutex;
+
+    parallel_for(files.size(), threads, [&](std::size_t i) {
+        const std::string file = files[i].string();
+
+        MappedFile mf;
+        if (!mf.open(file)) return;
+
+        const char* base = mf.data();
+        const char* end = complete_lines_end(base, base + mf.size());
+        const char* first_row = base ? next_line(base, end) : end; // skip header
+
+        RowScan scan;
+        const char* begin = first_row;
+        if (filter.from_date != 0 && begin < end) {
+            begin = seek_date(first_row, end, filter.from_date);
+            scan.bytes_skipped += begin - first_row;
+        }
+
+        std::map<std::string, double> series;
+        const char* stop = parse_yahoo_rows(base, 0, begin, end, file, filter, series, scan);
+
+        std::string ticker = files[i].stem().string();
+
+        // resume after the last row stored: rows past to_date and a
+        // partially written last row are read by append_directory()
+        std::lock_guard<std::mutex> lock(store_mutex);
+        merge_series(prices[ticker], std::move(series));
+        cursors[file] = {static_cast<std::size_t>(stop - base), scan.last_date};
+        stats.files++;
+        stats.rows += scan.rows;
+        stats.bytes += mf.size();
+        stats.rows_skipped += scan.rows_skipped;
+        stats.bytes_skipped += scan.bytes_skipped;
+    });
+
+    trading_calendar.build(prices);
+
+    stats.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t0).count();
+    count_load(stats);
+    return stats;
+}
+
+HistoryLoadStats MarketDataHistory::append_directory(const std::string& path, int threads)
+{
+    PROFILE_SCOPE("history.append_directory");
+    auto t0 = std::chrono::steady_clock::now();
+    materialize_prices();
+
+    struct Pending {
+        fs::path path;
+        std::size_t size;
+        FileCursor cursor;  // offset 0 = read the whole file
+        bool rewritten;     // replaces the ticker's series
+    };
+
+    HistoryLoadStats stats;
+    std::vector<Pending> pending;
+
+    for (const auto& entry : fs::directory_iterator(path)) {
+        if (entry.path().extension() != ".csv") continue;
+        if (!load_filter.accepts_ticker(entry.path().stem().string())) continue;
+
+        std::size_t size = entry.file_size();
+        auto it = cursors.find(entry.path().string());
+
+        if (it == cursors.end()) {
+            pending.push_back({entry.path(), size, FileCursor{}, false});      // new ticker file
+        } else if (size < it->second.offset) {
+            pending.push_back({entry.path(), size, FileCursor{}, true});       // rewritten
+        } else if (size > it->second.offset) {
+            pending.push_back({entry.path(), size, it->second, false});        // appended
+        }
+    }
+
+    std::mutex store_mutex;
+    std::vector<std::string> changed;
+    bool rebuild = false;   // a series lost rows: extend() cannot see that
+
+    parallel_for(pending.size(), threads, [&](std::size_t i) {
+        const Pending& job = pending[i];
+        const std::string file = job.path.string();
+        const std::size_t offset = job.cursor.offset;
+
+        // read the unseen tail in one go
+        std::ifstream f(job.path, std::ios::binary);
+        if (!f.is_open()) return;
+        std::string buf(job.size - offset, '\0');
+        f.seekg(static_cast<std::streamoff>(offset));
+        f.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+        buf.resize(static_cast<std::size_t>(f.gcount()));
+
+        const char* base = buf.data();
+        const char* end = base + buf.size();
+
+        // only complete lines; a partially written row waits for the next call
+        end = complete_lines_end(base, end);
+
+        const char* begin = offset == 0 ? next_line(base, end) : base; // header
+
+        HistoryFilter filter = load_filter;
+        filter.to_date = 0;
+        if (job.cursor.last_date != 0)
+            filter.from_date = std::max(filter.from_date, add_calendar_days(job.cursor.last_date, 1));
+
+        RowScan scan;
+        std::map<std::string, double> series;
+        parse_yahoo_rows(base, offset, begin, end, file, filter, series, scan);
+
+        std::string ticker = job.path.stem().string();
+
+        std::lock_guard<std::mutex> lock(store_mutex);
+        FileCursor& cur = cursors[file];
+        if (job.rewritten) {
+            // the file is the whole series now; dates it dropped go away
+            prices[ticker] = std::move(series);
+            cur.last_date = 0;
+            rebuild = true;
+        } else {
+            auto& dst = prices[ticker];
+            for (auto& [d, v] : series)
+                dst.insert_or_assign(dst.end(), d, v);
+            if (!series.empty()) changed.push_back(ticker);
+        }
+
+        cur.offset = offset + static_cast<std::size_t>(end - base);
+        if (scan.rows > 0) cur.last_date = std::max(cur.last_date, scan.last_date);
+
+        stats.files++;
+        stats.rows += scan.rows;
+        stats.bytes += static_cast<std::size_t>(end - base);
+        stats.rows_skipped += scan.rows_skipped;
+    });
+
+    if (rebuild) trading_calendar.build(prices);
+    else trading_calendar.extend(prices, changed);
+
+    stats.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t0).count();
+    count_load(stats);
+    return stats;
+}
+
+HistoryLoadStats MarketDataHistory::load_binary(const std::string& path, int threads) {
+    return load_binary(path, HistoryFilter{}, threads);
+}
+
+struct MarketDataHistory::MappedColumns {
+    HistoryBinaryFile file;
+    std::size_t k_lo = 0;   ///< file calendar window [k_lo, k_hi) of the filter
+    std::size_t k_hi = 0;
+    std::unordered_map<std::string, std::size_t> columns; ///< ticker → index entry
+
+    // Values of column i inside the window: [lo, hi) in calendar indices.
+    void window(std::size_t i, std::size_t& lo, std::size_t& hi) const {
+        const auto& entry = file.ticker(i);
+        lo = std::max<std::size_t>(entry.first_date, k_lo);
+        hi = std::max(lo, std::min<std::size_t>(entry.first_date + entry.count, k_hi));
+    }
+
+    // Close of column i on calendar index k, NaN if absent.
+    double at(std::size_t i, std::size_t k) const {
+        std::size_t lo, hi;
+        window(i, lo, hi);
+        if (k < lo || k >= hi) return std::numeric_limits<double>::quiet_NaN();
+        return file.column(i)[k - file.ticker(i).first_date];
+    }
+};
+
+HistoryLoadStats MarketDataHistory::load_binary(
+    const std::string& path, const HistoryFilter& filter, int threads)
+{
+    PROFILE_SCOPE("history.load_binary");
+    auto t0 = std::chrono::steady_clock::now();
+
+    auto m = std::make_shared<MappedColumns>();
+    m->file.open(path);
+    const HistoryBinaryFile& bin = m->file;
+
+    // calendar window [k_lo, k_hi) selected by the filter
+    const std::int32_t* cal = bin.dates();
+    m->k_lo = filter.from_date != 0
+        ? std::lower_bound(cal, cal + bin.n_dates(), filter.from_date) - cal : 0;
+    m->k_hi = filter.to_date != 0
+        ? std::upper_bound(cal, cal + bin.n_dates(), filter.to_date) - cal : bin.n_dates();
+    m->k_hi = std::max(m->k_lo, m->k_hi);
+
+    HistoryLoadStats stats;
+    stats.files = 1;
+
+    std::vector<TradingCalendar::Column> columns;
+    for (std::size_t i = 0; i < bin.n_tickers(); i++) {
+        const auto& entry = bin.ticker(i);
+        std::string ticker = bin.ticker_name(i);
+
+        if (!filter.accepts_ticker(ticker)) {
+            stats.files_skipped++;
+            stats.rows_skipped += entry.count;
+            stats.bytes_skipped += std::size_t(entry.count) * sizeof(double);
+            continue;
+        }
+
+        std::size_t lo, hi;
+        m->window(i, lo, hi);
+        std::size_t outside = entry.count - (hi - lo);
+        stats.bytes += (hi - lo) * sizeof(double);
+        stats.rows_skipped += outside;
+        stats.bytes_skipped += outside * sizeof(double);
+
+        m->columns.emplace(ticker, i);
+        columns.push_back({std::move(ticker), lo - m->k_lo, hi - lo,
+                           bin.column(i) + (lo - entry.first_date)});
+    }
+
+    // fault the wanted pages in concurrently; the calendar scan that
+    // follows then reads them from memory
+    std::vector<std::size_t> present(columns.size());
+    parallel_for(columns.size(), threads, [&](std::size_t c) {
+        const TradingCalendar::Column& col = columns[c];
+        present[c] = static_cast<std::size_t>(
+            std::count_if(col.values, col.values + col.count,
+                          [](double v) { return !std::isnan(v); }));
+    });
+    for (std::size_t n : present) stats.rows += n;
+
+    prices.clear();
+    cursors.clear();
+    load_filter = HistoryFilter{};
+    trading_calendar.build(cal + m->k_lo, m->k_hi - m->k_lo, columns);
+    mapped_columns = std::move(m);
+
+    stats.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t0).count();
+    count_load(stats);
+    return stats;
+}
+
+void MarketDataHistory::materialize_prices() {
+    if (!mapped_columns) return;
+    PROFILE_SCOPE("history.materialize");
+
+    const MappedColumns& m = *mapped_columns;
+    const std::int32_t* cal = m.file.dates();
+
+    // format every calendar date in the window once instead of once per row
+    std::vector<std::string> date_text(m.k_hi);
+    for (std::size_t k = m.k_lo; k < m.k_hi; k++)
+        date_text[k] = format_date(cal[k]);
+
+    for (const auto& [ticker, i] : m.columns) {
+        std::size_t lo, hi;
+        m.window(i, lo, hi);
+        const double* col = m.file.column(i) - m.file.ticker(i).first_date;
+
+        auto& series = prices[ticker];
+        for (std::size_t k = lo; k < hi; k++) {
+            if (std::isnan(col[k])) continue;
+            series.emplace_hint(series.end(), date_text[k], col[k]);  // keeps edits
+        }
+    }
+
+    mapped_columns.reset();
+    trading_calendar.build(prices);
 }
 
 double MarketDataHistory::get_price(const std::string& ticker, const std::string& date) const {
+    if (mapped_columns) {
+        const MappedColumns& m = *mapped_columns;
+        auto it = m.columns.find(ticker);
+        if (it == m.columns.end()) throw std::runtime_error("No ticker " + ticker);
+
+        const std::int32_t* cal = m.file.dates();
+        int key = parse_date(date);
+        const std::int32_t* p = std::lower_bound(cal + m.k_lo, cal + m.k_hi, key);
+        double v = (p != cal + m.k_hi && *p == key) ? m.at(it->second, p - cal)
+                                                     : std::numeric_limits<double>::quiet_NaN();
+        if (std::isnan(v)) throw std::runtime_error("No price for " + ticker + " on " + date);
+        return v;
+    }
+
     auto it = prices.find(ticker);
     if (it == prices.end()) throw std::runtime_error("No ticker " + ticker);
 
@@ -43,44 +477,108 @@ double MarketDataHistory::get_price(const std::string& ticker, const std::string
     return jt->second;
 }
 
-std::vector<std::string> MarketDataHistory::get_future_dates(
-    const std::string& snapshot_date, int horizon_days) const 
+bool MarketDataHistory::has_ticker(const std::string& ticker) const {
+    return mapped_columns ? mapped_columns->columns.count(ticker) > 0 : prices.count(ticker) > 0;
+}
+
+const double* MarketDataHistory::union_column(const std::string& ticker,
+                                              std::vector<double>& buf) const
 {
-    std::vector<std::string> dates;
+    const std::vector<int>& dates = calendar().union_dates();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
 
-    auto any = prices.begin()->second;
-    int count = 0;
+    if (mapped_columns) {
+        const MappedColumns& m = *mapped_columns;
+        auto it = m.columns.find(ticker);
+        if (it == m.columns.end()) throw std::runtime_error("No ticker " + ticker);
 
-    for (auto it = any.upper_bound(snapshot_date); it != any.end() && count < horizon_days; ++it) {
-        dates.push_back(it->first);
-        count++;
+        // the union is the whole window unless the filter dropped every
+        // quote of some day; then a column spanning it is used in place
+        std::size_t lo, hi;
+        m.window(it->second, lo, hi);
+        const double* col = m.file.column(it->second) - m.file.ticker(it->second).first_date;
+        if (dates.size() == m.k_hi - m.k_lo && lo == m.k_lo && hi == m.k_hi)
+            return col + m.k_lo;
+
+        // merge walk: union dates are a subset of the window's dates
+        const std::int32_t* cal = m.file.dates();
+        buf.assign(dates.size(), nan);
+        std::size_t k = m.k_lo;
+        for (std::size_t u = 0; u < dates.size(); u++) {
+            while (cal[k] < dates[u]) k++;
+            if (k >= lo && k < hi) buf[u] = col[k];
+        }
+        return buf.data();
     }
-    return dates;
-}
 
-std::vector<std::string> MarketDataHistory::get_past_dates(
-    const std::string& snapshot_date, int lookback_days) const
-{
-    std::vector<std::string> dates;
-    auto any = prices.begin()->second;
+    auto it = prices.find(ticker);
+    if (it == prices.end()) throw std::runtime_error("No ticker " + ticker);
+
+    // merge walk: both the series and the calendar are date-ordered
+    buf.assign(dates.size(), nan);
+    std::size_t k = 0;
+    for (const auto& [d, v] : it->second) {
+        int key = parse_date(d);
+        while (dates[k] < key) k++;
+        buf[k] = v;
+    }
+    return buf.data();
+}
 
-    auto it = any.lower_bound(snapshot_date);
-    if (it == any.begin()) return dates;
+const TradingCalendar& MarketDataHistory::calendar() const {
+    if (mapped_columns && !prices.empty())
+        throw std::runtime_error("prices were modified on a mapped history: call "
+                                 "rebuild_calendar() or materialize_prices() first");
+    if (!mapped_columns && !trading_calendar.matches(prices))
+        throw std::runtime_error("Trading calendar is out of date: call rebuild_calendar() "
+                                 "after modifying prices");
+    return trading_calendar;
+}
 
-    int count = 0;
-    while (it != any.begin() && count < lookback_days) {
-        --it;
-        dates.push_back(it->first);
-        count++;
+void MarketDataHistory::rebuild_calendar() {
+    // a mapped history's calendar stays current until `prices` is edited
+    if (mapped_columns) {
+        if (!prices.empty()) materialize_prices();
+        return;
     }
+    trading_calendar.build(prices);
+}
+
+static std::vector<std::string> to_text(const std::vector<int>& keys) {
+    std::vector<std::string> out;
+    out.reserve(keys.size());
+    for (int k : keys) out.push_back(format_date(k));
+    return out;
+}
+
+std::vector<std::string> MarketDataHistory::get_future_dates(
+    const std::string& snapshot_date, int horizon_days) const 
+{
+    return to_text(calendar().future_dates(parse_date(snapshot_date), horizon_days));
+}
 
-    return dates;
+std::vector<std::string> MarketDataHistory::get_past_dates(
+    const std::string& snapshot_date, int lookback_days) const
+{
+    return to_text(calendar().past_dates(parse_date(snapshot_date), lookback_days));
 }
 
 std::unordered_map<std::string, std::vector<std::string>> 
 MarketDataHistory::get_all_dates() const {
     std::unordered_map<std::string, std::vector<std::string>> out;
 
+    if (mapped_columns) {
+        const MappedColumns& m = *mapped_columns;
+        for (const auto& [ticker, i] : m.columns) {
+            std::vector<std::string>& dates = out[ticker];
+            std::size_t lo, hi;
+            m.window(i, lo, hi);
+            for (std::size_t k = lo; k < hi; k++)
+                if (!std::isnan(m.at(i, k))) dates.push_back(format_date(m.file.dates()[k]));
+        }
+        return out;
+    }
+
     for (const auto& [ticker, mp] : prices) {
         std::vector<std::string> dates;
         dates.reserve(mp.size());
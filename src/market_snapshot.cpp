@@ -1,15 +1,23 @@
 #include "market_snapshot.hpp"
 #include "market_data_history.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
 
 #include <cmath>
 #include <stdexcept>
 
+namespace {
+constexpr int PARALLEL_CORR_MIN_TICKERS = 64;
+}
+
 MarketSnapshot build_snapshot(
     const MarketDataHistory& hist,
     const std::vector<std::string>& tickers,
     const std::string& snapshot_date,
     int lookback_days)
 {
+    PROFILE_SCOPE("build_snapshot");
+
     MarketSnapshot snap;
     snap.tickers = tickers;
 
@@ -60,7 +68,10 @@ MarketSnapshot build_snapshot(
     // ---- 4. Correlation matrix ----
     snap.corr.assign(n, std::vector<double>(n, 0.0));
 
-    for (int i = 0; i < n; i++) {
+    // rows are independent; large universes fan out on the shared scheduler
+    const int corr_threads = n >= PARALLEL_CORR_MIN_TICKERS ? 0 : 1;
+    parallel_for(n, corr_threads, [&](std::size_t row) {
+        const int i = static_cast<int>(row);
         for (int j = 0; j < n; j++) {
 
             if (i == j) {
@@ -78,7 +89,7 @@ MarketSnapshot build_snapshot(
 
             snap.corr[i][j] = cov / (snap.sigma[i] * snap.sigma[j]);
         }
-    }
+    });
 
     return snap;
 }
@@ -0,0 +1,207 @@
+#include "monte_carlo.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "risk_measures.hpp"
+#include "scenario_file.hpp"
+#include "spsc_ring.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t MAX_CHUNK_BYTES = 256 * 1024;
+constexpr std::size_t PROBE_SCENARIOS = 256;
+
+// Scenarios [first, first + count) with their terminal prices.
+struct PriceChunk {
+    std::size_t first = 0;
+    std::size_t count = 0;
+    double* prices = nullptr;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+void MonteCarloEngine::compute_pipelined(std::size_t total, double confidence,
+                                         double& var_out, double& es_out)
+{
+    PROFILE_SCOPE("mc.pipeline");
+
+    const std::size_t n = tickers.size();
+    const std::size_t chunk = std::clamp<std::size_t>(
+        pipeline.chunk_scenarios, 1, std::max<std::size_t>(1, MAX_CHUNK_BYTES / (n * sizeof(double))));
+    const std::size_t chunks = (total + chunk - 1) / chunk;
+
+    last_pipeline = McPipelineStats();
+    int gen = pipeline.generator_threads;
+    int rev = pipeline.revaluation_threads;
+
+    // ---- stage sizes: explicit, or split the budget by measured cost ----
+    if (gen <= 0 || rev <= 0) {
+        const int budget = resolve_thread_count(pipeline.total_threads);
+        if (gen > 0) {
+            rev = std::max(1, budget - gen);
+        } else if (rev > 0) {
+            gen = std::max(1, budget - rev);
+        } else {
+            const std::size_t probe = std::min(total, PROBE_SCENARIOS);
+            std::vector<double> z(SHOCK_BATCH * n), prices(probe * n), out(probe);
+
+            auto t0 = std::chrono::steady_clock::now();
+            generate_prices(0, probe, z.data(), prices.data());
+            double tg = seconds_since(t0);
+            t0 = std::chrono::steady_clock::now();
+            revaluer->pnl_batch(prices.data(), probe, out.data());
+            double tr = seconds_since(t0);
+
+            last_pipeline.probe_generate_us = tg / probe * 1e6;
+            last_pipeline.probe_revalue_us = tr / probe * 1e6;
+
+            if (budget < 2 || tg + tr <= 0.0) {
+                gen = rev = 1;
+            } else {
+                gen = static_cast<int>(std::lround(budget * tg / (tg + tr)));
+                gen = std::clamp(gen, 1, budget - 1);
+                rev = budget - gen;
+            }
+        }
+    }
+    gen = static_cast<int>(std::min<std::size_t>(gen, chunks));
+    rev = static_cast<int>(std::min<std::size_t>(rev, chunks));
+    last_pipeline.generator_threads = gen;
+    last_pipeline.revaluation_threads = rev;
+
+    // ---- rings and chunk buffers, one set per generator/revaluer pair ----
+    // `full` carries priced chunks (and a nullptr end marker) downstream,
+    // `spare` returns the buffers, so the producer never outruns the
+    // consumer by more than ring_capacity chunks.
+    const std::size_t depth = std::max<std::size_t>(pipeline.ring_capacity, 1);
+    const std::size_t pairs = static_cast<std::size_t>(gen) * rev;
+
+    std::vector<double> buffers(pairs * depth * chunk * n);
+    std::vector<PriceChunk> pool(pairs * depth);
+    std::vector<std::unique_ptr<SpscRing<PriceChunk*>>> full, spare;
+    for (std::size_t p = 0; p < pairs; p++) {
+        full.push_back(std::make_unique<SpscRing<PriceChunk*>>(depth + 1));
+        spare.push_back(std::make_unique<SpscRing<PriceChunk*>>(depth));
+        for (std::size_t d = 0; d < depth; d++) {
+            PriceChunk& c = pool[p * depth + d];
+            c.prices = buffers.data() + (p * depth + d) * chunk * n;
+            spare[p]->try_push(&c);
+        }
+    }
+
+    double* pnl = workspace.reserve(total);
+    std::unique_ptr<ScenarioFileWriter> writer = open_output(total, chunk);
+    const std::size_t out_cols = writer ? output_columns() : 0;
+
+    std::atomic<bool> failed{false};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto fail = [&] {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) error = std::current_exception();
+        failed = true;
+    };
+
+    std::vector<double> gen_busy(gen, 0.0), rev_busy(rev, 0.0);
+
+    // ---- generators: chunk c belongs to generator c % gen; its k-th
+    //      chunk goes to revaluer k % rev ----
+    auto generator = [&](int g) {
+        std::vector<double> z(SHOCK_BATCH * n);
+        std::size_t k = 0;
+        try {
+            for (std::size_t c = g; c < chunks && !failed; c += gen, k++) {
+                const std::size_t p = static_cast<std::size_t>(g) * rev + k % rev;
+                PriceChunk* ch = nullptr;
+                while (!spare[p]->try_pop(ch)) {
+                    if (failed) return;
+                    std::this_thread::yield();
+                }
+
+                auto t0 = std::chrono::steady_clock::now();
+                ch->first = c * chunk;
+                ch->count = std::min(chunk, total - ch->first);
+                generate_prices(ch->first, ch->count, z.data(), ch->prices);
+                gen_busy[g] += seconds_since(t0);
+
+                while (!full[p]->try_push(ch)) {
+                    if (failed) return;
+                    std::this_thread::yield();
+                }
+            }
+        } catch (...) {
+            fail();
+        }
+        // end markers; the full rings always have a slot to spare for them
+        for (int r = 0; r < rev; r++)
+            full[static_cast<std::size_t>(g) * rev + r]->try_push(nullptr);
+    };
+
+    // ---- revaluers: drain every generator's ring for this revaluer ----
+    auto revaluer_stage = [&](int r) {
+        std::vector<bool> done(gen, false);
+        std::vector<double> group(out_cols * chunk);
+        int finished = 0;
+        try {
+            while (finished < gen && !failed) {
+                bool progress = false;
+                for (int g = 0; g < gen; g++) {
+                    if (done[g]) continue;
+                    const std::size_t p = static_cast<std::size_t>(g) * rev + r;
+                    PriceChunk* ch = nullptr;
+                    if (!full[p]->try_pop(ch)) continue;
+                    progress = true;
+                    if (!ch) {
+                        done[g] = true;
+                        finished++;
+                        continue;
+                    }
+
+                    auto t0 = std::chrono::steady_clock::now();
+                    revaluer->pnl_batch(ch->prices, ch->count, pnl + ch->first);
+                    if (writer) {
+                        for (std::size_t k = 0; k < ch->count; k++)
+                            output_row(ch->prices + k * n, pnl[ch->first + k], k, ch->count,
+                                       group.data());
+                        writer->write_group(ch->first / chunk, group.data());
+                    }
+                    rev_busy[r] += seconds_since(t0);
+
+                    spare[p]->try_push(ch);
+                }
+                if (!progress) std::this_thread::yield();
+            }
+        } catch (...) {
+            fail();
+        }
+    };
+
+    {
+        PROFILE_SCOPE("mc.simulate");
+        std::vector<std::thread> threads_;
+        for (int g = 0; g < gen; g++) threads_.emplace_back(generator, g);
+        for (int r = 0; r < rev; r++) threads_.emplace_back(revaluer_stage, r);
+        for (auto& t : threads_) t.join();
+    }
+    if (error) std::rethrow_exception(error);
+    PROFILE_COUNT("mc.scenarios", total);
+    if (writer) writer->close();
+
+    for (double s : gen_busy) last_pipeline.generate_seconds += s;
+    for (double s : rev_busy) last_pipeline.revalue_seconds += s;
+
+    tail_risk(pnl, total, confidence, var_out, es_out);
+}
@@ -1,111 +1,523 @@
 #include "monte_carlo.hpp"
 #include "cholesky.hpp"
+#include "counter_rng.hpp"
+#include "parallel.hpp"
+#include "task_scheduler.hpp"
+#include "profiler.hpp"
+#include "risk_measures.hpp"
+#include "scenario_file.hpp"
 
-#include <random>
 #include <cmath>
 #include <algorithm>
+#include <limits>
+#include <memory>
 #include <stdexcept>
 
+namespace {
+
+// Shock / price scratch of the thread running a block. Blocks of one
+// compute() run on arbitrary threads (callers help), so scratch is per
+// thread rather than per engine; it only ever grows.
+thread_local std::vector<double> tls_scratch;
+
+double* thread_scratch(std::size_t doubles) {
+    if (tls_scratch.size() < doubles) tls_scratch.resize(doubles);
+    return tls_scratch.data();
+}
+
+// Runs body(b) for b in [0, blocks). The std::function handed to the
+// scheduler wraps one reference, which fits its small-object buffer, so
+// dispatch does not allocate.
+template <class Body>
+void run_blocks(TaskScheduler* scheduler, int threads, std::size_t blocks, const Body& body) {
+    auto call = [&body](std::size_t b) { body(b); };
+    if (scheduler) scheduler->parallel_for(blocks, 1, call);
+    else parallel_for(blocks, threads, call);
+}
+
+} // namespace
+
+MonteCarloEngine::MonteCarloEngine(int horizon)
+    : horizon_days(horizon)
+{
+}
+
 MonteCarloEngine::MonteCarloEngine(
         const MarketSnapshot& snap,
         const Portfolio& pf,
         int horizon)
-    : snapshot(snap), portfolio(pf), horizon_days(horizon)
+    : horizon_days(horizon)
+{
+    bind_market(snap);
+    bind_portfolio(pf);
+}
+
+MonteCarloEngine::MonteCarloEngine(
+        const MarketSnapshot& snap,
+        const Portfolio& pf,
+        int horizon,
+        std::vector<std::vector<double>> cholesky_factor)
+    : horizon_days(horizon), own_factor(std::move(cholesky_factor))
 {
-    build_cholesky();
+    if (own_factor.size() != snap.tickers.size())
+        throw std::runtime_error("MonteCarloEngine: Cholesky factor size mismatch");
+    bind_terms(snap);
+    L = &own_factor;
+    bind_portfolio(pf);
 }
 
-void MonteCarloEngine::build_cholesky() {
-    L = cholesky(snapshot.corr);
+void MonteCarloEngine::bind_market(const MarketSnapshot& snap) {
+    bind_terms(snap);
+    own_factor = cholesky(snap.corr);
+    L = &own_factor;
 }
 
-// Generate one P&L scenario
-double MonteCarloEngine::simulate_once(std::mt19937_64& rng) {
-    int n = snapshot.tickers.size();
+void MonteCarloEngine::bind_market(const MarketSnapshot& snap,
+                                   const std::vector<std::vector<double>>& cholesky_factor) {
+    if (cholesky_factor.size() != snap.tickers.size())
+        throw std::runtime_error("MonteCarloEngine: Cholesky factor size mismatch");
+    bind_terms(snap);
+    L = &cholesky_factor;
+}
 
-    std::normal_distribution<double> norm(0.0, 1.0);
-    std::vector<double> z(n);
-    std::vector<double> shock(n);
+void MonteCarloEngine::bind_terms(const MarketSnapshot& snap) {
+    const std::size_t n = snap.tickers.size();
+    if (n == 0)
+        throw std::runtime_error("MonteCarloEngine: empty market snapshot");
 
-    // independent shocks
-    for (int i = 0; i < n; i++) {
-        z[i] = norm(rng);
+    // the compiled portfolio survives a rebind onto the same asset order
+    const bool same_assets = snap.tickers == tickers;
+    if (!same_assets) {
+        revaluer.reset();
+        tickers = snap.tickers;
+        ticker_index.clear();
+        for (std::size_t i = 0; i < n; i++) ticker_index[tickers[i]] = i;
     }
+    L = nullptr;
+    cached_scenarios = 0;
 
-    // correlated shocks: shock = L * z
-    for (int i = 0; i < n; i++) {
-        double sum = 0.0;
-        for (int k = 0; k <= i; k++)
-            sum += L[i][k] * z[k];
-        shock[i] = sum;
+    double dt = horizon_days / 252.0;
+    spot0.resize(n);
+    drift.resize(n);
+    diffusion.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+        spot0[i] = snap.spot.at(tickers[i]);
+        double vol = snap.sigma[i];
+        drift[i] = (snap.mu[i] - 0.5 * vol * vol) * dt;
+        diffusion[i] = vol * std::sqrt(dt);
     }
 
-    // compute tomorrow prices (for horizon_days)
-    double dt = horizon_days / 252.0;
+    if (revaluer)
+        for (std::size_t i = 0; i < n; i++) revaluer->set_spot(i, spot0[i]);
+}
+
+void MonteCarloEngine::bind_portfolio(const Portfolio& pf) {
+    if (tickers.empty())
+        throw std::runtime_error("MonteCarloEngine: bind_market() before bind_portfolio()");
+    revaluer.emplace(pf, tickers, spot0);
+    cached_scenarios = 0;
+}
 
-    std::unordered_map<std::string, double> new_price;
+const PortfolioRevaluer& MonteCarloEngine::bound_revaluer() const {
+    if (!L || !revaluer)
+        throw std::runtime_error("MonteCarloEngine: no market or portfolio bound");
+    return *revaluer;
+}
+
+double* MonteCarloEngine::Workspace::reserve(std::size_t doubles) {
+    if (doubles > capacity) {
+        // no value-initialization: pages are first touched by the workers
+        arena.reset(new double[doubles]);
+        capacity = doubles;
+    }
+    return arena.get();
+}
+
+void MonteCarloEngine::reserve(int scenarios) {
+    if (scenarios < 1) return;
+    const std::size_t total = static_cast<std::size_t>(scenarios);
+    const std::size_t blocks = (total + MC_BLOCK - 1) / MC_BLOCK;
+    // the tail area never exceeds one MC_BLOCK per block
+    workspace.reserve(total + blocks * MC_BLOCK);
+    thread_scratch((SHOCK_BATCH + 1) * tickers.size());
+}
+
+// Price multipliers of one scenario given its independent shocks
+void MonteCarloEngine::scenario_multipliers(const double* z, double* mult) const {
+    int n = tickers.size();
 
     for (int i = 0; i < n; i++) {
-        const std::string& t = snapshot.tickers[i];
-        double S0 = snapshot.spot.at(t);
-        double mu = snapshot.mu[i];
-        double vol = snapshot.sigma[i];
+        // correlated shock: (L * z)_i
+        double shock = 0.0;
+        const double* row = (*L)[i].data();
+        for (int k = 0; k <= i; k++)
+            shock += row[k] * z[k];
 
-        double ST = S0 * std::exp(
-            (mu - 0.5 * vol * vol) * dt +
-            vol * std::sqrt(dt) * shock[i]
-        );
+        mult[i] = std::exp(drift[i] + diffusion[i] * shock);
+    }
+}
 
-        new_price[t] = ST;
+void MonteCarloEngine::generate_prices(std::size_t first, std::size_t count,
+                                       double* z, double* prices) const {
+    const std::size_t n = tickers.size();
+    for (std::size_t s0 = 0; s0 < count; s0 += SHOCK_BATCH) {
+        std::size_t m = std::min(SHOCK_BATCH, count - s0);
+        fill_normal_streams(SEED, first + s0, m, n, z);
+        for (std::size_t k = 0; k < m; k++) {
+            double* row = prices + (s0 + k) * n;
+            scenario_multipliers(z + k * n, row);
+            for (std::size_t i = 0; i < n; i++) row[i] *= spot0[i];
+        }
     }
+}
 
-    // compute portfolio P&L
-    double V0 = 0.0, V1 = 0.0;
+std::size_t MonteCarloEngine::output_columns() const {
+    const std::size_t n = tickers.size();
+    return 1 + (output.prices ? n : 0) + (output.books ? n : 0);
+}
 
-    for (const auto& inst : portfolio.instruments) {
-        double S0 = snapshot.spot.at(inst.ticker);
-        double S1 = new_price.at(inst.ticker);
+std::unique_ptr<ScenarioFileWriter> MonteCarloEngine::open_output(std::size_t total,
+                                                                  std::size_t group_rows) {
+    if (output.path.empty()) return nullptr;
 
-        if (inst.type == InstrumentType::STOCK) {
-            V0 += inst.quantity * S0;
-            V1 += inst.quantity * S1;
-        } else {
-            bool call = (inst.option_type == "CALL");
-            double payoff0 = call ?
-                std::max(S0 - inst.strike, 0.0) :
-                std::max(inst.strike - S0, 0.0);
-            double payoff1 = call ?
-                std::max(S1 - inst.strike, 0.0) :
-                std::max(inst.strike - S1, 0.0);
-
-            V0 += inst.quantity * payoff0;
-            V1 += inst.quantity * payoff1;
+    const std::size_t n = tickers.size();
+    std::vector<ScenarioFileColumn> columns{scenario_column(ScenarioColumnKind::PNL, "pnl")};
+    if (output.prices)
+        for (std::size_t i = 0; i < n; i++)
+            columns.push_back(scenario_column(ScenarioColumnKind::PRICE, tickers[i], i));
+    if (output.books) {
+        book_base.resize(n);
+        for (std::size_t i = 0; i < n; i++) {
+            columns.push_back(scenario_column(ScenarioColumnKind::BOOK_PNL, tickers[i], i));
+            book_base[i] = revaluer->asset_value(i, spot0[i]);
         }
     }
+    return std::make_unique<ScenarioFileWriter>(output.path, total,
+                                                static_cast<std::uint32_t>(group_rows), columns,
+                                                static_cast<std::uint32_t>(horizon_days), SEED);
+}
 
-    return V1 - V0;
+void MonteCarloEngine::output_row(const double* prices, double pnl, std::size_t k,
+                                  std::size_t rows, double* group) const {
+    const std::size_t n = tickers.size();
+    group[k] = pnl;
+    double* col = group + rows;
+    if (output.prices) {
+        for (std::size_t i = 0; i < n; i++) col[i * rows + k] = prices[i];
+        col += n * rows;
+    }
+    if (output.books)
+        for (std::size_t i = 0; i < n; i++)
+            col[i * rows + k] = revaluer->asset_value(i, prices[i]) - book_base[i];
+}
+
+// P&L of one scenario given its independent shocks
+double MonteCarloEngine::scenario_from_shocks(const double* z, double* prices) const {
+    int n = tickers.size();
+
+    // compute tomorrow prices (for horizon_days)
+    scenario_multipliers(z, prices);
+    for (int i = 0; i < n; i++) prices[i] *= spot0[i];
+
+    // portfolio P&L
+    return revaluer->pnl(prices);
+}
+
+double MonteCarloEngine::scenario_pnl(std::uint64_t index,
+                                      std::vector<double>* prices_out,
+                                      std::vector<double>* shocks_out) const {
+    bound_revaluer();
+    std::size_t n = tickers.size();
+    std::vector<double> z(n), prices(n);
+    fill_normal(SEED, index, z.data(), n);
+    double pnl = scenario_from_shocks(z.data(), prices.data());
+    if (prices_out) *prices_out = std::move(prices);
+    if (shocks_out) *shocks_out = std::move(z);
+    return pnl;
 }
 
 void MonteCarloEngine::compute(
         int scenarios, double confidence,
         double& var_out, double& es_out)
 {
-    std::mt19937_64 rng(42);
-    std::vector<double> pnl(scenarios);
+    if (scenarios < 1)
+        throw std::runtime_error("MonteCarloEngine: scenarios must be positive");
 
-    for (int s = 0; s < scenarios; s++) {
-        pnl[s] = simulate_once(rng);
+    bound_revaluer();
+
+    const std::size_t total = static_cast<std::size_t>(scenarios);
+    if (pipeline.enabled) {
+        compute_pipelined(total, confidence, var_out, es_out);
+        return;
     }
 
-    std::sort(pnl.begin(), pnl.end());
+    const std::size_t n = tickers.size();
+    const std::size_t blocks = (total + MC_BLOCK - 1) / MC_BLOCK;
+    const std::size_t keep = std::min(tail_count(total, confidence), MC_BLOCK);
+
+    std::unique_ptr<ScenarioFileWriter> writer = open_output(total, MC_BLOCK);
+    const std::size_t out_cols = writer ? output_columns() : 0;
+
+    // arena: [P&L of every scenario | worst `keep` of every block]
+    double* pnl = workspace.reserve(total + blocks * MC_BLOCK);
+    double* tails = pnl + total;
+    // unused slots of a short last block stay +inf and never reach the tail
+    std::fill(tails, tails + blocks * keep, std::numeric_limits<double>::infinity());
 
-    int idx = (int)((1.0 - confidence) * scenarios);
-    if (idx < 0) idx = 0;
-    if (idx >= scenarios) idx = scenarios - 1;
+    {
+        PROFILE_SCOPE("mc.simulate");
 
-    var_out = -pnl[idx];
+        // scenario s always uses Philox stream s: results do not depend on
+        // the thread count or on which thread runs a block
+        auto block = [&](std::size_t b) {
+            double* z = thread_scratch((SHOCK_BATCH + 1) * n + out_cols * MC_BLOCK);
+            double* prices = z + SHOCK_BATCH * n;
+            double* group = prices + n;   // row group of the scenario file
+
+            const std::size_t first = b * MC_BLOCK;
+            double* slice = pnl + first;
+            std::size_t len = std::min(total, first + MC_BLOCK) - first;
+            for (std::size_t s0 = 0; s0 < len; s0 += SHOCK_BATCH) {
+                std::size_t m = std::min(SHOCK_BATCH, len - s0);
+                fill_normal_streams(SEED, first + s0, m, n, z);
+                for (std::size_t k = 0; k < m; k++) {
+                    slice[s0 + k] = scenario_from_shocks(z + k * n, prices);
+                    if (writer) output_row(prices, slice[s0 + k], s0 + k, len, group);
+                }
+            }
+            if (writer) writer->write_group(b, group);
+
+            // block-local tail while the slice is still in cache
+            std::size_t k = std::min(keep, len);
+            std::nth_element(slice, slice + (k - 1), slice + len);
+            std::copy(slice, slice + k, tails + b * keep);
+        };
+        run_blocks(scheduler, threads, blocks, block);
+    }
+    PROFILE_COUNT("mc.scenarios", scenarios);
+    if (writer) writer->close();
+
+    tail_risk_candidates(tails, blocks * keep, total, confidence, var_out, es_out);
+}
+
+void MonteCarloEngine::compute_cached(
+        int scenarios, double confidence,
+        double& var_out, double& es_out)
+{
+    if (scenarios < 1)
+        throw std::runtime_error("MonteCarloEngine: scenarios must be positive");
+
+    const PortfolioRevaluer& rv = bound_revaluer();
+
+    const std::size_t total = static_cast<std::size_t>(scenarios);
+    const std::size_t n = tickers.size();
+    const std::size_t blocks = (total + MC_BLOCK - 1) / MC_BLOCK;
+
+    cached_scenarios = total;
+    cached_mult.resize(n * total);
+    cached_contrib.resize(n * total);
+    cached_pnl.resize(total);
+
+    std::vector<double>& base = cached_base;
+    base.resize(n);
+    for (std::size_t a = 0; a < n; a++) base[a] = rv.asset_value(a, spot0[a]);
+
+    {
+        PROFILE_SCOPE("mc.simulate");
+
+        auto block = [&](std::size_t b) {
+            double* z = thread_scratch((SHOCK_BATCH + 1) * n);
+            double* mult = z + SHOCK_BATCH * n;
+
+            const std::size_t first = b * MC_BLOCK;
+            const std::size_t end = std::min(total, first + MC_BLOCK);
+            for (std::size_t s0 = first; s0 < end; s0 += SHOCK_BATCH) {
+                std::size_t m = std::min(SHOCK_BATCH, end - s0);
+                fill_normal_streams(SEED, s0, m, n, z);
+                for (std::size_t k = 0; k < m; k++) {
+                    const std::size_t s = s0 + k;
+                    scenario_multipliers(z + k * n, mult);
+
+                    double pnl = 0.0;
+                    for (std::size_t a = 0; a < n; a++) {
+                        double c = rv.asset_value(a, spot0[a] * mult[a]) - base[a];
+                        cached_mult[a * total + s] = mult[a];
+                        cached_contrib[a * total + s] = c;
+                        pnl += c;
+                    }
+                    cached_pnl[s] = pnl;
+                }
+            }
+        };
+        run_blocks(scheduler, threads, blocks, block);
+    }
+    PROFILE_COUNT("mc.scenarios", scenarios);
+
+    tail_work.assign(cached_pnl.begin(), cached_pnl.end());
+    tail_risk(tail_work.data(), total, confidence, var_out, es_out);
+}
+
+void MonteCarloEngine::update_spots(
+        const std::unordered_map<std::string, double>& spots,
+        double confidence, double& var_out, double& es_out)
+{
+    PROFILE_SCOPE("mc.update_spots");
+
+    if (cached_scenarios == 0)
+        throw std::runtime_error("MonteCarloEngine: update_spots() needs compute_cached() first");
+
+    const std::size_t total = cached_scenarios;
+    for (const auto& [ticker, S] : spots) {
+        auto it = ticker_index.find(ticker);
+        if (it == ticker_index.end())
+            throw std::runtime_error("MonteCarloEngine: unknown ticker " + ticker);
+        if (!(S > 0.0))
+            throw std::runtime_error("MonteCarloEngine: non-positive spot for " + ticker);
+
+        const std::size_t a = it->second;
+        revaluer->set_spot(a, S);
+        spot0[a] = S;
+
+        const double* mult = cached_mult.data() + a * total;
+        double* contrib = cached_contrib.data() + a * total;
+        double* pnl = cached_pnl.data();
+
+        double quantity;
+        if (revaluer->linear_asset(a, quantity)) {
+            // stock-only: contribution = q·S·(M - 1)
+            const double qs = quantity * S;
+            for (std::size_t s = 0; s < total; s++) {
+                double c = qs * (mult[s] - 1.0);
+                pnl[s] += c - contrib[s];
+                contrib[s] = c;
+            }
+        } else {
+            const double base = revaluer->asset_value(a, S);
+            for (std::size_t s = 0; s < total; s++) {
+                double c = revaluer->asset_value(a, S * mult[s]) - base;
+                pnl[s] += c - contrib[s];
+                contrib[s] = c;
+            }
+        }
+    }
+
+    tail_work.assign(cached_pnl.begin(), cached_pnl.end());
+    tail_risk(tail_work.data(), total, confidence, var_out, es_out);
+}
+
+std::vector<McSweepPoint> MonteCarloEngine::sweep(
+        const std::vector<double>& vol_scales,
+        const std::vector<double>& corr_shifts,
+        int scenarios, double confidence)
+{
+    if (scenarios < 1)
+        throw std::runtime_error("MonteCarloEngine: scenarios must be positive");
+    if (vol_scales.empty() || corr_shifts.empty())
+        throw std::runtime_error("MonteCarloEngine: empty sweep grid");
+    for (double v : vol_scales)
+        if (!(v > 0.0))
+            throw std::runtime_error("MonteCarloEngine: vol scale must be positive");
+    for (double w : corr_shifts)
+        if (!(w >= 0.0 && w < 1.0))
+            throw std::runtime_error("MonteCarloEngine: corr shift must be in [0, 1)");
+
+    const PortfolioRevaluer& rv = bound_revaluer();
+    PROFILE_SCOPE("mc.sweep");
+
+    const std::size_t total = static_cast<std::size_t>(scenarios);
+    const std::size_t n = tickers.size();
+    const std::size_t blocks = (total + MC_BLOCK - 1) / MC_BLOCK;
+    const std::size_t vols = vol_scales.size();
+    const std::size_t points = corr_shifts.size() * vols;
+    const std::size_t keep = std::min(tail_count(total, confidence), MC_BLOCK);
+
+    // calibrated correlation, recovered from the bound factor
+    std::vector<std::vector<double>> corr(n, std::vector<double>(n, 0.0));
+    for (std::size_t i = 0; i < n; i++)
+        for (std::size_t j = 0; j <= i; j++) {
+            double c = 0.0;
+            for (std::size_t k = 0; k <= j; k++) c += (*L)[i][k] * (*L)[j][k];
+            corr[i][j] = corr[j][i] = c;
+        }
+
+    // one factor per shifted correlation; a zero shift keeps the bound one
+    std::vector<std::vector<std::vector<double>>> shifted(corr_shifts.size());
+    for (std::size_t c = 0; c < corr_shifts.size(); c++) {
+        const double w = corr_shifts[c];
+        if (w == 0.0) continue;
+        std::vector<std::vector<double>> m = corr;
+        for (std::size_t i = 0; i < n; i++)
+            for (std::size_t j = 0; j < n; j++)
+                if (i != j) m[i][j] += w * (1.0 - m[i][j]);
+        shifted[c] = cholesky(m);
+    }
+
+    // per vol scale: σ' = v·σ, drift' = (μ - σ'²/2)·dt = drift + diffusion²·(1 - v²)/2
+    std::vector<double> drift_v(vols * n), diffusion_v(vols * n);
+    for (std::size_t v = 0; v < vols; v++) {
+        const double s = vol_scales[v];
+        for (std::size_t i = 0; i < n; i++) {
+            drift_v[v * n + i] = drift[i] + 0.5 * diffusion[i] * diffusion[i] * (1.0 - s * s);
+            diffusion_v[v * n + i] = diffusion[i] * s;
+        }
+    }
+
+    // worst `keep` of every (point, block), point-major; unused slots of a
+    // short last block stay +inf and never reach the tail
+    std::vector<double> tails(points * blocks * keep, std::numeric_limits<double>::infinity());
+
+    // ---- every (corr, block) pair in parallel ----
+    // each task regenerates its block's normals from compute()'s Philox
+    // streams, correlates them once and revalues the block at every vol
+    // scale, so nothing scenarios × assets is ever held
+    const std::size_t shifts = corr_shifts.size();
+    run_blocks(scheduler, threads, shifts * blocks, [&](std::size_t item) {
+        const std::size_t c = item / blocks, b = item % blocks;
+        const std::vector<std::vector<double>>& factor = corr_shifts[c] == 0.0 ? *L : shifted[c];
+
+        const std::size_t first = b * MC_BLOCK;
+        const std::size_t len = std::min(total, first + MC_BLOCK) - first;
+        double* z = thread_scratch(SHOCK_BATCH * n + MC_BLOCK * (2 * n + 1));
+        double* x = z + SHOCK_BATCH * n;    // correlated shocks of the block
+        double* prices = x + MC_BLOCK * n;
+        double* pnl = prices + MC_BLOCK * n;
+
+        for (std::size_t s0 = 0; s0 < len; s0 += SHOCK_BATCH) {
+            std::size_t m = std::min(SHOCK_BATCH, len - s0);
+            fill_normal_streams(SEED, first + s0, m, n, z);
+            for (std::size_t k = 0; k < m; k++) {
+                const double* zs = z + k * n;
+                double* xs = x + (s0 + k) * n;
+                for (std::size_t i = 0; i < n; i++) {
+                    double shock = 0.0;
+                    const double* row = factor[i].data();
+                    for (std::size_t j = 0; j <= i; j++) shock += row[j] * zs[j];
+                    xs[i] = shock;
+                }
+            }
+        }
+
+        for (std::size_t v = 0; v < vols; v++) {
+            const double* dr = drift_v.data() + v * n;
+            const double* df = diffusion_v.data() + v * n;
+            for (std::size_t k = 0; k < len * n; k += n)
+                for (std::size_t i = 0; i < n; i++)
+                    prices[k + i] = std::exp(dr[i] + df[i] * x[k + i]) * spot0[i];
+            rv.pnl_batch(prices, len, pnl);
+
+            std::size_t k = std::min(keep, len);
+            std::nth_element(pnl, pnl + (k - 1), pnl + len);
+            std::copy(pnl, pnl + k, tails.data() + ((c * vols + v) * blocks + b) * keep);
+        }
+    });
 
-    double sum = 0.0;
-    for (int i = 0; i <= idx; i++) sum += pnl[i];
-    es_out = -(sum / (idx + 1));
+    std::vector<McSweepPoint> out(points);
+    run_blocks(scheduler, threads, points, [&](std::size_t point) {
+        out[point].corr_shift = corr_shifts[point / vols];
+        out[point].vol_scale = vol_scales[point % vols];
+        tail_risk_candidates(tails.data() + point * blocks * keep, blocks * keep, total,
+                             confidence, out[point].var, out[point].es);
+    });
+    PROFILE_COUNT("mc.scenarios", total * out.size());
+    return out;
 }
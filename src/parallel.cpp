@@ -0,0 +1,51 @@
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "task_scheduler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+int resolve_thread_count(int requested) {
+    if (requested > 0) return requested;
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? static_cast<int>(hw) : 1;
+}
+
+void parallel_for(std::size_t count, int threads,
+                  const std::function<void(std::size_t)>& body)
+{
+    if (count == 0) return;
+
+    TaskScheduler* scheduler = threads == 1 || count == 1 ? nullptr : &TaskScheduler::global();
+    if (scheduler && scheduler->concurrency() > 1) {
+        const std::size_t lanes = threads > 1 ? static_cast<std::size_t>(threads) : count;
+        if (lanes >= count || lanes >= scheduler->concurrency()) {
+            scheduler->parallel_for(count, 1, body);
+            return;
+        }
+
+        // at most `threads` items in flight: that many lanes pull indices
+        // from a shared counter, the rest of the pool stays available
+        std::atomic<std::size_t> next{0};
+        std::atomic<bool> failed{false};
+        scheduler->parallel_for(lanes, 1, [&](std::size_t) {
+            for (std::size_t i; !failed && (i = next.fetch_add(1)) < count;) {
+                try {
+                    body(i);
+                } catch (...) {
+                    failed = true;
+                    throw;
+                }
+            }
+        });
+        return;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; i++) body(i);
+    if (profiler::enabled()) {
+        std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+        profiler::add_thread_busy(0, dt.count(), count);
+    }
+}
@@ -1,62 +1,244 @@
 #include "portfolio.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
 #include <fstream>
-#include <sstream>
+#include <limits>
 #include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+const char* option_type_name(OptionType t) {
+    switch (t) {
+        case OptionType::CALL: return "CALL";
+        case OptionType::PUT:  return "PUT";
+        default:               return "";
+    }
+}
+
+// ---------------------------------------------------------------------
+// Chunked, allocation-free parsing of portfolio rows.
+// ---------------------------------------------------------------------
+namespace {
+
+// Minimum bytes per parse chunk; small files are parsed in one piece.
+const std::size_t MIN_CHUNK_BYTES = 1 << 20;
+
+// Maximum number of fields read from a row.
+const int MAX_FIELDS = 6;
+
+struct ChunkResult {
+    std::vector<Instrument> rows;      ///< ticker_id indexes names
+    std::vector<std::string_view> names; ///< chunk-local ticker table
+    std::size_t lines = 0;       ///< newlines consumed by this chunk
+    std::size_t error_line = 0;  ///< 1-based line within the chunk, 0 = none
+    std::string error;
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+// from_chars with the leading '+' that std::stoi / std::stod accepted.
+template <class T>
+bool parse_number(std::string_view s, T& out) {
+    if (s.size() > 1 && s[0] == '+' && s[1] != '-') s.remove_prefix(1);
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+// Integer quantity; integral decimals such as "100.0" are accepted too.
+bool parse_quantity(std::string_view s, int& out) {
+    if (parse_number(s, out)) return true;
+    double d;
+    if (!parse_number(s, d) || d != std::trunc(d)) return false;
+    if (d < std::numeric_limits<int>::min() || d > std::numeric_limits<int>::max()) return false;
+    out = static_cast<int>(d);
+    return true;
+}
+
+// Parses one line into `inst` and its ticker field. Returns nullptr on
+// success or a message.
+const char* parse_row(std::string_view line, Instrument& inst, std::string_view& ticker) {
+    std::string_view f[MAX_FIELDS];
+    int n = 0;
+    while (n < MAX_FIELDS) {
+        std::size_t comma = line.find(',');
+        f[n++] = trim(line.substr(0, comma));
+        if (comma == std::string_view::npos) break;
+        line.remove_prefix(comma + 1);
+    }
 
-static std::vector<std::string> split(const std::string& line) {
-    std::vector<std::string> out;
-    std::stringstream ss(line);
-    std::string cell;
+    if (n < 3) return "invalid portfolio row";
 
-    while (std::getline(ss, cell, ',')) {
-        out.push_back(cell);
+    if (f[0] == "STOCK") {
+        inst.type = InstrumentType::STOCK;
+    } else if (f[0] == "OPTION") {
+        if (n < 6) return "invalid OPTION row";
+        inst.type = InstrumentType::OPTION;
+    } else {
+        return "unknown instrument type";
+    }
+
+    if (f[1].empty()) return "missing ticker";
+    ticker = f[1];
+    if (!parse_quantity(f[2], inst.quantity)) return "invalid quantity";
+
+    if (inst.type == InstrumentType::OPTION) {
+        if (!parse_number(f[3], inst.strike)) return "invalid strike";
+        if (!parse_number(f[4], inst.maturity)) return "invalid maturity";
+        if (f[5] == "CALL") inst.option_type = OptionType::CALL;
+        else if (f[5] == "PUT") inst.option_type = OptionType::PUT;
+        else return "unknown option type";
+    }
+    return nullptr;
+}
+
+void parse_chunk(const char* p, const char* end, ChunkResult& out) {
+    // a rough row-size guess keeps reallocations rare
+    out.rows.reserve(static_cast<std::size_t>(end - p) / 24);
+    std::unordered_map<std::string_view, std::uint32_t> ids;
+
+    while (p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* eol = nl ? nl : end;
+        std::string_view line(p, eol - p);
+        p = nl ? nl + 1 : end;
+        out.lines++;
+
+        if (trim(line).empty()) continue;
+
+        Instrument inst;
+        std::string_view ticker;
+        if (const char* err = parse_row(line, inst, ticker)) {
+            out.error_line = out.lines;
+            out.error = err;
+            return;
+        }
+        auto [it, inserted] = ids.try_emplace(ticker, static_cast<std::uint32_t>(out.names.size()));
+        if (inserted) out.names.push_back(ticker);
+        inst.ticker_id = it->second;
+        out.rows.push_back(inst);
     }
-    return out;
 }
 
-void Portfolio::load(const std::string& file) {
-    std::ifstream f(file);
-    if (!f.is_open()) {
+} // namespace
+
+void Portfolio::load(const std::string& file, int threads) {
+    PROFILE_SCOPE("portfolio.load");
+
+    MappedFile map;
+    if (!map.open(file)) {
         throw std::runtime_error("Cannot open portfolio file: " + file);
     }
 
-    instruments.clear();
-    std::string line;
+    parse(map.data(), map.size(), file, threads);
 
-    // skip header
-    std::getline(f, line);
+    PROFILE_COUNT("portfolio.rows", instruments.size());
+    PROFILE_COUNT("portfolio.bytes", map.size());
+}
 
-    while (std::getline(f, line)) {
-        if (line.empty())
-            continue;
+void Portfolio::load_from_string(const std::string& csv, const std::string& source) {
+    parse(csv.data(), csv.size(), source, 1);
+}
 
-        auto row = split(line);
-        if (row.size() < 3)
-            throw std::runtime_error("Invalid portfolio row: " + line);
+void Portfolio::parse(const char* data, std::size_t size, const std::string& file, int threads) {
+    instruments.clear();
+    tickers.clear();
+    ticker_ids.clear();
 
-        Instrument inst;
+    const char* begin = data;
+    const char* end = begin + size;
+    if (begin == end) return;
+
+    // skip header
+    const char* nl = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+    const char* body = nl ? nl + 1 : end;
 
-        // ----- TYPE -----
-        if (row[0] == "STOCK") {
-            inst.type = InstrumentType::STOCK;
-            inst.ticker = row[1];
-            inst.quantity = std::stoi(row[2]);
+    // split the body at line boundaries
+    std::size_t n_threads = static_cast<std::size_t>(resolve_thread_count(threads));
+    std::size_t target = std::max(MIN_CHUNK_BYTES,
+                                  static_cast<std::size_t>(end - body) / (n_threads * 4) + 1);
+    std::vector<const char*> bounds{body};
+    while (bounds.back() < end) {
+        const char* cut = bounds.back() + std::min<std::size_t>(target, end - bounds.back());
+        if (cut < end) {
+            const char* eol = static_cast<const char*>(std::memchr(cut, '\n', end - cut));
+            cut = eol ? eol + 1 : end;
         }
-        else if (row[0] == "OPTION") {
-            if (row.size() < 6)
-                throw std::runtime_error("Invalid OPTION row: " + line);
-
-            inst.type = InstrumentType::OPTION;
-            inst.ticker = row[1];
-            inst.quantity = std::stoi(row[2]);
-            inst.strike = std::stod(row[3]);
-            inst.maturity = std::stod(row[4]);
-            inst.option_type = row[5]; // CALL / PUT
+        bounds.push_back(cut);
+    }
+
+    std::vector<ChunkResult> chunks(bounds.size() - 1);
+    parallel_for(chunks.size(), threads, [&](std::size_t c) {
+        parse_chunk(bounds[c], bounds[c + 1], chunks[c]);
+    });
+
+    // report the first bad row in file order
+    std::size_t line_base = 1; // header line
+    std::size_t total = 0;
+    for (const auto& c : chunks) {
+        if (c.error_line) {
+            throw std::runtime_error(file + ":" + std::to_string(line_base + c.error_line)
+                                     + ": " + c.error);
         }
-        else {
-            throw std::runtime_error("Unknown instrument type: " + row[0]);
+        line_base += c.lines;
+        total += c.rows.size();
+    }
+
+    // chunk-local ticker ids -> portfolio ids, in file order
+    instruments.reserve(total);
+    std::vector<std::uint32_t> remap;
+    for (auto& c : chunks) {
+        remap.resize(c.names.size());
+        for (std::size_t j = 0; j < c.names.size(); j++) remap[j] = intern(c.names[j]);
+        for (Instrument& inst : c.rows) {
+            inst.ticker_id = remap[inst.ticker_id];
+            instruments.push_back(inst);
         }
+        std::vector<Instrument>().swap(c.rows);
+    }
+}
+
+std::uint32_t Portfolio::intern(std::string_view name) {
+    auto [it, inserted] = ticker_ids.try_emplace(std::string(name), static_cast<std::uint32_t>(tickers.size()));
+    if (inserted) tickers.push_back(it->first);
+    return it->second;
+}
 
-        instruments.push_back(inst);
+Instrument& Portfolio::add(InstrumentType type, std::string_view ticker, int quantity) {
+    std::uint32_t id = intern(ticker);
+    Instrument& inst = instruments.emplace_back();
+    inst.type = type;
+    inst.ticker_id = id;
+    inst.quantity = quantity;
+    return inst;
+}
+
+void Portfolio::save(const std::string& file) const {
+    std::ofstream out(file);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open portfolio output: " + file);
+    }
+
+    // strikes and maturities reload bit for bit
+    out.precision(std::numeric_limits<double>::max_digits10);
+    out << "type,ticker,quantity,strike,maturity,option_type\n";
+
+    for (const auto& inst : instruments) {
+        if (inst.type == InstrumentType::STOCK) {
+            out << "STOCK," << ticker(inst) << "," << inst.quantity << ",,,\n";
+        } else {
+            out << "OPTION," << ticker(inst) << "," << inst.quantity << ","
+                << inst.strike << "," << inst.maturity << ","
+                << option_type_name(inst.option_type) << "\n";
+        }
     }
 }
@@ -0,0 +1,90 @@
+#include "portfolio_compression.hpp"
+
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+struct ExposureKey {
+    std::uint32_t ticker_id;
+    InstrumentType type;
+    OptionType option_type;
+    double strike;
+    double maturity;
+
+    bool operator==(const ExposureKey& o) const {
+        return ticker_id == o.ticker_id && type == o.type && option_type == o.option_type
+            && strike == o.strike && maturity == o.maturity;
+    }
+};
+
+struct ExposureHash {
+    std::size_t operator()(const ExposureKey& k) const {
+        std::size_t h = std::hash<std::uint32_t>()(k.ticker_id);
+        auto mix = [&h](std::size_t v) { h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+        mix(static_cast<std::size_t>(k.type));
+        mix(static_cast<std::size_t>(k.option_type));
+        mix(std::hash<double>()(k.strike));
+        mix(std::hash<double>()(k.maturity));
+        return h;
+    }
+};
+
+ExposureKey exposure_key(const Instrument& inst) {
+    if (inst.type == InstrumentType::STOCK)
+        return {inst.ticker_id, inst.type, OptionType::NONE, 0.0, 0.0};
+    return {inst.ticker_id, inst.type, inst.option_type, inst.strike, inst.maturity};
+}
+
+} // namespace
+
+CompressedPortfolio compress_portfolio(const Portfolio& portfolio) {
+    const auto& rows = portfolio.instruments;
+
+    // ---- 1. Group rows by exposure, summing quantities ----
+    std::unordered_map<ExposureKey, std::size_t, ExposureHash> groups;
+    std::vector<std::size_t> first_row;
+    std::vector<std::int64_t> net;
+    std::vector<std::size_t> group_of(rows.size());
+
+    for (std::size_t i = 0; i < rows.size(); i++) {
+        auto [it, inserted] = groups.try_emplace(exposure_key(rows[i]), first_row.size());
+        if (inserted) {
+            first_row.push_back(i);
+            net.push_back(0);
+        }
+        group_of[i] = it->second;
+        net[it->second] += rows[i].quantity;
+    }
+
+    // ---- 2. Emit non-zero net positions ----
+    CompressedPortfolio out;
+    std::vector<std::size_t> position_of(first_row.size(), CompressedPortfolio::NO_POSITION);
+
+    for (std::size_t g = 0; g < first_row.size(); g++) {
+        if (net[g] == 0) continue;
+        if (net[g] > INT_MAX || net[g] < INT_MIN)
+            throw std::runtime_error("compress_portfolio: net quantity overflow for "
+                                     + portfolio.ticker(rows[first_row[g]]));
+
+        Instrument inst = rows[first_row[g]];
+        inst.quantity = static_cast<int>(net[g]);
+        inst.ticker_id = out.portfolio.intern(portfolio.ticker(inst));
+        if (inst.type == InstrumentType::STOCK) {
+            inst.strike = 0.0;
+            inst.maturity = 0.0;
+            inst.option_type = OptionType::NONE;
+        }
+        position_of[g] = out.portfolio.instruments.size();
+        out.portfolio.instruments.push_back(std::move(inst));
+    }
+
+    out.row_to_position.resize(rows.size());
+    for (std::size_t i = 0; i < rows.size(); i++)
+        out.row_to_position[i] = position_of[group_of[i]];
+
+    return out;
+}
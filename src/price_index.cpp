@@ -0,0 +1,46 @@
+#include "price_index.hpp"
+#include "market_data_history.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+PriceIndex::PriceIndex(const MarketDataHistory& history,
+                       const std::vector<std::string>& tickers)
+    : names(tickers)
+{
+    calendar = history.calendar().union_dates();
+    backing = history.mapping();
+
+    closes.resize(names.size());
+    owned.resize(names.size());
+    for (std::size_t t = 0; t < names.size(); t++) {
+        if (!history.has_ticker(names[t]))
+            throw std::runtime_error("PriceIndex: no ticker " + names[t]);
+        closes[t] = history.union_column(names[t], owned[t]);
+    }
+
+    for (std::size_t k = 0; k < calendar.size(); k++) {
+        bool all = true;
+        for (const double* col : closes) {
+            if (std::isnan(col[k])) { all = false; break; }
+        }
+        if (all) complete.push_back(k);
+    }
+}
+
+int PriceIndex::date_index(int date) const
+{
+    auto it = std::lower_bound(calendar.begin(), calendar.end(), date);
+    if (it == calendar.end() || *it != date) return -1;
+    return static_cast<int>(it - calendar.begin());
+}
+
+int PriceIndex::previous_complete_index(int date) const
+{
+    // complete holds calendar indices, which are ordered like the dates
+    auto it = std::upper_bound(complete.begin(), complete.end(), date,
+        [&](int d, std::size_t k) { return d < calendar[k]; });
+    if (it == complete.begin()) return -1;
+    return static_cast<int>(*(it - 1));
+}
@@ -0,0 +1,140 @@
+#include "profiler.hpp"
+
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace profiler {
+namespace {
+
+struct Stage {
+    std::string name;
+    std::uint64_t calls = 0;
+    double seconds = 0.0;
+    std::uint64_t allocations = 0;
+};
+
+struct ThreadSlot {
+    double busy_seconds = 0.0;
+    std::uint64_t tasks = 0;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<Stage> stages;                       // first-seen order
+    std::unordered_map<std::string, std::size_t> stage_index;
+    std::vector<std::pair<std::string, std::uint64_t>> counters;
+    std::unordered_map<std::string, std::size_t> counter_index;
+    std::vector<ThreadSlot> threads;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+std::atomic<std::uint64_t> allocation_count{0};
+
+// JSON string escaping for stage / counter names.
+std::string quoted(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+} // namespace
+
+void set_enabled(bool on) {
+    if (on && !enabled()) {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().started = std::chrono::steady_clock::now();
+    }
+    enabled_flag().store(on, std::memory_order_relaxed);
+}
+
+void reset() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.stages.clear();
+    r.stage_index.clear();
+    r.counters.clear();
+    r.counter_index.clear();
+    r.threads.clear();
+    r.started = std::chrono::steady_clock::now();
+    allocation_count.store(0, std::memory_order_relaxed);
+}
+
+void add_stage(const char* name, double seconds, std::uint64_t allocs) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto [it, inserted] = r.stage_index.try_emplace(name, r.stages.size());
+    if (inserted) r.stages.push_back({name});
+    Stage& s = r.stages[it->second];
+    s.calls++;
+    s.seconds += seconds;
+    s.allocations += allocs;
+}
+
+void add_counter(const char* name, std::uint64_t value) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto [it, inserted] = r.counter_index.try_emplace(name, r.counters.size());
+    if (inserted) r.counters.emplace_back(name, 0);
+    r.counters[it->second].second += value;
+}
+
+void add_thread_busy(std::size_t slot, double seconds, std::uint64_t tasks) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (r.threads.size() <= slot) r.threads.resize(slot + 1);
+    r.threads[slot].busy_seconds += seconds;
+    r.threads[slot].tasks += tasks;
+}
+
+void count_allocation() {
+    if (enabled()) allocation_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint64_t allocations() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+void write_report(const std::string& file) {
+    std::ofstream out(file);
+    if (!out.is_open())
+        throw std::runtime_error("Cannot open profile report: " + file);
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::chrono::duration<double> total = std::chrono::steady_clock::now() - r.started;
+
+    out.precision(9);
+    out << "{\n  \"total_seconds\": " << total.count()
+        << ",\n  \"allocations\": " << allocations()
+        << ",\n  \"stages\": [\n";
+    for (std::size_t i = 0; i < r.stages.size(); i++) {
+        const Stage& s = r.stages[i];
+        out << "    {\"name\": " << quoted(s.name) << ", \"calls\": " << s.calls
+            << ", \"seconds\": " << s.seconds << ", \"allocations\": " << s.allocations
+            << "}" << (i + 1 < r.stages.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"counters\": {";
+    for (std::size_t i = 0; i < r.counters.size(); i++) {
+        out << (i ? ", " : "") << quoted(r.counters[i].first) << ": " << r.counters[i].second;
+    }
+    out << "},\n  \"threads\": [\n";
+    for (std::size_t i = 0; i < r.threads.size(); i++) {
+        out << "    {\"slot\": " << i << ", \"busy_seconds\": " << r.threads[i].busy_seconds
+            << ", \"tasks\": " << r.threads[i].tasks << "}"
+            << (i + 1 < r.threads.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace profiler
@@ -1,6 +1,7 @@
 #include "realized_risk.hpp"
 #include "market_data_history.hpp"
 #include "portfolio.hpp"
+#include "profiler.hpp"
 #include <algorithm>
 #include <stdexcept>
 
@@ -8,12 +9,15 @@ RealizedRisk compute_realized_risk(
     const Portfolio& portfolio,
     const MarketDataHistory& history,
     const std::string& snapshot_date,
-    int horizon_days
+    int horizon_days,
+    double confidence
 ) {
+    PROFILE_SCOPE("realized_risk");
+
     // 1. Compute portfolio value on snapshot date
     double V0 = 0.0;
     for (const auto& pos : portfolio.instruments) {
-        double p = history.get_price(pos.ticker, snapshot_date);
+        double p = history.get_price(portfolio.ticker(pos), snapshot_date);
         V0 += pos.quantity * p;
     }
 
@@ -30,7 +34,7 @@ RealizedRisk compute_realized_risk(
     for (const auto& d : future_dates) {
         double Vt = 0.0;
         for (const auto& pos : portfolio.instruments) {
-            double p = history.get_price(pos.ticker, d);
+            double p = history.get_price(portfolio.ticker(pos), d);
             Vt += pos.quantity * p;
         }
 
@@ -43,7 +47,7 @@ RealizedRisk compute_realized_risk(
     std::sort(losses.begin(), losses.end());  
 
     int n = losses.size();
-    int idx = int(0.95 * n);
+    int idx = int(confidence * n);
     if (idx >= n) idx = n - 1;
 
     double VaR = losses[idx];
@@ -0,0 +1,188 @@
+#include "revaluation.hpp"
+#include "portfolio_compression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+PortfolioRevaluer::PortfolioRevaluer(
+        const Portfolio& portfolio,
+        const std::vector<std::string>& tickers,
+        const std::vector<double>& spot_prices)
+    : spot(spot_prices)
+{
+    if (spot.size() != tickers.size())
+        throw std::runtime_error("PortfolioRevaluer: spot/ticker size mismatch");
+
+    std::unordered_map<std::string, std::size_t> index;
+    for (std::size_t i = 0; i < tickers.size(); i++) index[tickers[i]] = i;
+
+    // identical exposures are valued once per scenario
+    CompressedPortfolio net = compress_portfolio(portfolio);
+
+    // market column of each ticker id of the net book
+    std::vector<std::size_t> asset_of;
+    asset_of.reserve(net.portfolio.tickers.size());
+    for (const auto& name : net.portfolio.tickers) {
+        auto it = index.find(name);
+        if (it == index.end())
+            throw std::runtime_error("PortfolioRevaluer: no market data for " + name);
+        asset_of.push_back(it->second);
+    }
+
+    positions.reserve(net.portfolio.instruments.size());
+    for (const auto& inst : net.portfolio.instruments) {
+        Position p;
+        p.asset = asset_of[inst.ticker_id];
+        p.quantity = inst.quantity;
+        p.strike = inst.strike;
+        if (inst.type == InstrumentType::STOCK) p.kind = Kind::STOCK;
+        else p.kind = (inst.option_type == OptionType::CALL) ? Kind::CALL : Kind::PUT;
+
+        positions.push_back(p);
+        v0 += value(p, spot[p.asset]);
+    }
+    index_assets();
+}
+
+void PortfolioRevaluer::index_assets() {
+    const std::size_t n = spot.size();
+    asset_begin.assign(n + 1, 0);
+    for (const auto& p : positions) asset_begin[p.asset + 1]++;
+    for (std::size_t a = 0; a < n; a++) asset_begin[a + 1] += asset_begin[a];
+
+    asset_positions.resize(positions.size());
+    std::vector<std::size_t> fill(asset_begin.begin(), asset_begin.end() - 1);
+    for (std::size_t i = 0; i < positions.size(); i++)
+        asset_positions[fill[positions[i].asset]++] = i;
+
+    asset_grid.assign(n, -1);
+    for (std::size_t g = 0; g < grids.size(); g++) asset_grid[grids[g].asset] = static_cast<int>(g);
+}
+
+double PortfolioRevaluer::asset_value(std::size_t asset, double S) const {
+    double v = 0.0;
+    for (std::size_t k = asset_begin[asset]; k < asset_begin[asset + 1]; k++)
+        v += value(positions[asset_positions[k]], S);
+    if (asset_grid[asset] >= 0) v += grids[asset_grid[asset]].eval(S);
+    return v;
+}
+
+bool PortfolioRevaluer::linear_asset(std::size_t asset, double& quantity) const {
+    if (asset_grid[asset] >= 0) return false;
+    quantity = 0.0;
+    for (std::size_t k = asset_begin[asset]; k < asset_begin[asset + 1]; k++) {
+        const Position& p = positions[asset_positions[k]];
+        if (p.kind != Kind::STOCK) return false;
+        quantity += p.quantity;
+    }
+    return true;
+}
+
+void PortfolioRevaluer::set_spot(std::size_t asset, double S) {
+    v0 += asset_value(asset, S) - asset_value(asset, spot[asset]);
+    spot[asset] = S;
+}
+
+double PortfolioRevaluer::pnl(const double* prices) const {
+    double v1 = 0.0;
+    for (const auto& p : positions) v1 += value(p, prices[p.asset]);
+    for (const auto& g : grids) v1 += g.eval(prices[g.asset]);
+    return v1 - v0;
+}
+
+double PortfolioRevaluer::OptionGrid::eval(double S) const {
+    if (S <= nodes.front()) return values.front() + slope_lo * (S - nodes.front());
+    if (S >= nodes.back()) return values.back() + slope_hi * (S - nodes.back());
+
+    std::size_t b = static_cast<std::size_t>((S - nodes.front()) * inv_bucket);
+    std::size_t c = bucket[std::min(b, bucket.size() - 1)];
+    while (nodes[c + 1] < S) c++;
+
+    double w = (S - nodes[c]) / (nodes[c + 1] - nodes[c]);
+    return values[c] + w * (values[c + 1] - values[c]);
+}
+
+double PortfolioRevaluer::enable_option_grid(std::size_t min_options, double tolerance) {
+    const std::size_t n = spot.size();
+
+    std::vector<std::vector<Position>> options(n);
+    for (const auto& p : positions)
+        if (p.kind != Kind::STOCK) options[p.asset].push_back(p);
+
+    auto exact = [this](const std::vector<Position>& book, double S) {
+        double v = 0.0;
+        for (const auto& p : book) v += value(p, S);
+        return v;
+    };
+
+    double max_error = 0.0;
+    std::vector<bool> gridded(n, false);
+
+    for (std::size_t a = 0; a < n; a++) {
+        const auto& book = options[a];
+        if (book.size() < std::max<std::size_t>(min_options, 1)) continue;
+
+        OptionGrid g;
+        g.asset = a;
+        g.slope_lo = 0.0;
+        g.slope_hi = 0.0;
+        double scale = 0.0;
+        for (const auto& p : book) {
+            g.nodes.push_back(p.strike);
+            if (p.kind == Kind::PUT) g.slope_lo -= p.quantity;
+            else g.slope_hi += p.quantity;
+            scale += std::fabs(p.quantity);
+        }
+        std::sort(g.nodes.begin(), g.nodes.end());
+        g.nodes.erase(std::unique(g.nodes.begin(), g.nodes.end()), g.nodes.end());
+        scale *= 1.0 + g.nodes.back();
+
+        for (double k : g.nodes) g.values.push_back(exact(book, k));
+
+        // uniform buckets over [first, last] node, ~4 per cell
+        std::size_t cells = g.nodes.size() - 1;
+        if (cells > 0) {
+            std::size_t buckets = 4 * cells;
+            g.inv_bucket = buckets / (g.nodes.back() - g.nodes.front());
+            g.bucket.resize(buckets);
+            std::size_t c = 0;
+            for (std::size_t b = 0; b < buckets; b++) {
+                double left = g.nodes.front() + b / g.inv_bucket;
+                while (c + 1 < cells && g.nodes[c + 1] <= left) c++;
+                g.bucket[b] = static_cast<std::uint32_t>(c);
+            }
+        } else {
+            g.inv_bucket = 0.0;
+        }
+
+        // error bound check against exact per-option pricing
+        std::vector<double> probe = {0.0, g.nodes.front() * 0.5, g.nodes.back() * 1.5 + 1.0};
+        for (std::size_t c = 0; c < g.nodes.size(); c++) {
+            probe.push_back(g.nodes[c]);
+            if (c + 1 < g.nodes.size()) probe.push_back(0.5 * (g.nodes[c] + g.nodes[c + 1]));
+        }
+        double err = 0.0;
+        for (double S : probe) err = std::max(err, std::fabs(g.eval(S) - exact(book, S)));
+        if (err > tolerance * scale) continue;
+
+        max_error = std::max(max_error, err);
+        gridded[a] = true;
+        grids.push_back(std::move(g));
+    }
+
+    positions.erase(std::remove_if(positions.begin(), positions.end(), [&](const Position& p) {
+        return p.kind != Kind::STOCK && gridded[p.asset];
+    }), positions.end());
+    index_assets();
+
+    return max_error;
+}
+
+void PortfolioRevaluer::pnl_batch(const double* prices, std::size_t count, double* out) const {
+    const std::size_t n = spot.size();
+    for (std::size_t s = 0; s < count; s++) {
+        out[s] = pnl(prices + s * n);
+    }
+}
@@ -0,0 +1,41 @@
+#include "risk_measures.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+std::size_t tail_count(std::size_t n, double confidence)
+{
+    long idx = (long)((1.0 - confidence) * n);
+    if (idx < 0) idx = 0;
+    if (idx >= (long)n) idx = (long)n - 1;
+    return static_cast<std::size_t>(idx) + 1;
+}
+
+void tail_risk_candidates(double* candidates, std::size_t m, std::size_t n,
+                          double confidence, double& var_out, double& es_out)
+{
+    PROFILE_SCOPE("tail_risk");
+
+    if (n == 0)
+        throw std::runtime_error("tail_risk: no scenarios");
+
+    const std::size_t k = tail_count(n, confidence);
+    if (m < k)
+        throw std::runtime_error("tail_risk: fewer candidates than tail scenarios");
+    const std::size_t idx = k - 1;
+
+    // everything before idx is <= candidates[idx] afterwards
+    std::nth_element(candidates, candidates + idx, candidates + m);
+    var_out = -candidates[idx];
+
+    double sum = 0.0;
+    for (std::size_t i = 0; i <= idx; i++) sum += candidates[i];
+    es_out = -(sum / k);
+}
+
+void tail_risk(double* pnl, std::size_t n, double confidence,
+               double& var_out, double& es_out)
+{
+    tail_risk_candidates(pnl, n, n, confidence, var_out, es_out);
+}
@@ -0,0 +1,354 @@
+#include "risk_server.hpp"
+#include "cholesky.hpp"
+#include "historical_var.hpp"
+#include "market_data_history.hpp"
+#include "monte_carlo.hpp"
+#include "parallel.hpp"
+#include "portfolio.hpp"
+#include "task_scheduler.hpp"
+#include "trading_day_utils.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Fixed set of threads draining a FIFO of jobs.
+class WorkerPool {
+public:
+    explicit WorkerPool(int threads) {
+        int n = resolve_thread_count(threads);
+        for (int i = 0; i < n; i++) workers.emplace_back([this] { work(); });
+    }
+
+    ~WorkerPool() { drain(); }
+
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        ready.notify_one();
+    }
+
+    // Runs all queued jobs and joins the threads.
+    void drain() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        ready.notify_all();
+        for (auto& t : workers)
+            if (t.joinable()) t.join();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> workers;
+    bool closing = false;
+
+    void work() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return closing || !jobs.empty(); });
+                if (jobs.empty()) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+Portfolio request_portfolio(const JsonValue& req) {
+    Portfolio p;
+    if (const JsonValue* path = req.find("portfolio")) {
+        p.load(path->as_string(), 1);
+    } else if (const JsonValue* csv = req.find("portfolio_csv")) {
+        p.load_from_string(csv->as_string(), "portfolio_csv");
+    } else if (const JsonValue* rows = req.find("positions")) {
+        for (const auto& row : rows->as_array()) {
+            InstrumentType kind;
+            std::string type = row.get("type", std::string("STOCK"));
+            if (type == "STOCK") kind = InstrumentType::STOCK;
+            else if (type == "OPTION") kind = InstrumentType::OPTION;
+            else throw std::runtime_error("unknown instrument type: " + type);
+
+            std::string ticker = row.get("ticker", std::string());
+            if (ticker.empty()) throw std::runtime_error("position without ticker");
+            Instrument& inst = p.add(kind, ticker, static_cast<int>(row.get("quantity", 0.0)));
+
+            if (inst.type == InstrumentType::OPTION) {
+                inst.strike = row.get("strike", 0.0);
+                inst.maturity = row.get("maturity", 0.0);
+                std::string right = row.get("option_type", std::string());
+                if (right == "CALL") inst.option_type = OptionType::CALL;
+                else if (right == "PUT") inst.option_type = OptionType::PUT;
+                else throw std::runtime_error("unknown option type: " + right);
+            }
+        }
+    } else {
+        throw std::runtime_error("request needs portfolio, portfolio_csv or positions");
+    }
+
+    if (p.instruments.empty()) throw std::runtime_error("empty portfolio");
+    return p;
+}
+
+} // namespace
+
+RiskServer::RiskServer(const MarketDataHistory& h, RiskServerConfig cfg)
+    : history(h), config(cfg),
+      request_threads(std::max(1, static_cast<int>(TaskScheduler::global().concurrency())
+                                  / resolve_thread_count(cfg.threads))) {}
+
+std::size_t RiskServer::cache_size() const {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache.size();
+}
+
+std::shared_ptr<const RiskServer::Calibration> RiskServer::calibration(
+    const std::vector<std::string>& tickers, const std::string& date, int lookback, bool& hit)
+{
+    std::string key = date + "|" + std::to_string(lookback);
+    for (const auto& t : tickers) key += "|" + t;
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        if (it != cache.end()) {
+            hit = true;
+            return it->second;
+        }
+    }
+
+    // calibrate outside the lock; a concurrent miss on the same key just
+    // computes the same result twice
+    hit = false;
+    auto cal = std::make_shared<Calibration>();
+    cal->snapshot = build_snapshot(history, tickers, date, lookback);
+    cal->cholesky = cholesky(cal->snapshot.corr);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (cache.emplace(key, cal).second) {
+        cache_order.push_back(key);
+        while (cache.size() > std::max<std::size_t>(config.cache_capacity, 1)) {
+            cache.erase(cache_order.front());
+            cache_order.pop_front();
+        }
+    }
+    return cal;
+}
+
+JsonValue RiskServer::run(const JsonValue& req) {
+    JsonValue res = JsonValue::object();
+    std::string cmd = req.get("cmd", std::string("var"));
+
+    if (cmd == "stats") {
+        res["requests"] = static_cast<double>(served.load());
+        res["cache_hits"] = static_cast<double>(cache_hits.load());
+        res["cache_size"] = cache_size();
+        return res;
+    }
+    if (cmd == "shutdown") {
+        stop();
+        return res;
+    }
+    if (cmd != "var") throw std::runtime_error("unknown cmd: " + cmd);
+
+    Portfolio portfolio = request_portfolio(req);
+
+    for (const auto& name : portfolio.tickers) {
+        if (!history.has_ticker(name))
+            throw std::runtime_error("no history for ticker " + name);
+    }
+    std::vector<std::string> tickers = portfolio.tickers;
+    std::sort(tickers.begin(), tickers.end());
+
+    int target = parse_date(req.get("date", std::string()));
+    if (target < 0) throw std::runtime_error("request needs a YYYY-MM-DD date");
+    std::string date = format_date(history.calendar().previous_common_date(target));
+
+    int horizon = static_cast<int>(req.get("horizon", 10.0));
+    int lookback = static_cast<int>(req.get("lookback", double(config.lookback_days)));
+    double confidence = req.get("confidence", 0.95);
+    int scenarios = static_cast<int>(req.get("scenarios", 10000.0));
+    std::string method = req.get("method", std::string("mc"));
+
+    if (horizon < 1 || lookback < 2 || scenarios < 1 || !(confidence > 0.0 && confidence < 1.0))
+        throw std::runtime_error("invalid horizon, lookback, scenarios or confidence");
+
+    double var = 0.0, es = 0.0, value = 0.0;
+    if (method == "mc") {
+        bool hit = false;
+        auto cal = calibration(tickers, date, lookback, hit);
+        if (hit) cache_hits++;
+        res["cache"] = hit ? "hit" : "miss";
+
+        // one engine per worker thread, rebound per request: the cached
+        // factor is used in place and the scenario workspace is reused
+        thread_local std::unique_ptr<MonteCarloEngine> mc;
+        if (!mc || mc->horizon() != horizon) mc = std::make_unique<MonteCarloEngine>(horizon);
+        mc->bind_market(cal->snapshot, cal->cholesky);
+        mc->bind_portfolio(portfolio);
+        mc->set_threads(request_threads);
+        mc->compute(scenarios, confidence, var, es);
+        value = mc->base_value();
+    } else if (method == "historical") {
+        HistoricalVarSpec spec;
+        spec.horizon_days = horizon;
+        spec.lookback_days = lookback;
+        spec.confidence = confidence;
+        spec.threads = request_threads;
+        HistoricalVarResult hs = compute_historical_var(portfolio, history, date, spec);
+        var = hs.var;
+        es = hs.es;
+        value = hs.portfolio_value;
+    } else {
+        throw std::runtime_error("unknown method: " + method);
+    }
+
+    res["date"] = date;
+    res["var"] = var;
+    res["es"] = es;
+    res["portfolio_value"] = value;
+    return res;
+}
+
+std::string RiskServer::handle(const std::string& line) {
+    auto t0 = std::chrono::steady_clock::now();
+    JsonValue res;
+    JsonValue id;
+
+    try {
+        JsonValue req = parse_json(line);
+        if (!req.is_object()) throw std::runtime_error("request must be a JSON object");
+        if (const JsonValue* v = req.find("id")) id = *v;
+        res = run(req);
+        res["ok"] = true;
+    } catch (const std::exception& e) {
+        res = JsonValue::object();
+        res["ok"] = false;
+        res["error"] = std::string(e.what());
+    }
+
+    served++;
+    if (!id.is_null()) res["id"] = id;
+    res["elapsed_ms"] = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
+    return res.dump();
+}
+
+void RiskServer::stop() {
+    stopping = true;
+    int fd = listen_fd.load();
+    if (fd >= 0) ::shutdown(fd, SHUT_RDWR);   // wakes a blocked accept()
+
+    // wake connections blocked in recv(); pending replies are still sent
+    std::lock_guard<std::mutex> lock(connection_mutex);
+    for (int conn : connections) ::shutdown(conn, SHUT_RD);
+}
+
+void RiskServer::serve_stream(std::istream& in, std::ostream& out) {
+    std::mutex out_mutex;
+    WorkerPool pool(config.threads);
+
+    std::string line;
+    while (!stopping && std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        pool.submit([this, line, &out, &out_mutex] {
+            std::string reply = handle(line);
+            std::lock_guard<std::mutex> lock(out_mutex);
+            out << reply << '\n';
+            out.flush();
+        });
+    }
+    pool.drain();
+}
+
+void RiskServer::serve_unix_socket(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path))
+        throw std::runtime_error("Socket path too long: " + path);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw std::runtime_error("Cannot create socket: " + std::string(std::strerror(errno)));
+
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    ::unlink(path.c_str());
+
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 64) < 0) {
+        std::string err = std::strerror(errno);
+        ::close(fd);
+        throw std::runtime_error("Cannot listen on " + path + ": " + err);
+    }
+    listen_fd = fd;
+
+    {
+        WorkerPool pool(config.threads);
+        while (!stopping) {
+            int conn = ::accept(fd, nullptr, nullptr);
+            if (conn < 0) {
+                if (errno == EINTR) continue;
+                break;   // shut down by stop()
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(connection_mutex);
+                connections.insert(conn);
+            }
+
+            pool.submit([this, conn] {
+                std::string buffer;
+                char chunk[4096];
+                for (;;) {
+                    ssize_t got = ::recv(conn, chunk, sizeof(chunk), 0);
+                    if (got <= 0) break;
+                    buffer.append(chunk, static_cast<std::size_t>(got));
+
+                    std::size_t start = 0, nl;
+                    while ((nl = buffer.find('\n', start)) != std::string::npos) {
+                        std::string line = buffer.substr(start, nl - start);
+                        start = nl + 1;
+                        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+                        std::string reply = handle(line) + "\n";
+                        for (std::size_t sent = 0; sent < reply.size();) {
+                            ssize_t n = ::send(conn, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+                            if (n <= 0) { start = buffer.size(); break; }
+                            sent += static_cast<std::size_t>(n);
+                        }
+                    }
+                    buffer.erase(0, start);
+                    if (stopping) break;
+                }
+
+                std::lock_guard<std::mutex> lock(connection_mutex);
+                connections.erase(conn);
+                ::close(conn);
+            });
+        }
+    }
+
+    listen_fd = -1;
+    ::close(fd);
+    ::unlink(path.c_str());
+}
@@ -0,0 +1,194 @@
+#include "scenario_file.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char SCENARIO_MAGIC[8] = {'M','C','R','S','C','E','N','1'};
+static const std::uint32_t SCENARIO_VERSION = 1;
+
+static std::uint64_t align8(std::uint64_t x) {
+    return (x + 7) & ~std::uint64_t(7);
+}
+
+static std::uint64_t groups_of(const ScenarioFileHeader& h) {
+    return (h.n_scenarios + h.group_rows - 1) / h.group_rows;
+}
+
+static std::uint64_t rows_of(const ScenarioFileHeader& h, std::uint64_t g) {
+    std::uint64_t first = g * h.group_rows;
+    return std::min<std::uint64_t>(h.group_rows, h.n_scenarios - first);
+}
+
+static std::uint64_t group_offset(const ScenarioFileHeader& h, std::uint64_t g) {
+    return h.data_offset + g * h.group_rows * h.n_columns * sizeof(double);
+}
+
+// pwrite() may write less than asked; loop until done
+static bool write_all(int fd, const void* data, std::size_t bytes, std::uint64_t offset) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t w = ::pwrite(fd, p, bytes, static_cast<off_t>(offset));
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        bytes -= static_cast<std::size_t>(w);
+        offset += static_cast<std::uint64_t>(w);
+    }
+    return true;
+}
+
+ScenarioFileColumn scenario_column(ScenarioColumnKind kind, const std::string& name,
+                                   std::uint32_t asset) {
+    ScenarioFileColumn c{};
+    if (name.size() >= sizeof(c.name))
+        throw std::runtime_error("Column name too long for scenario file: " + name);
+    std::memcpy(c.name, name.data(), name.size());
+    c.kind = kind;
+    c.asset = asset;
+    return c;
+}
+
+// ---- writer ----
+
+ScenarioFileWriter::ScenarioFileWriter(const std::string& path_,
+                                       std::uint64_t n_scenarios,
+                                       std::uint32_t group_rows,
+                                       const std::vector<ScenarioFileColumn>& columns,
+                                       std::uint32_t horizon_days,
+                                       std::uint64_t seed)
+    : path(path_)
+{
+    if (n_scenarios == 0 || group_rows == 0 || columns.empty())
+        throw std::runtime_error("Scenario file needs scenarios, group rows and columns: " + path);
+
+    std::memcpy(header.magic, SCENARIO_MAGIC, sizeof(SCENARIO_MAGIC));
+    header.version = SCENARIO_VERSION;
+    header.n_columns = static_cast<std::uint32_t>(columns.size());
+    header.n_scenarios = n_scenarios;
+    header.group_rows = group_rows;
+    header.horizon_days = horizon_days;
+    header.seed = seed;
+    header.column_offset = align8(sizeof(ScenarioFileHeader));
+    header.data_offset = align8(header.column_offset + columns.size() * sizeof(ScenarioFileColumn));
+    header.file_size = header.data_offset + n_scenarios * columns.size() * sizeof(double);
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Cannot write scenario file: " + path);
+
+    // size first: groups land at fixed offsets in whatever order they come.
+    // The header stays zero until close(), so an interrupted run leaves a
+    // file the reader rejects.
+    if (::ftruncate(fd, static_cast<off_t>(header.file_size)) != 0
+        || !write_all(fd, columns.data(), columns.size() * sizeof(ScenarioFileColumn),
+                      header.column_offset)) {
+        ::close(fd);
+        fd = -1;
+        throw std::runtime_error("Error writing scenario file: " + path);
+    }
+}
+
+ScenarioFileWriter::~ScenarioFileWriter() {
+    if (fd >= 0) ::close(fd);
+}
+
+std::size_t ScenarioFileWriter::n_groups() const {
+    return static_cast<std::size_t>(groups_of(header));
+}
+
+std::size_t ScenarioFileWriter::rows_in_group(std::size_t g) const {
+    return static_cast<std::size_t>(rows_of(header, g));
+}
+
+void ScenarioFileWriter::write_group(std::size_t g, const double* data) {
+    if (fd < 0)
+        throw std::runtime_error("Scenario file already closed: " + path);
+    if (g >= n_groups())
+        throw std::runtime_error("Scenario file group out of range: " + path);
+
+    std::size_t bytes = rows_in_group(g) * header.n_columns * sizeof(double);
+    if (!write_all(fd, data, bytes, group_offset(header, g)))
+        throw std::runtime_error("Error writing scenario file: " + path);
+}
+
+void ScenarioFileWriter::close() {
+    if (fd < 0) return;
+    bool ok = write_all(fd, &header, sizeof(header), 0);
+    int rc = ::close(fd);
+    fd = -1;
+    if (!ok || rc != 0)
+        throw std::runtime_error("Error closing scenario file: " + path);
+}
+
+// ---- reader ----
+
+void ScenarioFile::open(const std::string& path) {
+    if (!file.open(path))
+        throw std::runtime_error("Cannot open scenario file: " + path);
+
+    if (file.size() < sizeof(ScenarioFileHeader))
+        throw std::runtime_error("Scenario file too small: " + path);
+
+    header = reinterpret_cast<const ScenarioFileHeader*>(file.data());
+    static const char unfinished[sizeof(SCENARIO_MAGIC)] = {};
+    if (std::memcmp(header->magic, unfinished, sizeof(unfinished)) == 0)
+        throw std::runtime_error("Scenario file was not completed: " + path);
+    if (std::memcmp(header->magic, SCENARIO_MAGIC, sizeof(SCENARIO_MAGIC)) != 0)
+        throw std::runtime_error("Not a scenario file: " + path);
+    if (header->version != SCENARIO_VERSION)
+        throw std::runtime_error("Unsupported scenario file version in " + path);
+    if (header->file_size != file.size())
+        throw std::runtime_error("Scenario file truncated: " + path);
+
+    std::uint64_t index_end = header->column_offset
+        + std::uint64_t(header->n_columns) * sizeof(ScenarioFileColumn);
+    std::uint64_t data_end = header->data_offset
+        + header->n_scenarios * header->n_columns * sizeof(double);
+    if (header->group_rows == 0 || index_end > header->data_offset || data_end != file.size())
+        throw std::runtime_error("Corrupt scenario file header: " + path);
+
+    index = reinterpret_cast<const ScenarioFileColumn*>(file.data() + header->column_offset);
+}
+
+std::size_t ScenarioFile::n_groups() const {
+    return static_cast<std::size_t>(groups_of(*header));
+}
+
+std::size_t ScenarioFile::rows_in_group(std::size_t g) const {
+    return static_cast<std::size_t>(rows_of(*header, g));
+}
+
+std::string ScenarioFile::column_name(std::size_t i) const {
+    const char* n = index[i].name;
+    return std::string(n, strnlen(n, sizeof(index[i].name)));
+}
+
+int ScenarioFile::find_column(ScenarioColumnKind kind, const std::string& name) const {
+    for (std::size_t i = 0; i < n_columns(); i++)
+        if (index[i].kind == kind && column_name(i) == name) return static_cast<int>(i);
+    return -1;
+}
+
+const double* ScenarioFile::group_column(std::size_t g, std::size_t c) const {
+    std::uint64_t offset = group_offset(*header, g) + c * rows_of(*header, g) * sizeof(double);
+    return reinterpret_cast<const double*>(file.data() + offset);
+}
+
+std::vector<double> ScenarioFile::read_column(std::size_t c) const {
+    std::vector<double> out(n_scenarios());
+    double* dst = out.data();
+    for (std::size_t g = 0; g < n_groups(); g++) {
+        const double* src = group_column(g, c);
+        std::size_t rows = rows_in_group(g);
+        std::memcpy(dst, src, rows * sizeof(double));
+        dst += rows;
+    }
+    return out;
+}
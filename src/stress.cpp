@@ -0,0 +1,255 @@
+#include "stress.hpp"
+#include "market_data_history.hpp"
+#include "parallel.hpp"
+#include "price_index.hpp"
+#include "profiler.hpp"
+#include "trading_day_utils.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+// scenarios revalued per task
+static const std::size_t STRESS_BLOCK = 256;
+
+namespace {
+
+std::string trim(const std::string& s) {
+    std::size_t b = s.find_first_not_of(" \t");
+    if (b == std::string::npos) return "";
+    std::size_t e = s.find_last_not_of(" \t");
+    return s.substr(b, e - b + 1);
+}
+
+std::vector<std::string> split_csv(const std::string& line) {
+    std::vector<std::string> out;
+    std::size_t start = 0;
+    while (true) {
+        std::size_t comma = line.find(',', start);
+        out.push_back(trim(line.substr(start, comma - start)));
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    return out;
+}
+
+std::vector<double> snapshot_spots(const MarketSnapshot& snap) {
+    std::vector<double> spot(snap.tickers.size());
+    for (std::size_t i = 0; i < spot.size(); i++) spot[i] = snap.spot.at(snap.tickers[i]);
+    return spot;
+}
+
+} // namespace
+
+void StressScenarios::append(const StressScenarios& other) {
+    const std::size_t n = tickers.size();
+    std::unordered_map<std::string, std::size_t> column;
+    for (std::size_t j = 0; j < other.tickers.size(); j++) column[other.tickers[j]] = j;
+
+    shocks.reserve(shocks.size() + other.size() * n);
+    for (std::size_t s = 0; s < other.size(); s++) {
+        for (std::size_t i = 0; i < n; i++) {
+            auto it = column.find(tickers[i]);
+            shocks.push_back(it == column.end() ? 0.0 : other.row(s)[it->second]);
+        }
+        names.push_back(other.names[s]);
+    }
+}
+
+StressScenarios historical_stress_windows(const MarketDataHistory& history,
+                                          const std::vector<std::string>& tickers,
+                                          const std::string& from_date,
+                                          const std::string& to_date,
+                                          int horizon_days)
+{
+    PROFILE_SCOPE("stress.history");
+
+    int from = parse_date(from_date), to = parse_date(to_date);
+    if (from < 0 || to < 0)
+        throw std::runtime_error("historical_stress_windows: invalid date range "
+                                 + from_date + " .. " + to_date);
+    if (horizon_days < 1)
+        throw std::runtime_error("historical_stress_windows: horizon must be positive");
+
+    PriceIndex index(history, tickers);
+    const auto& dates = index.dates();
+    const auto& complete = index.complete_dates();
+
+    // complete dates inside [from, to]
+    auto lo = std::lower_bound(complete.begin(), complete.end(), from,
+        [&](std::size_t k, int d) { return dates[k] < d; });
+    auto hi = std::upper_bound(complete.begin(), complete.end(), to,
+        [&](int d, std::size_t k) { return d < dates[k]; });
+    const std::size_t first = lo - complete.begin(), last = hi - complete.begin();
+    const std::size_t h = static_cast<std::size_t>(horizon_days);
+    if (last < first + h + 1)
+        throw std::runtime_error("historical_stress_windows: no " + std::to_string(h)
+                                 + "-day window between " + from_date + " and " + to_date);
+
+    const std::size_t n = tickers.size(), windows = last - first - h;
+    StressScenarios out;
+    out.tickers = tickers;
+    out.names.reserve(windows);
+    out.shocks.resize(windows * n);
+    for (std::size_t j = 0; j < windows; j++) {
+        std::size_t k0 = complete[first + j], k1 = complete[first + j + h];
+        out.names.push_back(format_date(dates[k0]) + "+" + std::to_string(h));
+        for (std::size_t i = 0; i < n; i++)
+            out.shocks[j * n + i] = index.price(i, k1) / index.price(i, k0) - 1.0;
+    }
+    return out;
+}
+
+std::unordered_map<std::string, std::string> load_sector_map(const std::string& file) {
+    std::ifstream f(file);
+    if (!f.is_open())
+        throw std::runtime_error("Cannot open sector file: " + file);
+
+    std::unordered_map<std::string, std::string> sectors;
+    std::string line;
+    std::size_t line_no = 0;
+    while (std::getline(f, line)) {
+        line_no++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (trim(line).empty() || line[0] == '#') continue;
+
+        auto fields = split_csv(line);
+        if (fields.size() != 2 || fields[0].empty())
+            throw std::runtime_error(file + ":" + std::to_string(line_no) + ": expected ticker,sector");
+        if (line_no == 1 && fields[0] == "ticker") continue; // header
+        sectors[fields[0]] = fields[1];
+    }
+    return sectors;
+}
+
+StressScenarios load_stress_scenarios(const std::string& file,
+                                      const std::vector<std::string>& tickers,
+                                      const std::unordered_map<std::string, std::string>& sectors)
+{
+    std::ifstream f(file);
+    if (!f.is_open())
+        throw std::runtime_error("Cannot open stress scenario file: " + file);
+
+    const std::size_t n = tickers.size();
+    std::unordered_map<std::string, std::size_t> column;
+    for (std::size_t i = 0; i < n; i++) column[tickers[i]] = i;
+
+    // per scenario and ticker: shock and the precedence it was set with
+    // (0 = unset, 1 = '*', 2 = sector, 3 = ticker)
+    StressScenarios out;
+    out.tickers = tickers;
+    std::vector<unsigned char> level;
+    std::unordered_map<std::string, std::size_t> scenario_index;
+
+    std::string line;
+    std::size_t line_no = 0;
+    while (std::getline(f, line)) {
+        line_no++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (trim(line).empty() || line[0] == '#') continue;
+
+        auto where = [&] { return file + ":" + std::to_string(line_no) + ": "; };
+        auto fields = split_csv(line);
+        if (fields.size() != 3 || fields[0].empty() || fields[1].empty())
+            throw std::runtime_error(where() + "expected scenario,target,shock");
+        if (line_no == 1 && fields[0] == "scenario") continue; // header
+
+        double shock;
+        try {
+            std::size_t used = 0;
+            shock = std::stod(fields[2], &used);
+            if (used != fields[2].size()) throw std::invalid_argument(fields[2]);
+        } catch (const std::exception&) {
+            throw std::runtime_error(where() + "invalid shock '" + fields[2] + "'");
+        }
+        if (!(shock > -1.0))
+            throw std::runtime_error(where() + "shock must be above -1");
+
+        auto [it, added] = scenario_index.emplace(fields[0], out.names.size());
+        if (added) {
+            out.names.push_back(fields[0]);
+            out.shocks.resize(out.shocks.size() + n, 0.0);
+            level.resize(level.size() + n, 0);
+        }
+        double* row = out.shocks.data() + it->second * n;
+        unsigned char* lvl = level.data() + it->second * n;
+
+        auto apply = [&](std::size_t i, unsigned char l) {
+            if (l >= lvl[i]) { row[i] = shock; lvl[i] = l; }
+        };
+
+        const std::string& target = fields[1];
+        if (target == "*") {
+            for (std::size_t i = 0; i < n; i++) apply(i, 1);
+        } else if (target.rfind("sector:", 0) == 0) {
+            std::string sector = target.substr(7);
+            bool known = false;
+            for (const auto& [t, s] : sectors) if (s == sector) { known = true; break; }
+            if (!known)
+                throw std::runtime_error(where() + "unknown sector '" + sector + "'");
+            for (std::size_t i = 0; i < n; i++) {
+                auto s = sectors.find(tickers[i]);
+                if (s != sectors.end() && s->second == sector) apply(i, 2);
+            }
+        } else {
+            auto c = column.find(target);
+            if (c != column.end()) apply(c->second, 3);
+        }
+    }
+    return out;
+}
+
+StressEngine::StressEngine(const Portfolio& portfolio, const MarketSnapshot& snap)
+    : tickers(snap.tickers), spot(snapshot_spots(snap)), revaluer(portfolio, tickers, spot)
+{
+}
+
+StressResult StressEngine::run(const StressScenarios& scenarios, std::size_t worst_n,
+                               int threads) const
+{
+    PROFILE_SCOPE("stress.run");
+
+    const std::size_t n = tickers.size(), m = scenarios.tickers.size();
+    const std::size_t count = scenarios.size();
+
+    // engine asset -> shock column, or -1 (stays at spot)
+    std::unordered_map<std::string, std::size_t> column;
+    for (std::size_t j = 0; j < m; j++) column[scenarios.tickers[j]] = j;
+    std::vector<long> source(n, -1);
+    for (std::size_t i = 0; i < n; i++) {
+        auto it = column.find(tickers[i]);
+        if (it != column.end()) source[i] = static_cast<long>(it->second);
+    }
+
+    StressResult res;
+    res.portfolio_value = revaluer.base_value();
+    res.pnl.resize(count);
+
+    std::size_t blocks = (count + STRESS_BLOCK - 1) / STRESS_BLOCK;
+    parallel_for(blocks, threads, [&](std::size_t b) {
+        std::size_t lo = b * STRESS_BLOCK;
+        std::size_t hi = std::min(count, lo + STRESS_BLOCK);
+
+        std::vector<double> prices((hi - lo) * n);
+        for (std::size_t s = lo; s < hi; s++) {
+            const double* shock = scenarios.row(s);
+            double* row = prices.data() + (s - lo) * n;
+            for (std::size_t i = 0; i < n; i++)
+                row[i] = source[i] < 0 ? spot[i] : spot[i] * (1.0 + shock[source[i]]);
+        }
+        revaluer.pnl_batch(prices.data(), hi - lo, res.pnl.data() + lo);
+    });
+    PROFILE_COUNT("stress.scenarios", count);
+
+    // worst first; equal P&L keeps input order
+    std::size_t k = std::min(worst_n, count);
+    std::vector<std::size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::partial_sort(order.begin(), order.begin() + k, order.end(),
+        [&](std::size_t a, std::size_t b) {
+            return res.pnl[a] < res.pnl[b] || (res.pnl[a] == res.pnl[b] && a < b);
+        });
+    res.worst.assign(order.begin(), order.begin() + k);
+    return res;
+}
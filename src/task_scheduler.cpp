@@ -0,0 +1,364 @@
+#include "task_scheduler.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// Index of the current thread's deque in its scheduler, -1 outside.
+thread_local const void* tls_scheduler = nullptr;
+thread_local int tls_worker = -1;
+
+std::mutex global_mutex;
+int global_threads = 0;
+bool global_pin = false;
+std::unique_ptr<TaskScheduler> global_instance;
+
+std::uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Parses a sysfs CPU list such as "0-3,8-11".
+std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream ss(text);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (part.empty() || part == "\n") continue;
+        std::size_t dash = part.find('-');
+        int lo = std::stoi(part.substr(0, dash));
+        int hi = dash == std::string::npos ? lo : std::stoi(part.substr(dash + 1));
+        for (int c = lo; c <= hi; c++) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+std::set<int> allowed_cpus() {
+    std::set<int> cpus;
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++)
+            if (CPU_ISSET(c, &mask)) cpus.insert(c);
+    }
+#endif
+    if (cpus.empty()) {
+        unsigned hw = std::thread::hardware_concurrency();
+        for (unsigned c = 0; c < std::max(hw, 1u); c++) cpus.insert(static_cast<int>(c));
+    }
+    return cpus;
+}
+
+bool pin_thread(std::thread& t, int cpu) {
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    return pthread_setaffinity_np(t.native_handle(), sizeof(mask), &mask) == 0;
+#else
+    (void)t;
+    (void)cpu;
+    return false;
+#endif
+}
+
+} // namespace
+
+NumaTopology NumaTopology::detect() {
+    NumaTopology topo;
+    std::set<int> allowed = allowed_cpus();
+
+    for (int node = 0; node < 1024; node++) {
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!in) {
+            if (node > 0) break;   // node ids are dense on Linux
+            continue;
+        }
+        std::string line;
+        std::getline(in, line);
+        std::vector<int> cpus;
+        for (int c : parse_cpu_list(line))
+            if (allowed.erase(c)) cpus.push_back(c);
+        if (!cpus.empty()) topo.nodes.push_back(std::move(cpus));
+    }
+
+    // CPUs sysfs did not mention (or no sysfs at all) form one more node
+    if (!allowed.empty()) topo.nodes.emplace_back(allowed.begin(), allowed.end());
+    return topo;
+}
+
+std::size_t NumaTopology::cpu_count() const {
+    std::size_t n = 0;
+    for (const auto& node : nodes) n += node.size();
+    return n;
+}
+
+// Completion state of one parallel_for call.
+struct TaskScheduler::Group {
+    std::atomic<std::size_t> outstanding{0};
+    std::atomic<bool> failed{false};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+};
+
+WorkerStats SchedulerStats::total() const {
+    WorkerStats t;
+    for (const auto& w : threads) {
+        t.tasks += w.tasks;
+        t.steals += w.steals;
+        t.failed_steals += w.failed_steals;
+        t.busy_seconds += w.busy_seconds;
+        t.idle_seconds += w.idle_seconds;
+    }
+    return t;
+}
+
+TaskScheduler::TaskScheduler(int threads, bool pin_threads) {
+    std::size_t n = threads > 1 ? static_cast<std::size_t>(threads) - 1 : 0;
+    counters.emplace_back(std::make_unique<Counters>());
+    for (std::size_t i = 0; i < n; i++) {
+        queues.emplace_back(std::make_unique<Queue>());
+        counters.emplace_back(std::make_unique<Counters>());
+    }
+    worker_cpu.assign(n, -1);
+    worker_node.assign(n, 0);
+
+    // CPUs node by node, so consecutive workers share a node; with more
+    // workers than CPUs the assignment wraps around
+    if (pin_threads && n > 0) {
+        NumaTopology topo = NumaTopology::detect();
+        std::vector<std::pair<int, int>> slots;   // (cpu, node)
+        for (std::size_t node = 0; node < topo.nodes.size(); node++)
+            for (int cpu : topo.nodes[node]) slots.emplace_back(cpu, static_cast<int>(node));
+        for (std::size_t i = 0; i < n; i++) {
+            worker_cpu[i] = slots[i % slots.size()].first;
+            worker_node[i] = slots[i % slots.size()].second;
+        }
+    }
+
+    for (std::size_t i = 0; i < n; i++) {
+        workers.emplace_back([this, i] { worker_loop(i); });
+        if (worker_cpu[i] >= 0 && pin_thread(workers.back(), worker_cpu[i])) pin = true;
+        else worker_cpu[i] = -1;
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    stopping = true;
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+TaskScheduler& TaskScheduler::global() {
+    std::lock_guard<std::mutex> lock(global_mutex);
+    if (!global_instance) {
+        int n = global_threads;
+        if (n <= 0) {
+            unsigned hw = std::thread::hardware_concurrency();
+            n = hw > 0 ? static_cast<int>(hw) : 1;
+        }
+        global_instance = std::make_unique<TaskScheduler>(n, global_pin);
+    }
+    return *global_instance;
+}
+
+bool TaskScheduler::configure_global(int threads, bool pin_threads) {
+    std::lock_guard<std::mutex> lock(global_mutex);
+    if (global_instance) return false;
+    global_threads = threads;
+    global_pin = pin_threads;
+    return true;
+}
+
+int TaskScheduler::current_node() const {
+    return tls_scheduler == this && tls_worker >= 0 ? worker_node[tls_worker] : 0;
+}
+
+void TaskScheduler::push(int self, const Task& t) {
+    Queue& q = self >= 0 ? *queues[self] : injection;
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(t);
+    }
+    pending.fetch_add(1, std::memory_order_release);
+    wake.notify_one();
+}
+
+bool TaskScheduler::pop_local(int self, Task& t) {
+    Queue& q = self >= 0 ? *queues[self] : injection;
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    // owners take the newest range (LIFO keeps the working set hot);
+    // the injection queue is shared and served oldest first
+    if (self >= 0) {
+        t = q.tasks.back();
+        q.tasks.pop_back();
+    } else {
+        t = q.tasks.front();
+        q.tasks.pop_front();
+    }
+    pending.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool TaskScheduler::steal(int self, Task& t) {
+    const std::size_t n = queues.size();
+    thread_local std::minstd_rand rng(std::random_device{}());
+    std::size_t start = n ? rng() % n : 0;
+    const int home = self >= 0 ? worker_node[self] : -1;
+
+    // pass 0: victims on the thief's own node; pass 1: everyone else
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 0 && home < 0) continue;
+        for (std::size_t k = 0; k <= n; k++) {
+            // the injection queue is tried after every worker deque
+            if (k < n) {
+                bool local = worker_node[(start + k) % n] == home;
+                if (local != (pass == 0)) continue;
+            } else if (pass == 0) {
+                continue;
+            }
+            Queue& q = k < n ? *queues[(start + k) % n] : injection;
+            if (&q == (self >= 0 ? queues[self].get() : &injection)) continue;
+
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty()) continue;
+            t = q.tasks.front();   // oldest = largest range
+            q.tasks.pop_front();
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            counters[self + 1]->steals++;
+            return true;
+        }
+    }
+    counters[self + 1]->failed_steals++;
+    return false;
+}
+
+bool TaskScheduler::try_run_one(int self) {
+    Task t;
+    if (!pop_local(self, t) && !steal(self, t)) return false;
+    execute(self, t);
+    return true;
+}
+
+void TaskScheduler::execute(int self, Task t) {
+    // split off upper halves for other threads until the range is small
+    while (t.end - t.begin > t.grain) {
+        std::size_t mid = t.begin + (t.end - t.begin) / 2;
+        Task upper = t;
+        upper.begin = mid;
+        t.end = mid;
+        t.group->outstanding.fetch_add(1, std::memory_order_relaxed);
+        push(self, upper);
+    }
+
+    Counters& c = *counters[self + 1];
+    std::uint64_t t0 = now_ns();
+    if (!t.group->failed.load(std::memory_order_relaxed)) {
+        try {
+            t.fn(t.ctx, t.begin, t.end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(t.group->error_mutex);
+            if (!t.group->error) t.group->error = std::current_exception();
+            t.group->failed = true;
+        }
+    }
+    std::uint64_t dt = now_ns() - t0;
+    c.tasks++;
+    c.busy_ns += dt;
+    if (profiler::enabled())
+        profiler::add_thread_busy(static_cast<std::size_t>(self + 1), dt * 1e-9, 1);
+
+    t.group->outstanding.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void TaskScheduler::worker_loop(std::size_t index) {
+    tls_scheduler = this;
+    tls_worker = static_cast<int>(index);
+    const int self = static_cast<int>(index);
+
+    while (!stopping) {
+        if (try_run_one(self)) continue;
+
+        std::uint64_t t0 = now_ns();
+        {
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(1), [this] {
+                return stopping || pending.load(std::memory_order_acquire) > 0;
+            });
+        }
+        counters[self + 1]->idle_ns += now_ns() - t0;
+    }
+}
+
+void TaskScheduler::parallel_for(std::size_t count, std::size_t grain,
+                                 const std::function<void(std::size_t)>& body)
+{
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    Group group;
+    group.outstanding = 1;
+
+    Task root;
+    root.fn = [](const void* ctx, std::size_t b, std::size_t e) {
+        const auto& f = *static_cast<const std::function<void(std::size_t)>*>(ctx);
+        for (std::size_t i = b; i < e; i++) f(i);
+    };
+    root.ctx = &body;
+    root.begin = 0;
+    root.end = count;
+    root.grain = grain;
+    root.group = &group;
+
+    const int self = tls_scheduler == this ? tls_worker : -1;
+    execute(self, root);
+
+    // help until every range of this call has finished
+    while (group.outstanding.load(std::memory_order_acquire) > 0) {
+        if (!try_run_one(self)) std::this_thread::yield();
+    }
+
+    if (group.error) std::rethrow_exception(group.error);
+}
+
+SchedulerStats TaskScheduler::stats() const {
+    SchedulerStats s;
+    for (const auto& c : counters) {
+        WorkerStats w;
+        w.tasks = c->tasks;
+        w.steals = c->steals;
+        w.failed_steals = c->failed_steals;
+        w.busy_seconds = c->busy_ns * 1e-9;
+        w.idle_seconds = c->idle_ns * 1e-9;
+        if (!s.threads.empty()) {
+            w.cpu = worker_cpu[s.threads.size() - 1];
+            w.node = worker_node[s.threads.size() - 1];
+        }
+        s.threads.push_back(w);
+    }
+    return s;
+}
+
+void TaskScheduler::reset_stats() {
+    for (auto& c : counters) {
+        c->tasks = 0;
+        c->steals = 0;
+        c->failed_steals = 0;
+        c->busy_ns = 0;
+        c->idle_ns = 0;
+    }
+}
@@ -0,0 +1,241 @@
+#include "trading_calendar.hpp"
+#include "profiler.hpp"
+#include "trading_day_utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+static int date_key(const std::string& ticker, const std::string& d)
+{
+    int key = parse_date(d);
+    if (key < 0)
+        throw std::runtime_error("Invalid date '" + d + "' for " + ticker);
+    return key;
+}
+
+void TradingCalendar::build(const PriceStore& prices)
+{
+    PROFILE_SCOPE("calendar.build");
+
+    names.clear();
+    index.clear();
+    rows = 0;
+
+    for (const auto& [ticker, _] : prices) names.push_back(ticker);
+    std::sort(names.begin(), names.end());
+    for (std::size_t i = 0; i < names.size(); i++)
+        index[names[i]] = static_cast<int>(i);
+
+    // ---- 1. Union calendar ----
+    all_dates.clear();
+    for (const auto& [ticker, series] : prices) {
+        rows += series.size();
+        for (const auto& [d, _] : series) all_dates.push_back(date_key(ticker, d));
+    }
+    std::sort(all_dates.begin(), all_dates.end());
+    all_dates.erase(std::unique(all_dates.begin(), all_dates.end()), all_dates.end());
+
+    // ---- 2. Availability bitmaps (merge walk, series are date-ordered) ----
+    std::size_t words = (all_dates.size() + 63) / 64;
+    bits.assign(names.size(), std::vector<std::uint64_t>(words, 0));
+
+    for (std::size_t t = 0; t < names.size(); t++) {
+        std::size_t k = 0;
+        for (const auto& [d, _] : prices.at(names[t])) {
+            int key = date_key(names[t], d);
+            while (all_dates[k] < key) k++;
+            bits[t][k >> 6] |= std::uint64_t(1) << (k & 63);
+        }
+    }
+
+    // ---- 3. Common calendar ----
+    common.clear();
+    rebuild_common(0);
+}
+
+void TradingCalendar::build(const std::int32_t* axis, std::size_t n_axis,
+                            const std::vector<Column>& columns)
+{
+    PROFILE_SCOPE("calendar.build");
+
+    std::vector<const Column*> order;
+    for (const auto& c : columns) order.push_back(&c);
+    std::sort(order.begin(), order.end(),
+              [](const Column* a, const Column* b) { return a->ticker < b->ticker; });
+
+    names.clear();
+    index.clear();
+    rows = 0;
+    for (std::size_t i = 0; i < order.size(); i++) {
+        names.push_back(order[i]->ticker);
+        index[names[i]] = static_cast<int>(i);
+    }
+
+    // ---- 1. Union calendar: axis dates on which some column has a value ----
+    std::vector<char> traded(n_axis, 0);
+    for (const Column* c : order) {
+        for (std::size_t j = 0; j < c->count; j++) {
+            if (std::isnan(c->values[j])) continue;
+            traded[c->first + j] = 1;
+            rows++;
+        }
+    }
+
+    all_dates.clear();
+    std::vector<std::size_t> position(n_axis);   // axis index -> union index
+    for (std::size_t k = 0; k < n_axis; k++) {
+        if (!traded[k]) continue;
+        position[k] = all_dates.size();
+        all_dates.push_back(axis[k]);
+    }
+
+    // ---- 2. Availability bitmaps ----
+    std::size_t words = (all_dates.size() + 63) / 64;
+    bits.assign(names.size(), std::vector<std::uint64_t>(words, 0));
+
+    for (std::size_t t = 0; t < order.size(); t++) {
+        const Column& c = *order[t];
+        for (std::size_t j = 0; j < c.count; j++) {
+            if (std::isnan(c.values[j])) continue;
+            std::size_t k = position[c.first + j];
+            bits[t][k >> 6] |= std::uint64_t(1) << (k & 63);
+        }
+    }
+
+    // ---- 3. Common calendar ----
+    common.clear();
+    rebuild_common(0);
+}
+
+void TradingCalendar::rebuild_common(std::size_t from_idx)
+{
+    std::size_t words = (all_dates.size() + 63) / 64;
+    for (std::size_t w = from_idx >> 6; w < words; w++) {
+        std::uint64_t m = ~std::uint64_t(0);
+        for (const auto& b : bits) m &= b[w];
+
+        for (std::size_t k = std::max(w * 64, from_idx); k < std::min((w + 1) * 64, all_dates.size()); k++) {
+            if ((m >> (k & 63)) & 1u) common.push_back(all_dates[k]);
+        }
+    }
+}
+
+void TradingCalendar::extend(const PriceStore& prices, const std::vector<std::string>& changed)
+{
+    if (all_dates.empty() || prices.size() != names.size()) {
+        build(prices);
+        return;
+    }
+
+    int last = all_dates.back();
+    std::string last_text = format_date(last);
+
+    // collect dates past the end of the calendar
+    std::vector<int> fresh;
+    std::size_t added = 0;
+    for (const auto& t : changed) {
+        if (ticker_index(t) < 0) {
+            build(prices);
+            return;
+        }
+        const auto& series = prices.at(t);
+        for (auto it = series.upper_bound(last_text); it != series.end(); ++it) {
+            fresh.push_back(date_key(t, it->first));
+            added++;
+        }
+    }
+
+    // anything not explained by appended dates (back-fills) needs a rebuild
+    std::size_t total = 0;
+    for (const auto& [_, series] : prices) total += series.size();
+    if (total != rows + added) {
+        build(prices);
+        return;
+    }
+
+    std::sort(fresh.begin(), fresh.end());
+    fresh.erase(std::unique(fresh.begin(), fresh.end()), fresh.end());
+
+    std::size_t old_size = all_dates.size();
+    all_dates.insert(all_dates.end(), fresh.begin(), fresh.end());
+
+    std::size_t words = (all_dates.size() + 63) / 64;
+    for (auto& b : bits) b.resize(words, 0);
+
+    for (const auto& t : changed) {
+        auto& b = bits[ticker_index(t)];
+        const auto& series = prices.at(t);
+        for (auto it = series.upper_bound(last_text); it != series.end(); ++it) {
+            std::size_t k = std::lower_bound(all_dates.begin() + old_size, all_dates.end(),
+                                             date_key(t, it->first)) - all_dates.begin();
+            b[k >> 6] |= std::uint64_t(1) << (k & 63);
+        }
+    }
+
+    rows = total;
+    rebuild_common(old_size);
+}
+
+bool TradingCalendar::matches(const PriceStore& prices) const
+{
+    if (prices.size() != names.size()) return false;
+
+    std::size_t total = 0;
+    for (const auto& [_, series] : prices) total += series.size();
+    return total == rows;
+}
+
+int TradingCalendar::ticker_index(const std::string& ticker) const
+{
+    auto it = index.find(ticker);
+    return it == index.end() ? -1 : it->second;
+}
+
+int TradingCalendar::union_index(int date) const
+{
+    auto it = std::lower_bound(all_dates.begin(), all_dates.end(), date);
+    if (it == all_dates.end() || *it != date) return -1;
+    return static_cast<int>(it - all_dates.begin());
+}
+
+int TradingCalendar::previous_common_date(int target) const
+{
+    if (common.empty())
+        throw std::runtime_error("No common dates across tickers!");
+
+    auto it = std::upper_bound(common.begin(), common.end(), target);
+    if (it == common.begin())
+        throw std::runtime_error("No common date <= target (" + format_date(target) + ")");
+
+    return *(it - 1);
+}
+
+int TradingCalendar::offset_date(int date, int k) const
+{
+    auto it = std::upper_bound(common.begin(), common.end(), date);
+    if (it == common.begin()) return -1;
+
+    long pos = static_cast<long>(it - common.begin()) - 1 + k;
+    if (pos < 0 || pos >= static_cast<long>(common.size())) return -1;
+    return common[pos];
+}
+
+std::vector<int> TradingCalendar::past_dates(int date, int n) const
+{
+    std::vector<int> out;
+    auto it = std::lower_bound(common.begin(), common.end(), date);
+
+    while (it != common.begin() && static_cast<int>(out.size()) < n) {
+        --it;
+        out.push_back(*it);
+    }
+    return out;
+}
+
+std::vector<int> TradingCalendar::future_dates(int date, int n) const
+{
+    auto it = std::upper_bound(common.begin(), common.end(), date);
+    auto stop = it + std::min<long>(std::max(n, 0), common.end() - it);
+    return std::vector<int>(it, stop);
+}
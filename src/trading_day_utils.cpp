@@ -1,4 +1,5 @@
 #include "trading_day_utils.hpp"
+#include "profiler.hpp"
 #include <algorithm>
 #include <stdexcept>
 
@@ -6,6 +7,8 @@ std::string find_common_previous_date(
     const std::unordered_map<std::string, std::vector<std::string>>& ticker_dates,
     const std::string& target)
 {
+    PROFILE_SCOPE("find_common_previous_date");
+
     if (ticker_dates.empty())
         throw std::runtime_error("No tickers provided to date alignment");
 
@@ -45,3 +48,80 @@ std::string find_common_previous_date(
 
     return best;
 }
+
+int parse_date(const char* s, std::size_t len)
+{
+    // YYYY-MM-DD
+    if (len != 10 || s[4] != '-' || s[7] != '-')
+        return -1;
+
+    int v = 0;
+    for (int i = 0; i < 10; i++) {
+        if (i == 4 || i == 7) continue;
+        unsigned d = static_cast<unsigned>(s[i] - '0');
+        if (d > 9) return -1;
+        v = v * 10 + static_cast<int>(d);
+    }
+
+    int month = (v / 100) % 100;
+    int day = v % 100;
+    if (month < 1 || month > 12 || day < 1 || day > 31)
+        return -1;
+
+    return v;
+}
+
+int parse_date(const std::string& s)
+{
+    return parse_date(s.data(), s.size());
+}
+
+std::string format_date(int yyyymmdd)
+{
+    char buf[11];
+    int y = yyyymmdd / 10000;
+    int m = (yyyymmdd / 100) % 100;
+    int d = yyyymmdd % 100;
+
+    buf[0] = char('0' + (y / 1000) % 10);
+    buf[1] = char('0' + (y / 100) % 10);
+    buf[2] = char('0' + (y / 10) % 10);
+    buf[3] = char('0' + y % 10);
+    buf[4] = '-';
+    buf[5] = char('0' + m / 10);
+    buf[6] = char('0' + m % 10);
+    buf[7] = '-';
+    buf[8] = char('0' + d / 10);
+    buf[9] = char('0' + d % 10);
+    buf[10] = '\0';
+
+    return std::string(buf, 10);
+}
+
+// days_from_civil / civil_from_days (proleptic Gregorian calendar)
+static long days_from_civil(int y, int m, int d)
+{
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+int add_calendar_days(int yyyymmdd, int days)
+{
+    long z = days_from_civil(yyyymmdd / 10000, (yyyymmdd / 100) % 100, yyyymmdd % 100) + days;
+
+    z += 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long doe = z - era * 146097;
+    long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long mp = (5 * doy + 2) / 153;
+    int d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    int m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    int y = static_cast<int>(yoe + era * 400 + (m <= 2));
+
+    return y * 10000 + m * 100 + d;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "market_snapshot.hpp"
+
+/**
+ * @brief Small correlated market shared by the engine tests.
+ *
+ * Tickers A, B, C at 100 / 50 / 20 with daily vols 2% / 3% / 1%, zero
+ * drift and correlations 0.5 (A-B), 0.2 (A-C), 0.1 (B-C). Tests adjust
+ * the copy they get (spot shift, drift, vol scale) instead of redefining it.
+ */
+inline MarketSnapshot three_asset_snapshot() {
+    MarketSnapshot snap;
+    snap.tickers = {"A", "B", "C"};
+    snap.spot = {{"A", 100.0}, {"B", 50.0}, {"C", 20.0}};
+    snap.mu = {0.0, 0.0, 0.0};
+    snap.sigma = {0.02, 0.03, 0.01};
+    snap.corr = {{1.0, 0.5, 0.2}, {0.5, 1.0, 0.1}, {0.2, 0.1, 1.0}};
+    return snap;
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "backtest.hpp"
+#include "market_data_history.hpp"
+#include "market_snapshot.hpp"
+#include "monte_carlo.hpp"
+#include "portfolio.hpp"
+#include "trading_day_utils.hpp"
+#include <cmath>
+#include <random>
+
+static MarketDataHistory random_history(int days) {
+    MarketDataHistory h;
+    std::mt19937_64 rng(7);
+    std::normal_distribution<double> z(0.0, 0.01);
+
+    double a = 100, b = 50;
+    int date = 20200101;
+    for (int d = 0; d < days; d++) {
+        date = add_calendar_days(date, 1);
+        double common = z(rng);
+        a *= std::exp(common + z(rng));
+        b *= std::exp(0.5 * common + z(rng));
+        h.prices["AAA"][format_date(date)] = a;
+        h.prices["BBB"][format_date(date)] = b;
+    }
+    h.rebuild_calendar();
+    return h;
+}
+
+TEST(BacktestTest, KupiecAndChristoffersenStatistics) {
+    // exactly the expected rate: no evidence against the model
+    EXPECT_NEAR(kupiec_test(5, 100, 0.05).lr, 0.0, 1e-12);
+    EXPECT_NEAR(kupiec_test(5, 100, 0.05).p_value, 1.0, 1e-12);
+
+    // 15 exceptions in 100 at 5%: strongly rejected
+    LikelihoodRatio bad = kupiec_test(15, 100, 0.05);
+    EXPECT_GT(bad.lr, 10.0);
+    EXPECT_LT(bad.p_value, 0.01);
+
+    // clustered exceptions fail independence, spread-out ones do not
+    std::vector<bool> clustered(100, false), spread(100, false);
+    for (int i = 40; i < 45; i++) clustered[i] = true;
+    for (int i = 0; i < 100; i += 20) spread[i] = true;
+    EXPECT_GT(christoffersen_independence_test(clustered).lr,
+              christoffersen_independence_test(spread).lr);
+    EXPECT_LT(christoffersen_independence_test(clustered).p_value, 0.01);
+}
+
+TEST(BacktestTest, RollingCalibrationMatchesBuildSnapshot) {
+    MarketDataHistory h = random_history(120);
+
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 10);
+    p.add(InstrumentType::STOCK, "BBB", -5);
+
+    BacktestSpec spec;
+    spec.from_date = "2020-02-15";
+    spec.to_date = "2020-04-15";
+    spec.lookback_days = 30;
+    spec.horizon_days = 5;
+    spec.scenarios = 2000;
+    spec.threads = 3;
+
+    BacktestResult bt = run_backtest(p, h, spec);
+    ASSERT_FALSE(bt.rows.empty());
+    EXPECT_EQ(bt.rows.front().date, "2020-02-15");
+
+    // every row must agree with a from-scratch calibration
+    for (std::size_t k = 0; k < bt.rows.size(); k += 7) {
+        const auto& row = bt.rows[k];
+        MarketSnapshot snap = build_snapshot(h, {"AAA", "BBB"}, row.date, spec.lookback_days);
+        MonteCarloEngine mc(snap, p, spec.horizon_days);
+        double var, es;
+        mc.compute(spec.scenarios, spec.confidence, var, es);
+
+        EXPECT_NEAR(row.var, var, 1e-9 * std::abs(var)) << row.date;
+        EXPECT_NEAR(row.es, es, 1e-9 * std::abs(es)) << row.date;
+
+        std::string later = format_date(h.calendar().offset_date(parse_date(row.date), 5));
+        double loss = 10 * (h.get_price("AAA", row.date) - h.get_price("AAA", later))
+                    - 5 * (h.get_price("BBB", row.date) - h.get_price("BBB", later));
+        EXPECT_NEAR(row.realized_loss, loss, 1e-9);
+    }
+}
+
+TEST(BacktestTest, EmptyRangeThrows) {
+    MarketDataHistory h = random_history(50);
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 1);
+
+    BacktestSpec spec;
+    spec.from_date = "2030-01-01";
+    spec.to_date = "2030-12-31";
+    EXPECT_THROW(run_backtest(p, h, spec), std::runtime_error);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "batch_runner.hpp"
+#include "bounded_queue.hpp"
+#include "market_data_history.hpp"
+#include "market_snapshot.hpp"
+#include "monte_carlo.hpp"
+#include "portfolio.hpp"
+#include "trading_day_utils.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <thread>
+
+TEST(BoundedQueueTest, BackpressureAndClose) {
+    BoundedQueue<int> q(2);
+    EXPECT_TRUE(q.push(1));
+    EXPECT_TRUE(q.push(2));
+
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] { q.push(3); pushed = true; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed);                // full: producer waits
+
+    EXPECT_EQ(q.pop().value(), 1);
+    producer.join();
+    EXPECT_TRUE(pushed);
+
+    q.close();
+    EXPECT_FALSE(q.push(4));
+    EXPECT_EQ(q.pop().value(), 2);
+    EXPECT_EQ(q.pop().value(), 3);
+    EXPECT_FALSE(q.pop().has_value());
+}
+
+TEST(BatchRunnerTest, MatchesSequentialRuns) {
+    MarketDataHistory h;
+    std::mt19937_64 rng(9);
+    std::normal_distribution<double> norm(0.0, 0.01);
+    double p[3] = {100.0, 40.0, 75.0};
+    const char* names[3] = {"AAA", "BBB", "CCC"};
+    int date = 20240101;
+    for (int d = 0; d < 160; d++) {
+        date = add_calendar_days(date, 1);
+        for (int i = 0; i < 3; i++) {
+            p[i] *= std::exp(norm(rng));
+            h.prices[names[i]][format_date(date)] = p[i];
+        }
+    }
+    h.rebuild_calendar();
+
+    std::ofstream("batch_a.csv") << "type,ticker,quantity,strike,maturity,option_type\n"
+                                    "STOCK,AAA,10,,,\nSTOCK,BBB,-4,,,\n";
+    std::ofstream("batch_b.csv") << "type,ticker,quantity,strike,maturity,option_type\n"
+                                    "STOCK,CCC,3,,,\nOPTION,AAA,2,100,0.5,CALL\n";
+    std::ofstream("batch_jobs.csv") << "portfolio,date\n"
+                                       "batch_a.csv,2024-04-01\nbatch_b.csv,2024-04-15\n"
+                                       "missing.csv,2024-04-15\nbatch_a.csv,2024-05-20\n"
+                                       "batch_b.csv,2024-05-02\nbatch_a.csv,2024-04-01\n";
+
+    auto jobs = read_batch_jobs("batch_jobs.csv");
+    ASSERT_EQ(jobs.size(), 6u);
+
+    BatchSpec spec;
+    spec.lookback_days = 60;
+    spec.scenarios = 2000;
+    spec.queue_capacity = 1;
+    spec.calibration_threads = 2;
+    spec.simulation_threads = 3;
+    BatchResult res = run_batch(h, jobs, spec, "batch_out.csv");
+
+    ASSERT_EQ(res.rows.size(), 6u);
+    EXPECT_EQ(res.failed, 1u);
+    EXPECT_FALSE(res.rows[2].error.empty());
+
+    for (std::size_t i = 0; i < jobs.size(); i++) {
+        if (i == 2) continue;
+        const BatchRow& row = res.rows[i];
+        ASSERT_TRUE(row.error.empty()) << row.error;
+        EXPECT_EQ(row.index, i);
+
+        Portfolio pf;
+        pf.load(jobs[i].portfolio);
+        const std::vector<std::string>& tickers = pf.tickers;
+        std::string d = format_date(h.calendar().previous_common_date(parse_date(jobs[i].date)));
+        EXPECT_EQ(row.date, d);
+
+        MonteCarloEngine mc(build_snapshot(h, tickers, d, spec.lookback_days), pf, spec.horizon_days);
+        double var, es;
+        mc.compute(spec.scenarios, spec.confidence, var, es);
+        EXPECT_DOUBLE_EQ(row.var, var);
+        EXPECT_DOUBLE_EQ(row.es, es);
+    }
+    EXPECT_DOUBLE_EQ(res.rows[0].var, res.rows[5].var);
+
+    std::ifstream out("batch_out.csv");
+    std::string line;
+    int lines = 0;
+    while (std::getline(out, line)) lines++;
+    EXPECT_EQ(lines, 7);
+}
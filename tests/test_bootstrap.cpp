@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "bootstrap.hpp"
+#include "market_data_history.hpp"
+#include "portfolio.hpp"
+#include "trading_day_utils.hpp"
+#include <cmath>
+
+// AAA alternates +1% / -1% log returns; BBB is flat.
+static MarketDataHistory zigzag_history(int days) {
+    MarketDataHistory h;
+    double a = 100.0;
+    int date = 20240101;
+    for (int d = 0; d < days; d++) {
+        date = add_calendar_days(date, 1);
+        if (d > 0) a *= std::exp(d % 2 ? 0.01 : -0.01);
+        h.prices["AAA"][format_date(date)] = a;
+        h.prices["BBB"][format_date(date)] = 20.0;
+    }
+    h.rebuild_calendar();
+    return h;
+}
+
+TEST(BootstrapTest, ScenariosStayWithinHistoricalRange) {
+    MarketDataHistory h = zigzag_history(100);
+
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 1);
+    p.add(InstrumentType::STOCK, "BBB", 5);
+
+    BootstrapSpec spec;
+    spec.lookback_days = 60;
+    spec.horizon_days = 4;
+    spec.block_length = 2;
+    spec.scenarios = 5000;
+    spec.confidence = 0.99;
+
+    std::string last = h.prices["AAA"].rbegin()->first;
+    BootstrapResult r = compute_bootstrap_var(p, h, last, spec);
+
+    // every 2-day block sums to 0, so a 4-day horizon never moves AAA
+    EXPECT_NEAR(r.var, 0.0, 1e-9);
+    EXPECT_EQ(r.history_days, 60u);
+    EXPECT_NEAR(r.portfolio_value, h.prices["AAA"].rbegin()->second + 100.0, 1e-12);
+
+    // odd blocks can end on a -1% day: worst case is one -1% move
+    spec.block_length = 1;
+    spec.horizon_days = 1;
+    BootstrapResult r1 = compute_bootstrap_var(p, h, last, spec);
+    double s0 = h.prices["AAA"].rbegin()->second;
+    EXPECT_NEAR(r1.var, s0 * (1.0 - std::exp(-0.01)), 1e-9);
+}
+
+TEST(BootstrapTest, DeterministicAcrossThreadCounts) {
+    MarketDataHistory h = zigzag_history(80);
+    h.prices["AAA"]["2024-02-10"] *= 0.9;
+
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 10);
+
+    BootstrapSpec spec;
+    spec.lookback_days = 60;
+    spec.scenarios = 3000;
+    spec.filtered = true;
+
+    spec.threads = 1;
+    BootstrapResult a = compute_bootstrap_var(p, h, "2024-03-20", spec);
+    spec.threads = 4;
+    BootstrapResult b = compute_bootstrap_var(p, h, "2024-03-20", spec);
+
+    EXPECT_DOUBLE_EQ(a.var, b.var);
+    EXPECT_DOUBLE_EQ(a.es, b.es);
+    EXPECT_GT(a.es, 0.0);
+}
+
+TEST(BootstrapTest, TooShortWindowThrows) {
+    MarketDataHistory h = zigzag_history(5);
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 1);
+
+    BootstrapSpec spec;
+    spec.block_length = 10;
+    EXPECT_THROW(compute_bootstrap_var(p, h, "2024-01-06", spec), std::runtime_error);
+}
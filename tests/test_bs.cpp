@@ -7,7 +7,7 @@ TEST(BlackScholesTest, ATMCall) {
 
     Instrument inst;
     inst.type = InstrumentType::OPTION;
-    inst.option_type = "CALL";
+    inst.option_type = OptionType::CALL;
     inst.strike = 100;
 
     PricingContext ctx{100, 0.2, 0.0, 1.0};
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "trading_calendar.hpp"
+#include "trading_day_utils.hpp"
+#include "market_data_history.hpp"
+
+static TradingCalendar::PriceStore sample_store() {
+    TradingCalendar::PriceStore p;
+    p["AAA"] = {{"2025-01-02", 1}, {"2025-01-03", 1}, {"2025-01-06", 1}, {"2025-01-07", 1}};
+    p["BBB"] = {{"2025-01-02", 1}, {"2025-01-06", 1}, {"2025-01-07", 1}, {"2025-01-08", 1}};
+    return p;
+}
+
+TEST(CalendarTest, UnionCommonAndAvailability) {
+    TradingCalendar cal;
+    cal.build(sample_store());
+
+    EXPECT_EQ(cal.union_dates(), (std::vector<int>{20250102, 20250103, 20250106, 20250107, 20250108}));
+    EXPECT_EQ(cal.common_dates(), (std::vector<int>{20250102, 20250106, 20250107}));
+
+    int b = cal.ticker_index("BBB");
+    ASSERT_GE(b, 0);
+    EXPECT_FALSE(cal.available(b, 1));
+    EXPECT_TRUE(cal.available(b, 4));
+    EXPECT_EQ(cal.ticker_index("XXX"), -1);
+    EXPECT_EQ(cal.union_index(20250104), -1);
+}
+
+TEST(CalendarTest, MatchesSetIntersection) {
+    TradingCalendar::PriceStore p = sample_store();
+    TradingCalendar cal;
+    cal.build(p);
+
+    std::unordered_map<std::string, std::vector<std::string>> dates;
+    for (const auto& [t, series] : p)
+        for (const auto& [d, _] : series) dates[t].push_back(d);
+
+    for (int target : {20250102, 20250103, 20250105, 20250106, 20250110}) {
+        EXPECT_EQ(format_date(cal.previous_common_date(target)),
+                  find_common_previous_date(dates, format_date(target)));
+    }
+    EXPECT_THROW(cal.previous_common_date(20250101), std::runtime_error);
+}
+
+TEST(CalendarTest, WindowsAndOffsets) {
+    TradingCalendar cal;
+    cal.build(sample_store());
+
+    EXPECT_EQ(cal.past_dates(20250107, 5), (std::vector<int>{20250106, 20250102}));
+    EXPECT_EQ(cal.future_dates(20250102, 1), (std::vector<int>{20250106}));
+    EXPECT_EQ(cal.offset_date(20250103, 1), 20250106);   // aligned to 01-02 first
+    EXPECT_EQ(cal.offset_date(20250107, -2), 20250102);
+    EXPECT_EQ(cal.offset_date(20250107, 1), -1);
+}
+
+TEST(CalendarTest, ExtendMatchesRebuild) {
+    TradingCalendar::PriceStore p = sample_store();
+    TradingCalendar cal;
+    cal.build(p);
+
+    p["AAA"]["2025-01-08"] = 2;
+    p["AAA"]["2025-01-09"] = 2;
+    p["BBB"]["2025-01-09"] = 2;
+    cal.extend(p, {"AAA", "BBB"});
+
+    TradingCalendar fresh;
+    fresh.build(p);
+
+    EXPECT_TRUE(cal.matches(p));
+    EXPECT_EQ(cal.union_dates(), fresh.union_dates());
+    EXPECT_EQ(cal.common_dates(), fresh.common_dates());
+    EXPECT_EQ(cal.common_dates().back(), 20250109);
+}
+
+TEST(CalendarTest, HistoryRequiresRebuildAfterDirectEdits) {
+    MarketDataHistory h;
+    h.prices["AAA"] = {{"2025-01-01", 1}, {"2025-01-02", 2}, {"2025-01-03", 3}};
+    EXPECT_THROW(h.get_past_dates("2025-01-03", 10), std::runtime_error);
+
+    h.rebuild_calendar();
+    EXPECT_EQ(h.get_past_dates("2025-01-03", 10),
+              (std::vector<std::string>{"2025-01-02", "2025-01-01"}));
+
+    // moving a date keeps the counts: only an explicit rebuild sees it
+    h.prices["AAA"].erase("2025-01-02");
+    h.prices["AAA"]["2025-01-06"] = 4;
+    h.rebuild_calendar();
+    EXPECT_EQ(h.get_past_dates("2025-01-06", 10),
+              (std::vector<std::string>{"2025-01-03", "2025-01-01"}));
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "portfolio_compression.hpp"
+#include "revaluation.hpp"
+
+static void option(Portfolio& p, const std::string& t, int q, double k, OptionType ot, double m = 0.5) {
+    Instrument& inst = p.add(InstrumentType::OPTION, t, q);
+    inst.strike = k;
+    inst.maturity = m;
+    inst.option_type = ot;
+}
+
+TEST(CompressionTest, NetsIdenticalExposures) {
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 10);             // 0
+    option(p, "AAA", 2, 100, OptionType::CALL);          // 1
+    p.add(InstrumentType::STOCK, "BBB", 4);              // 2
+    p.add(InstrumentType::STOCK, "AAA", -3);             // 3
+    option(p, "AAA", 1, 100, OptionType::CALL);          // 4
+    option(p, "AAA", 1, 100, OptionType::PUT);           // 5
+    option(p, "AAA", 1, 100, OptionType::CALL, 1.0);     // 6
+    p.add(InstrumentType::STOCK, "BBB", -4);             // 7
+
+    CompressedPortfolio c = compress_portfolio(p);
+    const auto& net = c.portfolio.instruments;
+
+    ASSERT_EQ(net.size(), 4u);
+    EXPECT_EQ(c.portfolio.ticker(net[0]), "AAA");
+    EXPECT_EQ(net[0].quantity, 7);
+    EXPECT_EQ(net[1].option_type, OptionType::CALL);
+    EXPECT_EQ(net[1].quantity, 3);
+    EXPECT_EQ(net[2].option_type, OptionType::PUT);
+    EXPECT_EQ(net[3].maturity, 1.0);
+
+    std::vector<size_t> expected = {0, 1, CompressedPortfolio::NO_POSITION, 0, 1, 2, 3,
+                                    CompressedPortfolio::NO_POSITION};
+    EXPECT_EQ(c.row_to_position, expected);
+    EXPECT_EQ(c.portfolio.tickers, std::vector<std::string>{"AAA"});
+}
+
+TEST(CompressionTest, RevaluationUnchanged) {
+    Portfolio p;
+    for (int i = 0; i < 50; i++) {
+        p.add(InstrumentType::STOCK, i % 2 ? "AAA" : "BBB", i - 20);
+        option(p, i % 3 ? "AAA" : "BBB", 1 - i % 3,
+               90 + 5 * (i % 4), i % 2 ? OptionType::CALL : OptionType::PUT);
+    }
+
+    std::vector<std::string> tickers = {"AAA", "BBB"};
+    PortfolioRevaluer full(compress_portfolio(p).portfolio, tickers, {100.0, 95.0});
+    PortfolioRevaluer r(p, tickers, {100.0, 95.0});
+    EXPECT_LT(r.position_count(), 20u);
+
+    // reference: row-by-row valuation
+    auto value = [&](double a, double b) {
+        double v = 0.0;
+        for (const auto& inst : p.instruments) {
+            double S = p.ticker(inst) == "AAA" ? a : b;
+            if (inst.type == InstrumentType::STOCK) v += inst.quantity * S;
+            else if (inst.option_type == OptionType::CALL) v += inst.quantity * std::max(S - inst.strike, 0.0);
+            else v += inst.quantity * std::max(inst.strike - S, 0.0);
+        }
+        return v;
+    };
+
+    EXPECT_NEAR(r.base_value(), value(100.0, 95.0), 1e-9);
+    for (double a : {80.0, 97.5, 120.0}) {
+        double prices[2] = {a, 101.0};
+        EXPECT_NEAR(r.pnl(prices), value(a, 101.0) - value(100.0, 95.0), 1e-9);
+        EXPECT_DOUBLE_EQ(r.pnl(prices), full.pnl(prices));
+    }
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "counter_rng.hpp"
+#include "monte_carlo.hpp"
+#include "market_snapshot.hpp"
+#include "portfolio.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Known-answer vectors of the Random123 reference implementation.
+TEST(CounterRngTest, PhiloxKnownAnswers) {
+    auto zero = Philox4x32::block({0, 0, 0, 0}, {0, 0});
+    EXPECT_EQ(zero, (Philox4x32::Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+
+    auto ones = Philox4x32::block({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                                  {0xffffffff, 0xffffffff});
+    EXPECT_EQ(ones, (Philox4x32::Counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+
+    auto pi = Philox4x32::block({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                                {0xa4093822, 0x299f31d0});
+    EXPECT_EQ(pi, (Philox4x32::Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+TEST(CounterRngTest, UniformsInOpenIntervalAndPrefixStable) {
+    std::vector<double> a(1001), b(10);
+    fill_uniform(7, 3, a.data(), a.size());
+    fill_uniform(7, 3, b.data(), b.size());
+    for (double u : a) {
+        EXPECT_GT(u, 0.0);
+        EXPECT_LT(u, 1.0);
+    }
+    for (std::size_t i = 0; i < b.size(); i++) EXPECT_EQ(a[i], b[i]);
+
+    // different streams and seeds differ
+    std::vector<double> c(10), d(10);
+    fill_uniform(7, 4, c.data(), c.size());
+    fill_uniform(8, 3, d.data(), d.size());
+    EXPECT_NE(b, c);
+    EXPECT_NE(b, d);
+}
+
+TEST(CounterRngTest, NormalMoments) {
+    std::vector<double> z(200000);
+    fill_normal(42, 0, z.data(), z.size());
+
+    double mean = 0.0, var = 0.0;
+    for (double x : z) mean += x;
+    mean /= z.size();
+    for (double x : z) var += (x - mean) * (x - mean);
+    var /= z.size() - 1;
+
+    EXPECT_NEAR(mean, 0.0, 0.01);
+    EXPECT_NEAR(var, 1.0, 0.01);
+}
+
+TEST(CounterRngTest, BatchMatchesSingleStreams) {
+    for (std::size_t per : {4u, 7u}) {
+        const std::size_t streams = 5;
+        std::vector<double> batch(streams * per), one(per);
+        fill_normal_streams(42, 100, streams, per, batch.data());
+        for (std::size_t k = 0; k < streams; k++) {
+            fill_normal(42, 100 + k, one.data(), per);
+            for (std::size_t i = 0; i < per; i++) EXPECT_EQ(batch[k * per + i], one[i]);
+        }
+    }
+}
+
+TEST(CounterRngTest, EngineRegeneratesScenarios) {
+    MarketSnapshot snap;
+    snap.tickers = {"A", "B", "C"};
+    snap.spot = {{"A", 100.0}, {"B", 50.0}, {"C", 20.0}};
+    snap.mu = {0.0, 0.0, 0.0};
+    snap.sigma = {0.02, 0.03, 0.01};
+    snap.corr = {{1.0, 0.5, 0.2}, {0.5, 1.0, 0.1}, {0.2, 0.1, 1.0}};
+
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "A", 10);
+    p.add(InstrumentType::STOCK, "B", -4);
+    p.add(InstrumentType::STOCK, "C", 7);
+
+    MonteCarloEngine mc(snap, p, 10);
+
+    // with 100 scenarios at 99.9% the VaR is the worst scenario
+    double var, es;
+    mc.compute(100, 0.999, var, es);
+
+    double worst = 0.0;
+    for (std::uint64_t s = 0; s < 100; s++) worst = std::min(worst, mc.scenario_pnl(s));
+    EXPECT_DOUBLE_EQ(var, -worst);
+
+    std::vector<double> prices, shocks;
+    double pnl = mc.scenario_pnl(17, &prices, &shocks);
+    ASSERT_EQ(prices.size(), 3u);
+    ASSERT_EQ(shocks.size(), 3u);
+    EXPECT_NEAR(pnl, 10 * (prices[0] - 100.0) - 4 * (prices[1] - 50.0) + 7 * (prices[2] - 20.0), 1e-9);
+}
+
+TEST(CounterRngTest, BoxMullerMatchesLibm) {
+    const std::size_t n = 20000;
+    std::vector<double> u(n), z(n);
+    fill_uniform(9, 1, u.data(), n);
+    fill_normal(9, 1, z.data(), n);
+
+    const double two_pi = 6.283185307179586476925286766559;
+    for (std::size_t j = 0; j < n / 2; j++) {
+        double r = std::sqrt(-2.0 * std::log(u[2 * j]));
+        double t = two_pi * u[2 * j + 1];
+        ASSERT_NEAR(z[2 * j], r * std::cos(t), 1e-13) << j;
+        ASSERT_NEAR(z[2 * j + 1], r * std::sin(t), 1e-13) << j;
+    }
+}
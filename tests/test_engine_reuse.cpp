@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "monte_carlo.hpp"
+#include "market_snapshot.hpp"
+#include "market_fixtures.hpp"
+#include "portfolio.hpp"
+#include "task_scheduler.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+// Counts heap allocations of every thread while armed.
+static std::atomic<bool> counting{false};
+static std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct AllocationCounter {
+    AllocationCounter() { allocations = 0; counting = true; }
+    ~AllocationCounter() { counting = false; }
+    std::size_t count() const { return allocations.load(); }
+};
+
+MarketSnapshot three_assets(double shift = 0.0) {
+    MarketSnapshot snap = three_asset_snapshot();
+    snap.spot["A"] += shift;
+    return snap;
+}
+
+Portfolio book(int scale = 1) {
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "A", 10 * scale);
+    p.add(InstrumentType::STOCK, "B", -4 * scale);
+    Instrument& opt = p.add(InstrumentType::OPTION, "C", 20 * scale);
+    opt.strike = 21;
+    opt.option_type = OptionType::CALL;
+    return p;
+}
+
+} // namespace
+
+TEST(EngineReuseTest, ReboundEngineMatchesFreshEngine) {
+    MarketSnapshot s1 = three_assets(), s2 = three_assets(5.0);
+    Portfolio p1 = book(), p2 = book(3);
+
+    MonteCarloEngine reused(10);
+    double v, e, v_ref, e_ref;
+    EXPECT_THROW(reused.compute(100, 0.99, v, e), std::runtime_error);
+
+    reused.bind_market(s1);
+    reused.bind_portfolio(p1);
+    reused.compute(5000, 0.99, v, e);
+    MonteCarloEngine(s1, p1, 10).compute(5000, 0.99, v_ref, e_ref);
+    EXPECT_DOUBLE_EQ(v, v_ref);
+    EXPECT_DOUBLE_EQ(e, e_ref);
+
+    // new spots, same tickers: the compiled portfolio is kept
+    reused.bind_market(s2);
+    reused.compute(5000, 0.99, v, e);
+    MonteCarloEngine(s2, p1, 10).compute(5000, 0.99, v_ref, e_ref);
+    EXPECT_NEAR(v, v_ref, 1e-9 * v_ref);
+    EXPECT_NEAR(e, e_ref, 1e-9 * e_ref);
+
+    // new portfolio on an external factor
+    auto factor = cholesky(s2.corr);
+    reused.bind_market(s2, factor);
+    reused.bind_portfolio(p2);
+    reused.compute(5000, 0.99, v, e);
+    MonteCarloEngine(s2, p2, 10).compute(5000, 0.99, v_ref, e_ref);
+    EXPECT_DOUBLE_EQ(v, v_ref);
+    EXPECT_DOUBLE_EQ(e, e_ref);
+}
+
+TEST(EngineReuseTest, SteadyStateComputeDoesNotAllocate) {
+    MarketSnapshot snap = three_assets();
+    Portfolio p = book();
+    MonteCarloEngine mc(snap, p, 10);
+    mc.set_threads(1);
+
+    double v, e;
+    mc.compute(20000, 0.99, v, e);   // warm-up grows the workspace
+    std::size_t bytes = mc.workspace_bytes();
+
+    AllocationCounter counter;
+    for (int i = 0; i < 5; i++) mc.compute(i % 2 ? 20000 : 7000, 0.99, v, e);
+    EXPECT_EQ(counter.count(), 0u);
+    EXPECT_EQ(mc.workspace_bytes(), bytes);
+}
+
+TEST(EngineReuseTest, SteadyStateComputeOnPoolDoesNotAllocate) {
+    MarketSnapshot snap = three_assets();
+    Portfolio p = book();
+    TaskScheduler pool(3);
+    MonteCarloEngine mc(snap, p, 10);
+    mc.set_scheduler(&pool);
+    mc.reserve(30000);
+
+    // every thread of the pool has to run a block once to size its scratch
+    double v, e;
+    auto all_ran = [&] {
+        for (const auto& w : pool.stats().threads) if (w.tasks == 0) return false;
+        return true;
+    };
+    for (int i = 0; i < 500 && !(i >= 2 && all_ran()); i++) mc.compute(30000, 0.99, v, e);
+    if (!all_ran()) GTEST_SKIP() << "a worker never got a block";
+
+    AllocationCounter counter;
+    for (int i = 0; i < 5; i++) mc.compute(30000, 0.99, v, e);
+    EXPECT_EQ(counter.count(), 0u);
+}
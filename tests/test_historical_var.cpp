@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include "historical_var.hpp"
+#include "market_data_history.hpp"
+#include "portfolio.hpp"
+#include "revaluation.hpp"
+#include "risk_measures.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+static MarketDataHistory linear_history() {
+    // AAA: 100, 101, ..., 110 on consecutive days
+    MarketDataHistory h;
+    for (int d = 0; d <= 10; d++) {
+        char buf[11];
+        std::snprintf(buf, sizeof(buf), "2025-01-%02d", d + 1);
+        h.prices["AAA"][buf] = 100.0 + d;
+    }
+    h.rebuild_calendar();
+    return h;
+}
+
+TEST(HistoricalVarTest, OverlappingWindowsMatchBruteForce) {
+    MarketDataHistory h = linear_history();
+    h.prices["AAA"]["2025-01-05"] = 90.0;   // one sharp dip
+
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 10);
+
+    HistoricalVarSpec spec;
+    spec.horizon_days = 2;
+    spec.lookback_days = 8;
+    spec.confidence = 0.8;
+    spec.threads = 2;
+
+    HistoricalVarResult r = compute_historical_var(p, h, "2025-01-11", spec);
+
+    // brute force over the 7 overlapping 2-day returns in the window
+    std::vector<double> px;
+    for (const auto& [d, v] : h.prices["AAA"]) px.push_back(v);
+    double s0 = px.back();
+    std::vector<double> pnl;
+    for (std::size_t j = 2; j + 2 <= 10; j++)
+        pnl.push_back(10 * s0 * (px[j + 2] / px[j] - 1.0));
+    std::sort(pnl.begin(), pnl.end());
+
+    ASSERT_EQ(r.scenarios, pnl.size());
+    int idx = int(0.2 * pnl.size());
+    EXPECT_NEAR(r.var, -pnl[idx], 1e-9);
+    EXPECT_NEAR(r.portfolio_value, 10 * s0, 1e-12);
+    EXPECT_EQ(r.snapshot_date, "2025-01-11");
+}
+
+TEST(HistoricalVarTest, ConfidenceIsAParameter) {
+    MarketDataHistory h = linear_history();
+    h.prices["AAA"]["2025-01-04"] = 95.0;
+    h.prices["AAA"]["2025-01-08"] = 98.0;
+
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 1);
+
+    HistoricalVarSpec spec;
+    spec.horizon_days = 1;
+    spec.lookback_days = 10;
+
+    spec.confidence = 0.5;
+    double var50 = compute_historical_var(p, h, "2025-01-11", spec).var;
+    spec.confidence = 0.99;
+    HistoricalVarResult r99 = compute_historical_var(p, h, "2025-01-11", spec);
+
+    EXPECT_GT(r99.var, var50);
+    EXPECT_GE(r99.es, r99.var);
+}
+
+TEST(HistoricalVarTest, NotEnoughHistoryThrows) {
+    MarketDataHistory h = linear_history();
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 1);
+
+    HistoricalVarSpec spec;
+    spec.horizon_days = 20;
+    EXPECT_THROW(compute_historical_var(p, h, "2025-01-11", spec), std::runtime_error);
+}
+
+TEST(RiskMeasuresTest, TailRiskMatchesSortedDefinition) {
+    std::vector<double> pnl = {5, -3, 2, -10, 7, -1, 0, -6, 4, 1};
+    double var, es;
+    tail_risk(pnl.data(), pnl.size(), 0.75, var, es);
+
+    // sorted: -10 -6 -3 ...; idx = 2
+    EXPECT_DOUBLE_EQ(var, 3.0);
+    EXPECT_DOUBLE_EQ(es, (10.0 + 6.0 + 3.0) / 3.0);
+}
+
+TEST(RevaluationTest, StocksAndOptions) {
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 2);
+    Instrument& put = p.add(InstrumentType::OPTION, "BBB", 3);
+    put.strike = 50;
+    put.option_type = OptionType::PUT;
+
+    PortfolioRevaluer r(p, {"AAA", "BBB"}, {10.0, 55.0});
+    EXPECT_DOUBLE_EQ(r.base_value(), 20.0);
+
+    double prices[] = {12.0, 40.0};
+    EXPECT_DOUBLE_EQ(r.pnl(prices), 4.0 + 30.0);
+}
+
+TEST(RevaluationTest, OptionGridMatchesExactPricing) {
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 5);
+    for (int i = 0; i < 200; i++) {
+        Instrument& opt = p.add(InstrumentType::OPTION, "AAA", (i % 7) - 3);
+        opt.strike = 50.0 + 0.37 * i;
+        opt.maturity = 0.25 * (1 + i % 4);
+        opt.option_type = i % 2 ? OptionType::CALL : OptionType::PUT;
+    }
+    Instrument& lone = p.add(InstrumentType::OPTION, "BBB", 2);
+    lone.strike = 40;
+    lone.option_type = OptionType::CALL;
+
+    PortfolioRevaluer exact(p, {"AAA", "BBB"}, {100.0, 42.0});
+    PortfolioRevaluer grid(p, {"AAA", "BBB"}, {100.0, 42.0});
+    double err = grid.enable_option_grid();
+
+    EXPECT_EQ(grid.grid_count(), 1u);   // BBB has a single option
+    EXPECT_EQ(grid.position_count(), 2u);
+    EXPECT_LT(err, 1e-6);
+
+    for (int s = 0; s <= 400; s++) {
+        double prices[2] = {30.0 + 0.3 * s, 35.0 + 0.02 * s};
+        EXPECT_NEAR(grid.pnl(prices), exact.pnl(prices), 1e-6) << prices[0];
+    }
+}
+
+TEST(TailRiskTest, CandidatesMatchFullSet) {
+    std::mt19937_64 rng(5);
+    std::normal_distribution<double> norm(0.0, 100.0);
+    std::vector<double> pnl(5000);
+    for (auto& x : pnl) x = norm(rng);
+
+    // worst tail_count() values of each 1000-block, padded with +inf
+    const std::size_t k = tail_count(pnl.size(), 0.99);
+    std::vector<double> cand;
+    for (std::size_t b = 0; b < pnl.size(); b += 1000) {
+        std::vector<double> block(pnl.begin() + b, pnl.begin() + b + 1000);
+        std::sort(block.begin(), block.end());
+        cand.insert(cand.end(), block.begin(), block.begin() + k);
+    }
+    cand.push_back(std::numeric_limits<double>::infinity());
+
+    double var1, es1, var2, es2;
+    std::vector<double> work = pnl;
+    tail_risk(work.data(), work.size(), 0.99, var1, es1);
+    tail_risk_candidates(cand.data(), cand.size(), pnl.size(), 0.99, var2, es2);
+
+    EXPECT_DOUBLE_EQ(var1, var2);
+    EXPECT_NEAR(es1, es2, 1e-9);
+    EXPECT_EQ(k, 51u);
+}
@@ -1,9 +1,17 @@
 #include <gtest/gtest.h>
 #include "market_data_history.hpp"
+#include "trading_day_utils.hpp"
+#include <filesystem>
 #include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+static const std::string HISTORY_DIR = "history_test";
 
 static void write_history_csv(const std::string& ticker, const std::string& data) {
-    std::ofstream f("data_" + ticker + ".csv");
+    fs::create_directories(HISTORY_DIR);
+    std::ofstream f(HISTORY_DIR + "/" + ticker + ".csv");
     f << "Date,Open,High,Low,Close,Adj Close,Volume\n";
     f << data;
 }
@@ -14,7 +22,7 @@ TEST(HistoryTest, LoadAndQuery) {
         "2025-01-02,1,1,1,110,110,1000\n");
 
     MarketDataHistory h;
-    h.load_directory(".");
+    h.load_directory(HISTORY_DIR);
 
     EXPECT_NEAR(h.get_price("AAPL", "2025-01-01"), 100, 1e-12);
     EXPECT_NEAR(h.get_price("AAPL", "2025-01-02"), 110, 1e-12);
@@ -29,7 +37,243 @@ TEST(HistoryTest, MissingDateThrows) {
     write_history_csv("AAPL", "2025-01-01,1,1,1,100,100,1000\n");
 
     MarketDataHistory h;
-    h.load_directory(".");
+    h.load_directory(HISTORY_DIR);
 
     EXPECT_THROW(h.get_price("AAPL", "2025-01-10"), std::runtime_error);
 }
+
+TEST(HistoryTest, MalformedCloseReportsLine) {
+    fs::remove_all("history_bad");
+    fs::create_directories("history_bad");
+    {
+        std::ofstream f("history_bad/BAD.csv");
+        f << "Date,Open,High,Low,Close,Adj Close,Volume\n"
+             "2025-01-01,1,1,1,100,100,1000\n"
+             "2025-01-02,1,1,1,null,null,null\n";
+    }
+
+    MarketDataHistory h;
+    try {
+        h.load_directory("history_bad");
+        FAIL() << "expected std::runtime_error";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("BAD.csv:3"), std::string::npos);
+    }
+}
+
+// Reference implementation: the original getline/stringstream/stod loader.
+static void load_reference(const std::string& path, MarketDataHistory& h) {
+    for (const auto& entry : fs::directory_iterator(path)) {
+        if (entry.path().extension() != ".csv") continue;
+        std::string ticker = entry.path().stem().string();
+        std::ifstream f(entry.path());
+        std::string line;
+        std::getline(f, line);
+        while (std::getline(f, line)) {
+            std::stringstream ss(line);
+            std::string date, open, high, low, close;
+            std::getline(ss, date, ',');
+            std::getline(ss, open, ',');
+            std::getline(ss, high, ',');
+            std::getline(ss, low, ',');
+            std::getline(ss, close, ',');
+            h.prices[ticker][date] = std::stod(close);
+        }
+    }
+}
+
+TEST(HistoryTest, ParallelLoaderMatchesReferenceOnDjia) {
+    const std::string dir = std::string(RISK_ENGINE_DATA_DIR) + "/history/djia";
+
+    MarketDataHistory expected;
+    load_reference(dir, expected);
+
+    MarketDataHistory h;
+    HistoryLoadStats stats = h.load_directory(dir, 4);
+
+    EXPECT_EQ(stats.files, expected.prices.size());
+    ASSERT_EQ(h.prices.size(), expected.prices.size());
+
+    std::size_t rows = 0;
+    for (const auto& [ticker, series] : expected.prices) {
+        ASSERT_TRUE(h.prices.count(ticker)) << ticker;
+        EXPECT_TRUE(h.prices.at(ticker) == series) << ticker;
+        rows += series.size();
+    }
+    EXPECT_EQ(stats.rows, rows);
+}
+
+TEST(HistoryTest, FilterSelectsTickersAndWindow) {
+    const std::string dir = std::string(RISK_ENGINE_DATA_DIR) + "/history/djia";
+
+    MarketDataHistory full;
+    full.load_directory(dir);
+
+    HistoryFilter filter;
+    filter.tickers = {"AAPL", "MSFT"};
+    filter.from_date = 20240102;
+    filter.to_date = 20240630;
+
+    MarketDataHistory h;
+    HistoryLoadStats stats = h.load_directory(dir, filter);
+
+    ASSERT_EQ(h.prices.size(), 2u);
+    EXPECT_EQ(stats.files, 2u);
+    EXPECT_EQ(stats.files_skipped, full.prices.size() - 2);
+    EXPECT_GT(stats.bytes_skipped, 0u);
+
+    for (const auto& t : {"AAPL", "MSFT"}) {
+        const auto& src = full.prices.at(t);
+        std::map<std::string, double> expected(
+            src.lower_bound("2024-01-02"), src.upper_bound("2024-06-30"));
+        EXPECT_TRUE(h.prices.at(t) == expected) << t;
+    }
+    EXPECT_EQ(stats.rows, h.prices.at("AAPL").size() + h.prices.at("MSFT").size());
+}
+
+TEST(HistoryTest, CalendarDayArithmetic) {
+    EXPECT_EQ(add_calendar_days(20250101, -1), 20241231);
+    EXPECT_EQ(add_calendar_days(20240228, 1), 20240229);
+    EXPECT_EQ(add_calendar_days(20230228, 1), 20230301);
+    EXPECT_EQ(add_calendar_days(20250808, 0), 20250808);
+    EXPECT_EQ(format_date(parse_date("2025-08-08")), "2025-08-08");
+    EXPECT_EQ(parse_date("2025-13-01"), -1);
+}
+
+TEST(HistoryTest, AppendPicksUpNewRowsAndFiles) {
+    const std::string dir = "history_append";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    {
+        std::ofstream f(dir + "/AAA.csv");
+        f << "Date,Open,High,Low,Close,Adj Close,Volume\n"
+             "2025-01-02,1,1,1,10,10,100\n"
+             "2025-01-03,1,1,1,11,11,100\n";
+    }
+
+    MarketDataHistory h;
+    h.load_directory(dir);
+    ASSERT_EQ(h.prices.at("AAA").size(), 2u);
+
+    // nothing changed: nothing is read
+    HistoryLoadStats idle = h.append_directory(dir);
+    EXPECT_EQ(idle.files, 0u);
+
+    {
+        std::ofstream f(dir + "/AAA.csv", std::ios::app);
+        f << "2025-01-06,1,1,1,12,12,100\n"
+             "2025-01-07,1,1,1,13";             // still being written
+        std::ofstream g(dir + "/BBB.csv");
+        g << "Date,Open,High,Low,Close,Adj Close,Volume\n"
+             "2025-01-06,1,1,1,50,50,100\n";
+    }
+
+    HistoryLoadStats upd = h.append_directory(dir);
+    EXPECT_EQ(upd.files, 2u);
+    EXPECT_EQ(upd.rows, 2u);
+    EXPECT_NEAR(h.get_price("AAA", "2025-01-06"), 12, 1e-12);
+    EXPECT_NEAR(h.get_price("BBB", "2025-01-06"), 50, 1e-12);
+    EXPECT_THROW(h.get_price("AAA", "2025-01-07"), std::runtime_error);
+
+    {
+        std::ofstream f(dir + "/AAA.csv", std::ios::app);
+        f << ",13,100\n";
+    }
+
+    HistoryLoadStats done = h.append_directory(dir);
+    EXPECT_EQ(done.rows, 1u);
+    EXPECT_NEAR(h.get_price("AAA", "2025-01-07"), 13, 1e-12);
+    EXPECT_EQ(h.prices.at("AAA").size(), 4u);
+}
+
+TEST(HistoryTest, AppendCompletesRowPartialAtLoad) {
+    const std::string dir = "history_partial";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    {
+        std::ofstream f(dir + "/AAA.csv");
+        f << "Date,Open,High,Low,Close,Adj Close,Volume\n"
+             "2025-01-02,1,1,1,10,10,100\n"
+             "2025-01-03,1,1,1,1";              // still being written
+    }
+
+    MarketDataHistory h;
+    h.load_directory(dir);
+    ASSERT_EQ(h.prices.at("AAA").size(), 1u);
+
+    {
+        std::ofstream f(dir + "/AAA.csv", std::ios::app);
+        f << "1,11,100\n";
+    }
+
+    HistoryLoadStats upd = h.append_directory(dir);
+    EXPECT_EQ(upd.rows, 1u);
+    EXPECT_NEAR(h.get_price("AAA", "2025-01-03"), 11, 1e-12);
+    EXPECT_EQ(h.append_directory(dir).files, 0u);
+}
+
+TEST(HistoryTest, AppendAfterToDateFillsTheGap) {
+    const std::string dir = "history_to_date";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    {
+        std::ofstream f(dir + "/AAA.csv");
+        f << "Date,Open,High,Low,Close,Adj Close,Volume\n"
+             "2025-01-02,1,1,1,10,10,100\n"
+             "2025-01-03,1,1,1,11,11,100\n"
+             "2025-01-06,1,1,1,12,12,100\n";
+    }
+
+    HistoryFilter filter;
+    filter.to_date = 20250102;
+    MarketDataHistory h;
+    h.load_directory(dir, filter);
+    ASSERT_EQ(h.prices.at("AAA").size(), 1u);
+
+    {
+        std::ofstream f(dir + "/AAA.csv", std::ios::app);
+        f << "2025-01-07,1,1,1,13,13,100\n";
+    }
+
+    // rows between to_date and the old end of file are not lost
+    HistoryLoadStats upd = h.append_directory(dir);
+    EXPECT_EQ(upd.rows, 3u);
+    EXPECT_EQ(h.prices.at("AAA").size(), 4u);
+    EXPECT_NEAR(h.get_price("AAA", "2025-01-03"), 11, 1e-12);
+    EXPECT_NEAR(h.get_price("AAA", "2025-01-07"), 13, 1e-12);
+}
+
+TEST(HistoryTest, AppendRereadsRewrittenFile) {
+    const std::string dir = "history_rewrite";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    {
+        std::ofstream f(dir + "/AAA.csv");
+        f << "Date,Open,High,Low,Close,Adj Close,Volume\n"
+             "2025-01-02,1,1,1,10,10,100\n"
+             "2025-01-03,1,1,1,11,11,100\n";
+    }
+
+    MarketDataHistory h;
+    h.load_directory(dir);
+    ASSERT_EQ(h.calendar().union_dates().size(), 2u);
+
+    {
+        std::ofstream f(dir + "/AAA.csv", std::ios::trunc);
+        f << "Date,Close\n";                       // shorter file
+    }
+    {
+        std::ofstream f(dir + "/AAA.csv", std::ios::trunc);
+        f << "Date,Open,High,Low,Close,Adj Close,Volume\n"
+             "2025-01-03,1,1,1,9,9,100\n";
+    }
+
+    HistoryLoadStats upd = h.append_directory(dir);
+    EXPECT_EQ(upd.rows, 1u);
+    EXPECT_NEAR(h.get_price("AAA", "2025-01-03"), 9, 1e-12);
+
+    // 2025-01-02 is gone from the rewritten file, so from the history too
+    EXPECT_THROW(h.get_price("AAA", "2025-01-02"), std::runtime_error);
+    EXPECT_EQ(h.prices.at("AAA").size(), 1u);
+    EXPECT_EQ(h.calendar().union_dates(), (std::vector<int>{20250103}));
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include "history_binary.hpp"
+#include "market_data_history.hpp"
+#include "price_index.hpp"
+#include <cmath>
+#include <fstream>
+#include <memory>
+
+TEST(HistoryBinaryTest, RoundTripWithGaps) {
+    MarketDataHistory h;
+    h.prices["AAA"] = {
+        {"2025-01-02", 10.0},
+        {"2025-01-03", 11.0},
+        {"2025-01-07", 12.5}
+    };
+    h.prices["BB"] = {
+        {"2025-01-06", 20.0},
+        {"2025-01-07", 21.0}
+    };
+
+    write_history_binary(h, "roundtrip.bin");
+
+    HistoryBinaryFile bin;
+    bin.open("roundtrip.bin");
+    ASSERT_EQ(bin.n_dates(), 4u);
+    ASSERT_EQ(bin.n_tickers(), 2u);
+    EXPECT_EQ(bin.ticker_name(0), "AAA");
+    EXPECT_EQ(bin.ticker(0).count, 4u);              // 01-06 is a gap
+    EXPECT_TRUE(std::isnan(bin.column(0)[2]));
+    EXPECT_EQ(bin.ticker(1).first_date, 2u);
+
+    MarketDataHistory loaded;
+    HistoryLoadStats stats = loaded.load_binary("roundtrip.bin");
+
+    EXPECT_EQ(stats.rows, 5u);
+
+    // served from the mapped columns; no string maps are built
+    EXPECT_TRUE(loaded.mapped());
+    EXPECT_TRUE(loaded.prices.empty());
+    EXPECT_EQ(loaded.calendar().union_dates(),
+              (std::vector<int>{20250102, 20250103, 20250106, 20250107}));
+    EXPECT_EQ(loaded.calendar().common_dates(), std::vector<int>{20250107});
+    EXPECT_DOUBLE_EQ(loaded.get_price("AAA", "2025-01-07"), 12.5);
+    EXPECT_THROW(loaded.get_price("AAA", "2025-01-06"), std::runtime_error);   // NaN gap
+    EXPECT_THROW(loaded.get_price("CCC", "2025-01-06"), std::runtime_error);
+    EXPECT_TRUE(loaded.get_all_dates() == h.get_all_dates());
+
+    loaded.materialize_prices();
+    EXPECT_FALSE(loaded.mapped());
+    EXPECT_TRUE(loaded.prices == h.prices);
+}
+
+TEST(HistoryBinaryTest, MatchesCsvOnDjia) {
+    MarketDataHistory csv;
+    csv.load_directory(std::string(RISK_ENGINE_DATA_DIR) + "/history/djia");
+
+    write_history_binary(csv, "djia.bin");
+
+    MarketDataHistory bin;
+    bin.load_binary("djia.bin");
+
+    EXPECT_EQ(bin.calendar().union_dates(), csv.calendar().union_dates());
+    EXPECT_EQ(bin.calendar().common_dates(), csv.calendar().common_dates());
+
+    const std::vector<std::string>& tickers = csv.calendar().tickers();
+    PriceIndex from_csv(csv, tickers), from_bin(bin, tickers);
+    ASSERT_EQ(from_csv.dates(), from_bin.dates());
+    EXPECT_EQ(from_csv.complete_dates(), from_bin.complete_dates());
+    for (std::size_t t = 0; t < tickers.size(); t++) {
+        for (std::size_t k = 0; k < from_csv.dates().size(); k++) {
+            double a = from_csv.price(t, k), b = from_bin.price(t, k);
+            ASSERT_TRUE(a == b || (std::isnan(a) && std::isnan(b))) << tickers[t] << " " << k;
+        }
+    }
+
+    bin.materialize_prices();
+    EXPECT_TRUE(bin.prices == csv.prices);
+}
+
+TEST(HistoryBinaryTest, RejectsForeignFile) {
+    {
+        std::ofstream f("not_history.bin");
+        f << "Date,Open,High,Low,Close,Adj Close,Volume\n"
+             "2025-01-01,1,1,1,100,100,1000\n";
+    }
+
+    MarketDataHistory h;
+    EXPECT_THROW(h.load_binary("not_history.bin"), std::runtime_error);
+    EXPECT_THROW(h.load_binary("missing.bin"), std::runtime_error);
+}
+
+TEST(HistoryBinaryTest, FilteredLoadTouchesOnlyWindow) {
+    MarketDataHistory h;
+    h.prices["AAA"] = {{"2025-01-02", 1.0}, {"2025-01-03", 2.0}, {"2025-01-06", 3.0}};
+    h.prices["BBB"] = {{"2025-01-02", 4.0}, {"2025-01-03", 5.0}};
+    write_history_binary(h, "filtered.bin");
+
+    HistoryFilter filter;
+    filter.tickers = {"AAA"};
+    filter.from_date = 20250103;
+
+    MarketDataHistory loaded;
+    HistoryLoadStats stats = loaded.load_binary("filtered.bin", filter);
+
+    EXPECT_TRUE(loaded.has_ticker("AAA"));
+    EXPECT_FALSE(loaded.has_ticker("BBB"));
+    EXPECT_EQ(loaded.calendar().union_dates(), (std::vector<int>{20250103, 20250106}));
+    EXPECT_THROW(loaded.get_price("AAA", "2025-01-02"), std::runtime_error);
+    EXPECT_EQ(stats.rows, 2u);
+    EXPECT_EQ(stats.files_skipped, 1u);
+    EXPECT_EQ(stats.rows_skipped, 3u); // 2 BBB cells + 1 AAA cell before the window
+
+    loaded.materialize_prices();
+    ASSERT_EQ(loaded.prices.size(), 1u);
+    std::map<std::string, double> expected = {{"2025-01-03", 2.0}, {"2025-01-06", 3.0}};
+    EXPECT_TRUE(loaded.prices.at("AAA") == expected);
+}
+
+TEST(HistoryBinaryTest, PriceIndexReadsMappedColumns) {
+    MarketDataHistory h;
+    h.prices["AAA"] = {{"2025-01-02", 1.0}, {"2025-01-03", 2.0}};
+    h.prices["BBB"] = {{"2025-01-03", 5.0}, {"2025-01-06", 6.0}};
+    write_history_binary(h, "mapped_index.bin");
+
+    // the index outlives the history and keeps the file mapped
+    std::unique_ptr<PriceIndex> both, aaa;
+    {
+        MarketDataHistory loaded;
+        loaded.load_binary("mapped_index.bin");
+        both = std::make_unique<PriceIndex>(loaded, std::vector<std::string>{"BBB", "AAA"});
+
+        HistoryFilter filter;
+        filter.tickers = {"AAA"};
+        MarketDataHistory only_aaa;
+        only_aaa.load_binary("mapped_index.bin", filter);   // 01-06 drops out of the union
+        aaa = std::make_unique<PriceIndex>(only_aaa, std::vector<std::string>{"AAA"});
+    }
+
+    ASSERT_EQ(both->dates(), (std::vector<int>{20250102, 20250103, 20250106}));
+    EXPECT_TRUE(std::isnan(both->price(0, 0)));
+    EXPECT_EQ(both->price(0, 2), 6.0);
+    EXPECT_EQ(both->price(1, 1), 2.0);
+    EXPECT_TRUE(std::isnan(both->price(1, 2)));
+    EXPECT_EQ(both->complete_dates(), std::vector<std::size_t>{1});
+
+    ASSERT_EQ(aaa->dates(), (std::vector<int>{20250102, 20250103}));
+    EXPECT_EQ(aaa->price(0, 0), 1.0);
+    EXPECT_EQ(aaa->price(0, 1), 2.0);
+}
+
+TEST(HistoryBinaryTest, EditingMappedHistoryNeedsRebuild) {
+    MarketDataHistory h;
+    h.prices["AAA"] = {{"2025-01-02", 1.0}, {"2025-01-03", 2.0}};
+    write_history_binary(h, "mapped_edit.bin");
+
+    MarketDataHistory loaded;
+    loaded.load_binary("mapped_edit.bin");
+    loaded.prices["CCC"] = {{"2025-01-03", 7.0}};
+    EXPECT_THROW(loaded.calendar(), std::runtime_error);
+
+    loaded.rebuild_calendar();   // materializes the file under the edit
+    EXPECT_FALSE(loaded.mapped());
+    EXPECT_EQ(loaded.calendar().tickers(), (std::vector<std::string>{"AAA", "CCC"}));
+    EXPECT_EQ(loaded.calendar().common_dates(), std::vector<int>{20250103});
+    EXPECT_DOUBLE_EQ(loaded.get_price("AAA", "2025-01-02"), 1.0);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include "index_builder.hpp"
+#include "djia_builder.hpp"
+#include "market_data_history.hpp"
+#include "price_index.hpp"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+static MarketDataHistory sample_history() {
+    MarketDataHistory h;
+    h.prices["AAA"] = {{"2025-01-02", 100}, {"2025-01-03", 110}, {"2025-01-06", 120}};
+    h.prices["BBB"] = {{"2025-01-02", 50},                       {"2025-01-06", 40}};
+    h.rebuild_calendar();
+    return h;
+}
+
+TEST(IndexBuilderTest, PriceIndexAlignsColumns) {
+    MarketDataHistory h = sample_history();
+    PriceIndex idx(h, {"BBB", "AAA"});
+
+    ASSERT_EQ(idx.dates().size(), 3u);
+    EXPECT_EQ(idx.price(1, 1), 110);
+    EXPECT_TRUE(std::isnan(idx.price(0, 1)));
+    EXPECT_EQ(idx.complete_dates(), (std::vector<std::size_t>{0, 2}));
+    EXPECT_EQ(idx.previous_complete_index(20250105), 0);
+    EXPECT_EQ(idx.previous_complete_index(20250101), -1);
+}
+
+TEST(IndexBuilderTest, WeightingSchemes) {
+    MarketDataHistory h = sample_history();
+
+    IndexPortfolioSpec spec;
+    spec.universe = {"AAA", "BBB"};
+    spec.portfolio_value = 1600;
+
+    auto price = build_index_portfolios(h, spec, {"2025-01-06"});
+    // price weighted: every constituent gets value / sum(prices) shares
+    EXPECT_EQ(price[0].portfolio.instruments[0].quantity, 10);
+    EXPECT_EQ(price[0].portfolio.instruments[1].quantity, 10);
+
+    spec.weighting = WeightingScheme::EQUAL;
+    auto equal = build_index_portfolios(h, spec, {"2025-01-06"});
+    EXPECT_EQ(equal[0].portfolio.instruments[0].quantity, 6);   // 800 / 120
+    EXPECT_EQ(equal[0].portfolio.instruments[1].quantity, 20);  // 800 / 40
+
+    spec.weighting = WeightingScheme::CUSTOM;
+    spec.custom_weights = {{"BBB", 2.0}};
+    auto custom = build_index_portfolios(h, spec, {"2025-01-06"});
+    ASSERT_EQ(custom[0].portfolio.instruments.size(), 1u);
+    EXPECT_EQ(custom[0].portfolio.instruments[0].quantity, 40);
+}
+
+TEST(IndexBuilderTest, ManyDatesAlignToCompleteDays) {
+    MarketDataHistory h = sample_history();
+
+    IndexPortfolioSpec spec;
+    spec.universe = {"AAA", "BBB"};
+    spec.portfolio_value = 1500;
+
+    auto built = build_index_portfolios(h, spec, {"2025-01-02", "2025-01-03", "2025-01-07"}, 2);
+    ASSERT_EQ(built.size(), 3u);
+    EXPECT_EQ(built[0].date, "2025-01-02");
+    EXPECT_EQ(built[1].date, "2025-01-02");   // BBB has no 01-03 close
+    EXPECT_EQ(built[2].date, "2025-01-06");
+    EXPECT_EQ(built[1].requested_date, "2025-01-03");
+
+    EXPECT_THROW(build_index_portfolios(h, spec, {"2024-12-31"}), std::runtime_error);
+    spec.universe.push_back("ZZZ");
+    EXPECT_THROW(build_index_portfolios(h, spec, {"2025-01-06"}), std::runtime_error);
+}
+
+TEST(IndexBuilderTest, DjiaMatchesCommittedPortfolio) {
+    const std::string data = RISK_ENGINE_DATA_DIR;
+
+    MarketDataHistory h;
+    h.load_directory(data + "/history/djia");
+
+    DjiaPortfolioSpec spec;
+    spec.snapshot_date = "2025-08-08";
+    spec.portfolio_value = 10'000'000;
+    spec.output_file = "djia_generated.csv";
+    ASSERT_TRUE(build_djia_portfolio(h, spec));
+
+    std::ifstream a(spec.output_file), b(data + "/portfolio_djia.csv");
+    std::stringstream sa, sb;
+    sa << a.rdbuf();
+    sb << b.rdbuf();
+    EXPECT_EQ(sa.str(), sb.str());
+}
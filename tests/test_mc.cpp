@@ -12,7 +12,7 @@ TEST(MonteCarloTest, BasicSanity) {
     snap.corr = {{1.0}};
 
     Portfolio p;
-    p.instruments.push_back({InstrumentType::STOCK, "AAPL", 10});
+    p.add(InstrumentType::STOCK, "AAPL", 10);
 
     MonteCarloEngine mc(snap, p, 10);
 
@@ -26,7 +26,7 @@ TEST(MonteCarloTest, BasicSanity) {
 TEST(MonteCarloTest, EmptySnapshotThrows) {
     MarketSnapshot snap;
     Portfolio p;
-    p.instruments.push_back({InstrumentType::STOCK, "AAPL", 10});
+    p.add(InstrumentType::STOCK, "AAPL", 10);
 
     EXPECT_THROW({
         MonteCarloEngine mc(snap, p, 10);
@@ -42,14 +42,10 @@ TEST(MonteCarloTest, OptionSupport) {
     snap.corr = {{1.0}};
 
     Portfolio p;
-    Instrument opt;
-    opt.type = InstrumentType::OPTION;
-    opt.ticker = "AAPL";
-    opt.quantity = 1;
+    Instrument& opt = p.add(InstrumentType::OPTION, "AAPL", 1);
     opt.strike = 100;
     opt.maturity = 1.0;
-    opt.option_type = "CALL";
-    p.instruments.push_back(opt);
+    opt.option_type = OptionType::CALL;
 
     MonteCarloEngine mc(snap, p, 10);
 
@@ -59,3 +55,97 @@ TEST(MonteCarloTest, OptionSupport) {
     EXPECT_GE(var, 0.0);
     EXPECT_GE(es, var);
 }
+
+TEST(MonteCarloTest, OptionGridKeepsRisk) {
+    MarketSnapshot snap;
+    snap.tickers = {"AAPL"};
+    snap.spot["AAPL"] = 100;
+    snap.mu = {0.0};
+    snap.sigma = {0.3};
+    snap.corr = {{1.0}};
+
+    Portfolio p;
+    for (int k = 80; k <= 120; k += 5) {
+        Instrument& opt = p.add(InstrumentType::OPTION, "AAPL", k % 2 ? 1 : -2);
+        opt.strike = k;
+        opt.option_type = k < 100 ? OptionType::PUT : OptionType::CALL;
+    }
+
+    MonteCarloEngine exact(snap, p, 10), grid(snap, p, 10);
+    EXPECT_LT(grid.enable_option_grid(), 1e-9);
+
+    double v1, e1, v2, e2;
+    exact.compute(5000, 0.99, v1, e1);
+    grid.compute(5000, 0.99, v2, e2);
+    EXPECT_NEAR(v1, v2, 1e-9);
+    EXPECT_NEAR(e1, e2, 1e-9);
+}
+
+// Three assets: A stock only, B stock + options, C short stock.
+static void incremental_setup(MarketSnapshot& snap, Portfolio& p) {
+    snap.tickers = {"A", "B", "C"};
+    snap.spot = {{"A", 100.0}, {"B", 50.0}, {"C", 20.0}};
+    snap.mu = {0.0, 0.0001, 0.0};
+    snap.sigma = {0.02, 0.03, 0.015};
+    snap.corr = {{1.0, 0.4, 0.2}, {0.4, 1.0, 0.3}, {0.2, 0.3, 1.0}};
+
+    p.add(InstrumentType::STOCK, "A", 10);
+    p.add(InstrumentType::STOCK, "B", 5);
+    p.add(InstrumentType::STOCK, "C", -30);
+    for (double k : {45.0, 55.0}) {
+        Instrument& opt = p.add(InstrumentType::OPTION, "B", -8);
+        opt.strike = k;
+        opt.option_type = k < 50 ? OptionType::PUT : OptionType::CALL;
+    }
+}
+
+TEST(MonteCarloTest, CachedComputeMatchesCompute) {
+    MarketSnapshot snap;
+    Portfolio p;
+    incremental_setup(snap, p);
+
+    MonteCarloEngine plain(snap, p, 10), cached(snap, p, 10);
+    double v1, e1, v2, e2;
+    plain.compute(8000, 0.99, v1, e1);
+    cached.compute_cached(8000, 0.99, v2, e2);
+    EXPECT_NEAR(v1, v2, 1e-9 * v1);
+    EXPECT_NEAR(e1, e2, 1e-9 * e1);
+}
+
+TEST(MonteCarloTest, UpdateSpotsMatchesFreshEngine) {
+    MarketSnapshot snap;
+    Portfolio p;
+    incremental_setup(snap, p);
+
+    MonteCarloEngine mc(snap, p, 10);
+    double var, es;
+    mc.compute_cached(8000, 0.99, var, es);
+
+    // two ticks: a stock-only asset, then the option underlying and C
+    mc.update_spots({{"A", 101.5}}, 0.99, var, es);
+    mc.update_spots({{"B", 47.0}, {"C", 20.4}}, 0.99, var, es);
+
+    MarketSnapshot moved = snap;
+    moved.spot = {{"A", 101.5}, {"B", 47.0}, {"C", 20.4}};
+    MonteCarloEngine fresh(moved, p, 10);
+    double v_ref, e_ref;
+    fresh.compute(8000, 0.99, v_ref, e_ref);
+
+    EXPECT_NEAR(var, v_ref, 1e-9 * v_ref);
+    EXPECT_NEAR(es, e_ref, 1e-9 * e_ref);
+    EXPECT_NEAR(mc.base_value(), fresh.base_value(), 1e-9);
+}
+
+TEST(MonteCarloTest, UpdateSpotsValidates) {
+    MarketSnapshot snap;
+    Portfolio p;
+    incremental_setup(snap, p);
+
+    MonteCarloEngine mc(snap, p, 10);
+    double var, es;
+    EXPECT_THROW(mc.update_spots({{"A", 100.0}}, 0.99, var, es), std::runtime_error);
+
+    mc.compute_cached(1000, 0.99, var, es);
+    EXPECT_THROW(mc.update_spots({{"ZZZ", 1.0}}, 0.99, var, es), std::runtime_error);
+    EXPECT_THROW(mc.update_spots({{"A", 0.0}}, 0.99, var, es), std::runtime_error);
+}
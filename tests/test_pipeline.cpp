@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include "monte_carlo.hpp"
+#include "market_snapshot.hpp"
+#include "market_fixtures.hpp"
+#include "portfolio.hpp"
+#include "spsc_ring.hpp"
+
+#include <thread>
+
+namespace {
+
+Portfolio stock_book() {
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "A", 10);
+    p.add(InstrumentType::STOCK, "B", -4);
+    p.add(InstrumentType::STOCK, "C", 25);
+    return p;
+}
+
+Portfolio option_book() {
+    Portfolio p = stock_book();
+    for (double k : {90.0, 100.0, 110.0}) {
+        Instrument& opt = p.add(InstrumentType::OPTION, "A", 5);
+        opt.strike = k;
+        opt.option_type = k < 100 ? OptionType::PUT : OptionType::CALL;
+    }
+    return p;
+}
+
+void expect_matches_blocks(const Portfolio& pf, const McPipelineSpec& spec, int scenarios) {
+    MarketSnapshot snap = three_asset_snapshot();
+    double v_ref, e_ref, v, e;
+    MonteCarloEngine ref(snap, pf, 10);
+    ref.compute(scenarios, 0.99, v_ref, e_ref);
+
+    MonteCarloEngine mc(snap, pf, 10);
+    mc.set_pipeline(spec);
+    mc.compute(scenarios, 0.99, v, e);
+    EXPECT_DOUBLE_EQ(v, v_ref);
+    EXPECT_NEAR(e, e_ref, 1e-9 * e_ref);
+
+    const McPipelineStats& st = mc.pipeline_stats();
+    EXPECT_GE(st.generator_threads, 1);
+    EXPECT_GE(st.revaluation_threads, 1);
+    EXPECT_GT(st.generate_seconds, 0.0);
+    EXPECT_GT(st.revalue_seconds, 0.0);
+}
+
+} // namespace
+
+TEST(SpscRingTest, FifoAndCapacity) {
+    SpscRing<int> ring(5);
+    EXPECT_EQ(ring.capacity(), 8u);
+    EXPECT_TRUE(ring.empty());
+
+    for (int i = 0; i < 8; i++) EXPECT_TRUE(ring.try_push(i));
+    EXPECT_FALSE(ring.try_push(8));
+
+    int x = -1;
+    for (int i = 0; i < 8; i++) {
+        ASSERT_TRUE(ring.try_pop(x));
+        EXPECT_EQ(x, i);
+    }
+    EXPECT_FALSE(ring.try_pop(x));
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, TwoThreadsTransferInOrder) {
+    SpscRing<int> ring(4);
+    const int count = 100000;
+
+    std::thread producer([&] {
+        for (int i = 0; i < count; i++)
+            while (!ring.try_push(i)) std::this_thread::yield();
+    });
+
+    bool ordered = true;
+    for (int expected = 0; expected < count; expected++) {
+        int x;
+        while (!ring.try_pop(x)) std::this_thread::yield();
+        if (x != expected) ordered = false;
+    }
+    producer.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(PipelineTest, StockBookMatchesBlockCompute) {
+    McPipelineSpec spec;
+    spec.enabled = true;
+    spec.generator_threads = 2;
+    spec.revaluation_threads = 3;
+    spec.chunk_scenarios = 100;   // chunk edges off the shock batches
+    expect_matches_blocks(stock_book(), spec, 20011);
+}
+
+TEST(PipelineTest, OptionBookMatchesBlockCompute) {
+    McPipelineSpec spec;
+    spec.enabled = true;
+    spec.generator_threads = 1;
+    spec.revaluation_threads = 2;
+    spec.ring_capacity = 2;
+    expect_matches_blocks(option_book(), spec, 10000);
+}
+
+TEST(PipelineTest, AutoTunedStagesMatchBlockCompute) {
+    McPipelineSpec spec;
+    spec.enabled = true;
+    spec.total_threads = 4;
+    expect_matches_blocks(option_book(), spec, 10000);
+
+    MonteCarloEngine mc(three_asset_snapshot(), option_book(), 10);
+    mc.set_pipeline(spec);
+    double v, e;
+    mc.compute(10000, 0.99, v, e);
+    const McPipelineStats& st = mc.pipeline_stats();
+    EXPECT_EQ(st.generator_threads + st.revaluation_threads, 4);
+    EXPECT_GT(st.probe_generate_us, 0.0);
+    EXPECT_GT(st.probe_revalue_us, 0.0);
+}
+
+TEST(PipelineTest, FewScenariosUseFewerThreads) {
+    McPipelineSpec spec;
+    spec.enabled = true;
+    spec.generator_threads = 4;
+    spec.revaluation_threads = 4;
+    expect_matches_blocks(stock_book(), spec, 300);
+
+    MonteCarloEngine mc(three_asset_snapshot(), stock_book(), 10);
+    mc.set_pipeline(spec);
+    double v, e;
+    mc.compute(300, 0.99, v, e);
+    EXPECT_EQ(mc.pipeline_stats().generator_threads, 2);
+    EXPECT_EQ(mc.pipeline_stats().revaluation_threads, 2);
+}
@@ -27,14 +27,14 @@ TEST(PortfolioTest, LoadValidPortfolio) {
     ASSERT_EQ(p.instruments.size(), 2);
 
     EXPECT_EQ(p.instruments[0].type, InstrumentType::STOCK);
-    EXPECT_EQ(p.instruments[0].ticker, "AAPL");
+    EXPECT_EQ(p.ticker(p.instruments[0]), "AAPL");
     EXPECT_EQ(p.instruments[0].quantity, 10);
 
     EXPECT_EQ(p.instruments[1].type, InstrumentType::OPTION);
-    EXPECT_EQ(p.instruments[1].ticker, "MSFT");
+    EXPECT_EQ(p.ticker(p.instruments[1]), "MSFT");
     EXPECT_EQ(p.instruments[1].strike, 300);
     EXPECT_EQ(p.instruments[1].maturity, 0.5);
-    EXPECT_EQ(p.instruments[1].option_type, "CALL");
+    EXPECT_EQ(p.instruments[1].option_type, OptionType::CALL);
 }
 
 TEST(PortfolioTest, UnknownInstrumentType) {
@@ -48,3 +48,105 @@ TEST(PortfolioTest, UnknownInstrumentType) {
 
     EXPECT_THROW(p.load(path), std::runtime_error);
 }
+
+TEST(PortfolioTest, NumberGrammar) {
+    Portfolio p;
+    p.load_from_string(
+        "type,ticker,quantity,strike,maturity,option_type\n"
+        "STOCK,AAPL,+10,,,\n"
+        "STOCK,MSFT,100.0,,,\n"
+        "OPTION,AAPL,-2.0,+150.5,+0.25,PUT\n");
+
+    ASSERT_EQ(p.instruments.size(), 3u);
+    EXPECT_EQ(p.instruments[0].quantity, 10);
+    EXPECT_EQ(p.instruments[1].quantity, 100);
+    EXPECT_EQ(p.instruments[2].quantity, -2);
+    EXPECT_EQ(p.instruments[2].strike, 150.5);
+    EXPECT_EQ(p.instruments[2].maturity, 0.25);
+    EXPECT_EQ(p.tickers, (std::vector<std::string>{"AAPL", "MSFT"}));
+
+    // fractional quantities are rejected instead of truncated
+    for (const char* q : {"100.5", "+-1", "1e10", "12abc"}) {
+        std::string row = std::string("type,ticker,quantity,strike,maturity,option_type\nSTOCK,AAPL,")
+                        + q + ",,,\n";
+        EXPECT_THROW(p.load_from_string(row), std::runtime_error) << q;
+    }
+}
+
+TEST(PortfolioTest, ErrorsReportLineNumbers) {
+    std::string csv =
+        "type,ticker,quantity,strike,maturity,option_type\n"
+        "STOCK,AAPL,10,,,\n"
+        "\n"
+        "OPTION,MSFT,5,300,0.5,STRADDLE\n";
+
+    std::string path = write_temp_csv("p_badline.csv", csv);
+
+    Portfolio p;
+    try {
+        p.load(path);
+        FAIL() << "expected a parse error";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("p_badline.csv:4:"), std::string::npos) << e.what();
+    }
+}
+
+TEST(PortfolioTest, ChunkedLoadMatchesFileOrder) {
+    // large enough to be split into several parse chunks
+    const int rows = 120000;
+    std::string csv = "type,ticker,quantity,strike,maturity,option_type\r\n";
+    for (int i = 0; i < rows; i++) {
+        std::string t = "T" + std::to_string(i % 37);
+        if (i % 3 == 0)
+            csv += "OPTION," + t + "," + std::to_string(i) + ",101.5,0.25," + (i % 2 ? "PUT" : "CALL") + "\r\n";
+        else
+            csv += "STOCK," + t + "," + std::to_string(i) + ",,,\r\n";
+    }
+    std::string path = write_temp_csv("p_chunked.csv", csv);
+
+    Portfolio p;
+    p.load(path, 4);
+
+    ASSERT_EQ(p.instruments.size(), (size_t)rows);
+    ASSERT_EQ(p.tickers.size(), 37u);
+    for (int i = 0; i < rows; i++) {
+        const auto& inst = p.instruments[i];
+        ASSERT_EQ(inst.quantity, i);
+        ASSERT_EQ(p.ticker(inst), "T" + std::to_string(i % 37));
+        if (i % 3 == 0) {
+            ASSERT_EQ(inst.option_type, i % 2 ? OptionType::PUT : OptionType::CALL);
+            ASSERT_DOUBLE_EQ(inst.strike, 101.5);
+        }
+    }
+
+    // a bad row deep in the file is reported with its absolute line
+    std::string bad = csv + "STOCK,ZZZ,notanumber,,,\n";
+    write_temp_csv("p_chunked_bad.csv", bad);
+    try {
+        p.load("p_chunked_bad.csv", 4);
+        FAIL() << "expected a parse error";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find(":" + std::to_string(rows + 2) + ": invalid quantity"),
+                  std::string::npos) << e.what();
+    }
+}
+
+TEST(PortfolioTest, SaveRoundTripsExactly) {
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAPL", 12);
+    Instrument& opt = p.add(InstrumentType::OPTION, "MSFT", -3);
+    opt.strike = 412.3456789012345;
+    opt.maturity = 1.0 / 3.0;
+    opt.option_type = OptionType::PUT;
+
+    std::string path = write_temp_csv("p_saved.csv", "");
+    p.save(path);
+
+    Portfolio q;
+    q.load(path);
+    ASSERT_EQ(q.instruments.size(), 2u);
+    EXPECT_EQ(q.instruments[0].quantity, 12);
+    EXPECT_EQ(q.instruments[1].strike, opt.strike);
+    EXPECT_EQ(q.instruments[1].maturity, opt.maturity);
+    EXPECT_EQ(q.instruments[1].option_type, OptionType::PUT);
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include "profiler.hpp"
+#include "parallel.hpp"
+#include <fstream>
+#include <sstream>
+
+static std::string read_file(const std::string& path) {
+    std::ifstream f(path);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+TEST(ProfilerTest, DisabledRecordsNothing) {
+    profiler::reset();
+    profiler::set_enabled(false);
+    {
+        PROFILE_SCOPE("idle");
+        PROFILE_COUNT("idle.rows", 5);
+    }
+    profiler::write_report("profile_disabled.json");
+    std::string json = read_file("profile_disabled.json");
+    EXPECT_EQ(json.find("idle"), std::string::npos);
+}
+
+#ifdef RISK_ENGINE_PROFILING
+TEST(ProfilerTest, StagesCountersAndThreads) {
+    profiler::reset();
+    profiler::set_enabled(true);
+
+    for (int i = 0; i < 3; i++) {
+        PROFILE_SCOPE("stage.a");
+        PROFILE_COUNT("rows", 10);
+    }
+    parallel_for(8, 2, [](std::size_t) {});
+
+    profiler::set_enabled(false);
+    profiler::write_report("profile_enabled.json");
+    std::string json = read_file("profile_enabled.json");
+
+    EXPECT_NE(json.find("{\"name\": \"stage.a\", \"calls\": 3"), std::string::npos) << json;
+    EXPECT_NE(json.find("\"rows\": 30"), std::string::npos) << json;
+    EXPECT_NE(json.find("\"slot\": 0"), std::string::npos) << json;
+    profiler::reset();
+}
+#endif
@@ -10,9 +10,10 @@ TEST(RealizedRiskTest, BasicCase) {
         {"2025-01-02",  90},
         {"2025-01-03", 110}
     };
+    h.rebuild_calendar();
 
     Portfolio p;
-    p.instruments.push_back({InstrumentType::STOCK, "AAPL", 1});
+    p.add(InstrumentType::STOCK, "AAPL", 1);
 
     RealizedRisk rr = compute_realized_risk(p, h, "2025-01-01", 2);
 
@@ -25,9 +26,10 @@ TEST(RealizedRiskTest, BasicCase) {
 TEST(RealizedRiskTest, NotEnoughDataThrows) {
     MarketDataHistory h;
     h.prices["AAPL"] = {{"2025-01-01", 100}};
+    h.rebuild_calendar();
 
     Portfolio p;
-    p.instruments.push_back({InstrumentType::STOCK, "AAPL", 1});
+    p.add(InstrumentType::STOCK, "AAPL", 1);
 
     EXPECT_THROW(
         compute_realized_risk(p, h, "2025-01-01", 10),
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include "json.hpp"
+#include "market_data_history.hpp"
+#include "risk_server.hpp"
+#include "trading_day_utils.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+TEST(JsonTest, RoundTrip) {
+    JsonValue v = parse_json(R"( {"a": [1, 2.5, -3e2, true, null], "s": "x\"yé\n", "o": {}} )");
+    EXPECT_EQ(v.as_object().size(), 3u);
+    EXPECT_DOUBLE_EQ(v.find("a")->as_array()[2].as_number(), -300.0);
+    EXPECT_TRUE(v.find("a")->as_array()[3].as_bool());
+    EXPECT_EQ(v.get("s", std::string()), "x\"y\xc3\xa9\n");
+    EXPECT_EQ(parse_json(v.dump()).dump(), v.dump());
+    EXPECT_EQ(v.dump(), R"({"a":[1,2.5,-300,true,null],"o":{},"s":"x\"y)" "\xc3\xa9" R"(\n"})");
+
+    EXPECT_THROW(parse_json("{\"a\": }"), std::runtime_error);
+    EXPECT_THROW(parse_json("[1, 2"), std::runtime_error);
+    EXPECT_THROW(parse_json("{} x"), std::runtime_error);
+}
+
+static MarketDataHistory server_history() {
+    MarketDataHistory h;
+    std::mt19937_64 rng(5);
+    std::normal_distribution<double> norm(0.0, 0.01);
+    double a = 100.0, b = 50.0;
+    int date = 20240101;
+    for (int d = 0; d < 200; d++) {
+        date = add_calendar_days(date, 1);
+        double m = norm(rng);
+        a *= std::exp(m + norm(rng));
+        b *= std::exp(0.5 * m + norm(rng));
+        h.prices["AAA"][format_date(date)] = a;
+        h.prices["BBB"][format_date(date)] = b;
+    }
+    h.rebuild_calendar();
+    return h;
+}
+
+static const char* VAR_REQUEST =
+    R"({"id": 1, "date": "2024-07-01", "lookback": 60, "scenarios": 2000,)"
+    R"( "positions": [{"ticker": "AAA", "quantity": 10},)"
+    R"( {"type": "OPTION", "ticker": "BBB", "quantity": 5, "strike": 50, "option_type": "PUT"}]})";
+
+TEST(RiskServerTest, AnswersAndCachesCalibrations) {
+    MarketDataHistory h = server_history();
+    RiskServerConfig cfg;
+    cfg.threads = 2;
+    RiskServer server(h, cfg);
+
+    JsonValue first = parse_json(server.handle(VAR_REQUEST));
+    ASSERT_TRUE(first.find("ok")->as_bool()) << first.dump();
+    EXPECT_EQ(first.get("cache", std::string()), "miss");
+    EXPECT_EQ(first.get("id", 0.0), 1.0);
+    EXPECT_GT(first.get("var", 0.0), 0.0);
+    EXPECT_GE(first.get("es", 0.0), first.get("var", 0.0));
+
+    JsonValue second = parse_json(server.handle(VAR_REQUEST));
+    EXPECT_EQ(second.get("cache", std::string()), "hit");
+    EXPECT_DOUBLE_EQ(second.get("var", 0.0), first.get("var", 0.0));
+    EXPECT_EQ(server.cache_size(), 1u);
+
+    JsonValue hs = parse_json(server.handle(
+        R"({"date": "2024-07-01", "method": "historical", "lookback": 60,)"
+        R"( "portfolio_csv": "type,ticker,quantity,strike,maturity,option_type\nSTOCK,AAA,10,,,\n"})"));
+    ASSERT_TRUE(hs.find("ok")->as_bool()) << hs.dump();
+    EXPECT_GT(hs.get("var", 0.0), 0.0);
+
+    JsonValue bad = parse_json(server.handle(R"({"id": "x", "date": "2024-07-01", "positions": [{"ticker": "ZZZ", "quantity": 1}]})"));
+    EXPECT_FALSE(bad.find("ok")->as_bool());
+    EXPECT_EQ(bad.get("id", std::string()), "x");
+    EXPECT_NE(bad.get("error", std::string()).find("ZZZ"), std::string::npos);
+
+    EXPECT_FALSE(parse_json(server.handle("not json")).find("ok")->as_bool());
+}
+
+TEST(RiskServerTest, ServesStreamsAndSockets) {
+    MarketDataHistory h = server_history();
+    RiskServer server(h);
+
+    std::istringstream in(std::string(VAR_REQUEST) + "\n\n" + VAR_REQUEST + "\n");
+    std::ostringstream out;
+    server.serve_stream(in, out);
+
+    std::istringstream lines(out.str());
+    std::string line;
+    int answered = 0;
+    while (std::getline(lines, line)) {
+        EXPECT_TRUE(parse_json(line).find("ok")->as_bool()) << line;
+        answered++;
+    }
+    EXPECT_EQ(answered, 2);
+
+    std::string path = "/tmp/risk_server_test_" + std::to_string(::getpid()) + ".sock";
+    RiskServer socket_server(h);
+    std::thread serving([&] { socket_server.serve_unix_socket(path); });
+
+    int fd = -1;
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+    for (int attempt = 0; attempt < 200; attempt++) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) break;
+        ::close(fd);
+        fd = -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_GE(fd, 0);
+
+    std::string req = std::string(VAR_REQUEST) + "\n{\"cmd\": \"shutdown\"}\n";
+    ASSERT_EQ(::send(fd, req.data(), req.size(), 0), (ssize_t)req.size());
+
+    std::string reply;
+    char buf[1024];
+    ssize_t got;
+    while ((got = ::recv(fd, buf, sizeof(buf), 0)) > 0) reply.append(buf, got);
+    ::close(fd);
+    serving.join();
+
+    std::istringstream replies(reply);
+    std::getline(replies, line);
+    EXPECT_TRUE(parse_json(line).find("ok")->as_bool()) << line;
+    EXPECT_EQ(socket_server.requests_served(), 2u);
+}
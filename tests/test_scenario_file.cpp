@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include "scenario_file.hpp"
+#include "monte_carlo.hpp"
+#include "market_snapshot.hpp"
+#include "market_fixtures.hpp"
+#include "portfolio.hpp"
+#include "risk_measures.hpp"
+#include "task_scheduler.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+fs::path temp_file(const std::string& name) {
+    return fs::temp_directory_path() / ("mcr_scen_" + name);
+}
+
+Portfolio book() {
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "A", 10);
+    p.add(InstrumentType::STOCK, "B", -4);
+    Instrument& opt = p.add(InstrumentType::OPTION, "A", 8);
+    opt.strike = 101;
+    opt.option_type = OptionType::CALL;
+    return p;
+}
+
+} // namespace
+
+TEST(ScenarioFileTest, GroupsWrittenOutOfOrderReadBackByColumn) {
+    auto path = temp_file("roundtrip.bin");
+    const std::size_t total = 10, rows = 4;   // groups of 4, 4, 2
+    {
+        ScenarioFileWriter w(path.string(), total, rows,
+                             {scenario_column(ScenarioColumnKind::PNL, "pnl"),
+                              scenario_column(ScenarioColumnKind::PRICE, "AAPL", 3)},
+                             10, 42);
+        ASSERT_EQ(w.n_groups(), 3u);
+        EXPECT_EQ(w.rows_in_group(2), 2u);
+
+        std::vector<std::thread> threads;
+        for (std::size_t g : {2u, 0u, 1u}) {
+            threads.emplace_back([&w, g, rows] {
+                std::size_t len = w.rows_in_group(g);
+                std::vector<double> data(2 * len);
+                for (std::size_t k = 0; k < len; k++) {
+                    data[k] = double(g * rows + k);          // pnl = scenario index
+                    data[len + k] = 100.0 + g * rows + k;    // price
+                }
+                w.write_group(g, data.data());
+            });
+        }
+        for (auto& t : threads) t.join();
+        w.close();
+    }
+
+    ScenarioFile f;
+    f.open(path.string());
+    EXPECT_EQ(f.n_scenarios(), total);
+    EXPECT_EQ(f.n_columns(), 2u);
+    EXPECT_EQ(f.group_rows(), rows);
+    EXPECT_EQ(f.horizon_days(), 10);
+    EXPECT_EQ(f.seed(), 42u);
+    EXPECT_EQ(f.column_name(1), "AAPL");
+    EXPECT_EQ(f.column(1).asset, 3u);
+    EXPECT_EQ(f.find_column(ScenarioColumnKind::PNL), 0);
+    EXPECT_EQ(f.find_column(ScenarioColumnKind::PRICE, "AAPL"), 1);
+    EXPECT_EQ(f.find_column(ScenarioColumnKind::BOOK_PNL, "AAPL"), -1);
+
+    auto pnl = f.read_column(0), price = f.read_column(1);
+    for (std::size_t s = 0; s < total; s++) {
+        EXPECT_EQ(pnl[s], double(s));
+        EXPECT_EQ(price[s], 100.0 + s);
+    }
+    EXPECT_EQ(f.group_column(2, 1)[1], 109.0);
+
+    fs::remove(path);
+}
+
+TEST(ScenarioFileTest, RejectsForeignAndTruncatedFiles) {
+    auto path = temp_file("bad.bin");
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << std::string(200, 'x');
+    }
+    ScenarioFile f;
+    EXPECT_THROW(f.open(path.string()), std::runtime_error);
+
+    {
+        // destroyed without close(): the run did not finish
+        ScenarioFileWriter w(path.string(), 8, 8, {scenario_column(ScenarioColumnKind::PNL, "pnl")});
+        std::vector<double> data(8, 1.0);
+        w.write_group(0, data.data());
+    }
+    EXPECT_THROW(f.open(path.string()), std::runtime_error);
+
+    {
+        ScenarioFileWriter w(path.string(), 8, 8, {scenario_column(ScenarioColumnKind::PNL, "pnl")});
+        std::vector<double> data(8, 1.0);
+        w.write_group(0, data.data());
+        w.close();
+    }
+    f.open(path.string());
+    EXPECT_EQ(f.n_scenarios(), 8u);
+    f = ScenarioFile();
+    fs::resize_file(path, fs::file_size(path) - 8);
+    EXPECT_THROW(f.open(path.string()), std::runtime_error);
+    EXPECT_THROW(f.open(temp_file("missing.bin").string()), std::runtime_error);
+    EXPECT_THROW(scenario_column(ScenarioColumnKind::PRICE, std::string(30, 'T')),
+                 std::runtime_error);
+
+    fs::remove(path);
+}
+
+TEST(ScenarioFileTest, EngineWritesEveryScenario) {
+    auto path = temp_file("engine.bin");
+    MarketSnapshot snap = three_asset_snapshot();
+    Portfolio p = book();
+    TaskScheduler pool(3);
+    const int scenarios = 5000;   // last block is short
+
+    MonteCarloEngine mc(snap, p, 10);
+    mc.set_scheduler(&pool);
+    mc.set_scenario_output({path.string(), true, true});
+    double v, e;
+    mc.compute(scenarios, 0.99, v, e);
+
+    ScenarioFile f;
+    f.open(path.string());
+    ASSERT_EQ(f.n_scenarios(), std::size_t(scenarios));
+    ASSERT_EQ(f.n_columns(), 7u);   // pnl + 3 prices + 3 books
+    EXPECT_EQ(f.horizon_days(), 10);
+
+    auto pnl = f.read_column(0);
+    auto sorted = pnl;   // tail_risk() reorders its input
+    double v_file, e_file;
+    tail_risk(sorted.data(), sorted.size(), 0.99, v_file, e_file);
+    EXPECT_DOUBLE_EQ(v_file, v);
+    EXPECT_NEAR(e_file, e, 1e-9 * e);
+
+    std::vector<std::vector<double>> prices, books;
+    for (const char* t : {"A", "B", "C"}) {
+        prices.push_back(f.read_column(f.find_column(ScenarioColumnKind::PRICE, t)));
+        books.push_back(f.read_column(f.find_column(ScenarioColumnKind::BOOK_PNL, t)));
+    }
+    for (std::size_t s : {std::size_t(0), std::size_t(1023), std::size_t(1024), std::size_t(4999)}) {
+        std::vector<double> expected;
+        EXPECT_DOUBLE_EQ(mc.scenario_pnl(s, &expected), pnl[s]);
+        for (int i = 0; i < 3; i++) EXPECT_DOUBLE_EQ(prices[i][s], expected[i]);
+    }
+    for (int s = 0; s < scenarios; s += 97) {
+        double sum = books[0][s] + books[1][s] + books[2][s];
+        EXPECT_NEAR(sum, pnl[s], 1e-9 * (1 + std::abs(pnl[s])));
+    }
+    EXPECT_DOUBLE_EQ(books[2][0], 0.0);   // nothing held on C
+
+    fs::remove(path);
+}
+
+TEST(ScenarioFileTest, PipelinedEngineWritesSameColumns) {
+    auto blocks_path = temp_file("blocks.bin"), pipe_path = temp_file("pipe.bin");
+    MarketSnapshot snap = three_asset_snapshot();
+    Portfolio p = book();
+    double v, e;
+
+    MonteCarloEngine mc(snap, p, 10);
+    mc.set_scenario_output({blocks_path.string(), true, false});
+    mc.compute(3000, 0.99, v, e);
+
+    McPipelineSpec spec;
+    spec.enabled = true;
+    spec.generator_threads = 2;
+    spec.revaluation_threads = 2;
+    mc.set_pipeline(spec);
+    mc.set_scenario_output({pipe_path.string(), true, false});
+    mc.compute(3000, 0.99, v, e);
+
+    ScenarioFile a, b;
+    a.open(blocks_path.string());
+    b.open(pipe_path.string());
+    ASSERT_EQ(a.n_columns(), b.n_columns());
+    EXPECT_NE(a.group_rows(), b.group_rows());
+    for (std::size_t c = 0; c < a.n_columns(); c++) {
+        auto x = a.read_column(c), y = b.read_column(c);
+        ASSERT_EQ(x.size(), y.size());
+        for (std::size_t s = 0; s < x.size(); s++)
+            ASSERT_NEAR(x[s], y[s], 1e-9 * (1 + std::abs(x[s]))) << "column " << c << " scenario " << s;
+    }
+
+    fs::remove(blocks_path);
+    fs::remove(pipe_path);
+}
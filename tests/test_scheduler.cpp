@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include "task_scheduler.hpp"
+#include "parallel.hpp"
+#include "monte_carlo.hpp"
+#include "market_snapshot.hpp"
+#include "market_fixtures.hpp"
+#include "portfolio.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(TaskSchedulerTest, RunsEveryIndexOnce) {
+    TaskScheduler sched(4);
+    std::vector<std::atomic<int>> hits(1000);
+
+    sched.parallel_for(hits.size(), 1, [&](std::size_t i) { hits[i]++; });
+
+    for (const auto& h : hits) EXPECT_EQ(h.load(), 1);
+    EXPECT_EQ(sched.stats().threads.size(), 4u);
+}
+
+TEST(TaskSchedulerTest, NestedLoopsWithSkewedJobs) {
+    TaskScheduler sched(4);
+
+    // one heavy job next to many light ones, each fanning out again
+    std::vector<std::size_t> sizes(16, 4);
+    sizes[0] = 400;
+    std::vector<std::atomic<std::size_t>> done(sizes.size());
+
+    sched.parallel_for(sizes.size(), 1, [&](std::size_t job) {
+        sched.parallel_for(sizes[job], 1, [&](std::size_t) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            done[job]++;
+        });
+    });
+
+    for (std::size_t j = 0; j < sizes.size(); j++) EXPECT_EQ(done[j].load(), sizes[j]);
+
+    WorkerStats total = sched.stats().total();
+    EXPECT_GE(total.tasks, 16u);
+    EXPECT_GT(total.steals, 0u);
+}
+
+TEST(TaskSchedulerTest, PropagatesFirstException) {
+    TaskScheduler sched(3);
+    EXPECT_THROW(sched.parallel_for(100, 1, [](std::size_t i) {
+        if (i == 37) throw std::runtime_error("boom");
+    }), std::runtime_error);
+
+    // the scheduler stays usable afterwards
+    std::atomic<int> n{0};
+    sched.parallel_for(10, 1, [&](std::size_t) { n++; });
+    EXPECT_EQ(n.load(), 10);
+}
+
+TEST(TaskSchedulerTest, SingleThreadRunsInline) {
+    TaskScheduler sched(1);
+    std::thread::id caller = std::this_thread::get_id();
+    sched.parallel_for(8, 1, [&](std::size_t) {
+        EXPECT_EQ(std::this_thread::get_id(), caller);
+    });
+    EXPECT_EQ(sched.concurrency(), 1u);
+}
+
+TEST(TaskSchedulerTest, ResetStatsClearsCounters) {
+    TaskScheduler sched(2);
+    sched.parallel_for(64, 1, [](std::size_t) {});
+    EXPECT_GT(sched.stats().total().tasks, 0u);
+    sched.reset_stats();
+    EXPECT_EQ(sched.stats().total().tasks, 0u);
+}
+
+TEST(TaskSchedulerTest, ParallelForHonoursThreadCount) {
+    for (int threads : {1, 2, 3}) {
+        std::vector<std::atomic<int>> hits(200);
+        std::atomic<int> running{0}, peak{0};
+
+        parallel_for(hits.size(), threads, [&](std::size_t i) {
+            int now = ++running;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            hits[i]++;
+            running--;
+        });
+
+        for (const auto& h : hits) EXPECT_EQ(h.load(), 1);
+        EXPECT_LE(peak.load(), threads);
+    }
+
+    EXPECT_THROW(parallel_for(100, 2, [](std::size_t i) {
+        if (i == 7) throw std::runtime_error("boom");
+    }), std::runtime_error);
+}
+
+TEST(TaskSchedulerTest, MonteCarloIndependentOfThreadCount) {
+    MarketSnapshot snap;
+    snap.tickers = {"A", "B"};
+    snap.spot["A"] = 100.0;
+    snap.spot["B"] = 50.0;
+    snap.mu = {0.0, 0.0};
+    snap.sigma = {0.02, 0.03};
+    snap.corr = {{1.0, 0.5}, {0.5, 1.0}};
+
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "A", 10);
+    p.add(InstrumentType::STOCK, "B", -4);
+
+    MonteCarloEngine serial(snap, p, 10);
+    serial.set_threads(1);
+    MonteCarloEngine pooled(snap, p, 10);
+
+    double var1, es1, var2, es2;
+    serial.compute(5000, 0.99, var1, es1);
+    pooled.compute(5000, 0.99, var2, es2);
+
+    EXPECT_DOUBLE_EQ(var1, var2);
+    EXPECT_DOUBLE_EQ(es1, es2);
+}
+
+TEST(TaskSchedulerTest, TopologyCoversUsableCpus) {
+    NumaTopology topo = NumaTopology::detect();
+    ASSERT_FALSE(topo.nodes.empty());
+    EXPECT_GE(topo.cpu_count(), 1u);
+    for (const auto& node : topo.nodes) EXPECT_FALSE(node.empty());
+}
+
+TEST(TaskSchedulerTest, PinnedPoolRunsAndReportsCpus) {
+    TaskScheduler sched(3, true);
+    std::vector<std::atomic<int>> hits(256);
+    sched.parallel_for(hits.size(), 1, [&](std::size_t i) { hits[i]++; });
+    for (const auto& h : hits) EXPECT_EQ(h.load(), 1);
+
+    SchedulerStats s = sched.stats();
+    ASSERT_EQ(s.threads.size(), 3u);
+    EXPECT_EQ(s.threads[0].cpu, -1);   // the caller is never pinned
+    if (sched.pinned()) {
+        for (std::size_t i = 1; i < s.threads.size(); i++) EXPECT_GE(s.threads[i].cpu, 0);
+    }
+}
+
+TEST(TaskSchedulerTest, MonteCarloSameOnPinnedPool) {
+    MarketSnapshot snap = three_asset_snapshot();
+
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "A", 10);
+    p.add(InstrumentType::STOCK, "B", -4);
+    p.add(InstrumentType::STOCK, "C", 7);
+
+    TaskScheduler pinned(3, true);
+    MonteCarloEngine a(snap, p, 10);
+    a.set_threads(1);
+    MonteCarloEngine b(snap, p, 10);
+    b.set_scheduler(&pinned);
+
+    // 10 blocks with a short last one; the tail spans several blocks
+    double var1, es1, var2, es2;
+    a.compute(9500, 0.9, var1, es1);
+    b.compute(9500, 0.9, var2, es2);
+
+    EXPECT_DOUBLE_EQ(var1, var2);
+    EXPECT_DOUBLE_EQ(es1, es2);
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include "stress.hpp"
+#include "market_data_history.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+fs::path write_temp(const std::string& name, const std::string& text) {
+    fs::path p = fs::temp_directory_path() / ("mcr_stress_" + name);
+    std::ofstream(p) << text;
+    return p;
+}
+
+MarketSnapshot snapshot() {
+    MarketSnapshot snap;
+    snap.tickers = {"AAA", "BBB", "CCC"};
+    snap.spot = {{"AAA", 100.0}, {"BBB", 50.0}, {"CCC", 20.0}};
+    snap.mu = {0.0, 0.0, 0.0};
+    snap.sigma = {0.02, 0.02, 0.02};
+    snap.corr = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    return snap;
+}
+
+Portfolio stocks() {
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "AAA", 10);
+    p.add(InstrumentType::STOCK, "BBB", -20);
+    p.add(InstrumentType::STOCK, "CCC", 5);
+    return p;
+}
+
+} // namespace
+
+TEST(StressTest, ScenarioFilePrecedenceAndOrder) {
+    auto sectors_path = write_temp("sectors.csv", "ticker,sector\nAAA,Tech\nBBB,Tech\nCCC,Energy\n");
+    auto path = write_temp("scenarios.csv",
+        "scenario,target,shock\n"
+        "# ticker beats sector beats '*', whatever the line order\n"
+        "crash,AAA,-0.4\n"
+        "crash,sector:Tech,-0.2\n"
+        "crash,*,-0.1\n"
+        "oil,sector:Energy,0.3\n"
+        "oil,ZZZ,-0.5\n");
+
+    auto sectors = load_sector_map(sectors_path.string());
+    EXPECT_EQ(sectors.at("CCC"), "Energy");
+
+    StressScenarios set = load_stress_scenarios(path.string(), {"AAA", "BBB", "CCC"}, sectors);
+    ASSERT_EQ(set.size(), 2u);
+    EXPECT_EQ(set.names[0], "crash");
+    EXPECT_EQ(set.names[1], "oil");
+    EXPECT_DOUBLE_EQ(set.row(0)[0], -0.4);
+    EXPECT_DOUBLE_EQ(set.row(0)[1], -0.2);
+    EXPECT_DOUBLE_EQ(set.row(0)[2], -0.1);
+    EXPECT_DOUBLE_EQ(set.row(1)[0], 0.0);
+    EXPECT_DOUBLE_EQ(set.row(1)[2], 0.3);
+
+    fs::remove(sectors_path);
+    fs::remove(path);
+}
+
+TEST(StressTest, ScenarioFileErrors) {
+    std::vector<std::string> tickers = {"AAA"};
+    auto bad_shock = write_temp("bad_shock.csv", "s,AAA,-1.0\n");
+    auto bad_number = write_temp("bad_number.csv", "s,AAA,abc\n");
+    auto bad_sector = write_temp("bad_sector.csv", "s,sector:Tech,0.1\n");
+    auto bad_fields = write_temp("bad_fields.csv", "s,AAA\n");
+
+    EXPECT_THROW(load_stress_scenarios(bad_shock.string(), tickers), std::runtime_error);
+    EXPECT_THROW(load_stress_scenarios(bad_number.string(), tickers), std::runtime_error);
+    EXPECT_THROW(load_stress_scenarios(bad_sector.string(), tickers), std::runtime_error);
+    EXPECT_THROW(load_stress_scenarios(bad_fields.string(), tickers), std::runtime_error);
+    EXPECT_THROW(load_stress_scenarios("/nonexistent/stress.csv", tickers), std::runtime_error);
+
+    for (auto& p : {bad_shock, bad_number, bad_sector, bad_fields}) fs::remove(p);
+}
+
+TEST(StressTest, RunRevaluesEveryScenarioAndRanksWorst) {
+    StressEngine engine(stocks(), snapshot());
+    EXPECT_DOUBLE_EQ(engine.base_value(), 10 * 100.0 - 20 * 50.0 + 5 * 20.0);
+
+    // 600 scenarios span several blocks; columns in another order, CCC missing
+    StressScenarios set;
+    set.tickers = {"BBB", "AAA"};
+    for (int s = 0; s < 600; s++) {
+        set.names.push_back("s" + std::to_string(s));
+        set.shocks.push_back(0.001 * (s % 37));         // BBB
+        set.shocks.push_back(-0.001 * (s % 53));        // AAA
+    }
+
+    StressResult res = engine.run(set, 5, 2);
+    ASSERT_EQ(res.pnl.size(), 600u);
+    for (int s = 0; s < 600; s++) {
+        double expected = 10 * 100.0 * (-0.001 * (s % 53)) - 20 * 50.0 * (0.001 * (s % 37));
+        EXPECT_NEAR(res.pnl[s], expected, 1e-9);
+    }
+
+    ASSERT_EQ(res.worst.size(), 5u);
+    for (std::size_t k = 1; k < res.worst.size(); k++)
+        EXPECT_LE(res.pnl[res.worst[k - 1]], res.pnl[res.worst[k]]);
+    double min_pnl = *std::min_element(res.pnl.begin(), res.pnl.end());
+    EXPECT_DOUBLE_EQ(res.pnl[res.worst[0]], min_pnl);
+
+    EXPECT_EQ(engine.run(set, 10000).worst.size(), 600u);
+}
+
+TEST(StressTest, HistoricalWindowsFromMemory) {
+    MarketDataHistory history;
+    const char* days[] = {"2020-03-02", "2020-03-03", "2020-03-04", "2020-03-05",
+                          "2020-03-06", "2020-03-09"};
+    for (int d = 0; d < 6; d++) {
+        history.prices["AAA"][days[d]] = 100.0 + 10 * d;
+        if (d != 2) history.prices["BBB"][days[d]] = 50.0 - d;   // BBB misses 03-04
+    }
+    history.rebuild_calendar();
+
+    StressScenarios set = historical_stress_windows(history, {"AAA", "BBB"},
+                                                    "2020-03-01", "2020-03-08", 2);
+    // common dates in range: 03-02, 03-03, 03-05, 03-06 -> two 2-day windows
+    ASSERT_EQ(set.size(), 2u);
+    EXPECT_EQ(set.names[0], "2020-03-02+2");
+    EXPECT_EQ(set.names[1], "2020-03-03+2");
+    EXPECT_DOUBLE_EQ(set.row(0)[0], 130.0 / 100.0 - 1.0);
+    EXPECT_DOUBLE_EQ(set.row(0)[1], 47.0 / 50.0 - 1.0);
+    EXPECT_DOUBLE_EQ(set.row(1)[0], 140.0 / 110.0 - 1.0);
+
+    EXPECT_THROW(historical_stress_windows(history, {"AAA", "BBB"}, "2020-03-01", "2020-03-03", 2),
+                 std::runtime_error);
+    EXPECT_THROW(historical_stress_windows(history, {"AAA", "XXX"}, "2020-03-01", "2020-03-09", 1),
+                 std::runtime_error);
+
+    // historical and hypothetical sets combine on one column layout
+    StressScenarios hypo;
+    hypo.tickers = {"BBB"};
+    hypo.names = {"bbb_down"};
+    hypo.shocks = {-0.5};
+    set.append(hypo);
+    ASSERT_EQ(set.size(), 3u);
+    EXPECT_DOUBLE_EQ(set.row(2)[0], 0.0);
+    EXPECT_DOUBLE_EQ(set.row(2)[1], -0.5);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include "monte_carlo.hpp"
+#include "market_snapshot.hpp"
+#include "market_fixtures.hpp"
+#include "portfolio.hpp"
+
+#include <stdexcept>
+
+namespace {
+
+MarketSnapshot three_assets(double vol_scale = 1.0, double corr_shift = 0.0) {
+    MarketSnapshot snap = three_asset_snapshot();
+    snap.mu = {0.0005, -0.0002, 0.0};
+    for (double& s : snap.sigma) s *= vol_scale;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            if (i != j) snap.corr[i][j] += corr_shift * (1.0 - snap.corr[i][j]);
+    return snap;
+}
+
+Portfolio book() {
+    Portfolio p;
+    p.add(InstrumentType::STOCK, "A", 10);
+    p.add(InstrumentType::STOCK, "B", 6);
+    Instrument& opt = p.add(InstrumentType::OPTION, "C", -30);
+    opt.strike = 19;
+    opt.option_type = OptionType::PUT;
+    return p;
+}
+
+} // namespace
+
+TEST(SweepTest, CalibratedPointReproducesCompute) {
+    MonteCarloEngine mc(three_assets(), book(), 10);
+    double v, e;
+    mc.compute(20000, 0.99, v, e);
+
+    auto surface = mc.sweep({0.8, 1.0, 1.5}, {0.0, 0.3}, 20000, 0.99);
+    ASSERT_EQ(surface.size(), 6u);
+    EXPECT_EQ(surface[1].vol_scale, 1.0);
+    EXPECT_EQ(surface[1].corr_shift, 0.0);
+    EXPECT_DOUBLE_EQ(surface[1].var, v);
+    EXPECT_NEAR(surface[1].es, e, 1e-9 * e);
+    EXPECT_EQ(surface[3].vol_scale, 0.8);
+    EXPECT_EQ(surface[3].corr_shift, 0.3);
+}
+
+TEST(SweepTest, GridPointsMatchRecalibratedEngines) {
+    MonteCarloEngine mc(three_assets(), book(), 10);
+    auto surface = mc.sweep({0.8, 1.5}, {0.0, 0.4}, 10000, 0.99);
+
+    for (const auto& pt : surface) {
+        MonteCarloEngine ref(three_assets(pt.vol_scale, pt.corr_shift), book(), 10);
+        double v, e;
+        ref.compute(10000, 0.99, v, e);
+        EXPECT_NEAR(pt.var, v, 1e-9 * v) << pt.vol_scale << " " << pt.corr_shift;
+        EXPECT_NEAR(pt.es, e, 1e-9 * e) << pt.vol_scale << " " << pt.corr_shift;
+    }
+}
+
+TEST(SweepTest, CommonNumbersMakeTheSurfaceMonotone) {
+    // a long stock book: with the same draws, more volatility and more
+    // correlation can only widen the loss tail
+    Portfolio longs;
+    longs.add(InstrumentType::STOCK, "A", 10);
+    longs.add(InstrumentType::STOCK, "B", 20);
+    longs.add(InstrumentType::STOCK, "C", 50);
+    MonteCarloEngine mc(three_assets(), longs, 10);
+
+    std::vector<double> vols = {0.8, 0.9, 1.0, 1.1, 1.2, 1.3, 1.4, 1.5};
+    auto surface = mc.sweep(vols, {0.0, 0.5}, 5000, 0.99);
+    for (std::size_t c = 0; c < 2; c++)
+        for (std::size_t k = 1; k < vols.size(); k++)
+            EXPECT_GT(surface[c * vols.size() + k].var, surface[c * vols.size() + k - 1].var);
+    for (std::size_t k = 0; k < vols.size(); k++)
+        EXPECT_GT(surface[vols.size() + k].var, surface[k].var);
+}
+
+TEST(SweepTest, RejectsBadGrids) {
+    MonteCarloEngine mc(three_assets(), book(), 10);
+    EXPECT_THROW(mc.sweep({}, {0.0}, 1000, 0.99), std::runtime_error);
+    EXPECT_THROW(mc.sweep({1.0}, {}, 1000, 0.99), std::runtime_error);
+    EXPECT_THROW(mc.sweep({0.0}, {0.0}, 1000, 0.99), std::runtime_error);
+    EXPECT_THROW(mc.sweep({1.0}, {1.0}, 1000, 0.99), std::runtime_error);
+    EXPECT_THROW(mc.sweep({1.0}, {-0.1}, 1000, 0.99), std::runtime_error);
+    EXPECT_THROW(mc.sweep({1.0}, {0.0}, 0, 0.99), std::runtime_error);
+
+    MonteCarloEngine unbound(10);
+    EXPECT_THROW(unbound.sweep({1.0}, {0.0}, 1000, 0.99), std::runtime_error);
+}